@@ -78,7 +78,7 @@ bool BoundingRegion::containsPoint(glm::vec3 pt) {
 }
 
 // determine if region completely inside
-bool BoundingRegion::containsRegion(BoundingRegion br) {
+bool BoundingRegion::containsRegion(BoundingRegion &br) {
     if (br.type == BoundTypes::AABB) {
         // if br is a box, just has to contain min and max
         return containsPoint(br.min) && containsPoint(br.max);
@@ -112,7 +112,7 @@ bool BoundingRegion::containsRegion(BoundingRegion br) {
 }
 
 // determine if region intersects (partial containment)
-bool BoundingRegion::intersectsWith(BoundingRegion br) {
+bool BoundingRegion::intersectsWith(BoundingRegion &br) {
     // overlap on all axes
 
     if (type == BoundTypes::AABB && br.type == BoundTypes::AABB) {
@@ -169,6 +169,20 @@ bool BoundingRegion::intersectsWith(BoundingRegion br) {
     }
 }
 
+// distance from point to the region (0 if inside)
+float BoundingRegion::distanceToPoint(glm::vec3 pt) {
+    if (type == BoundTypes::AABB) {
+        // box - distance to the nearest point in the box
+        glm::vec3 nearest = glm::clamp(pt, min, max);
+        return glm::length(pt - nearest);
+    }
+    else {
+        // sphere - distance to the center minus the radius
+        float dist = glm::length(pt - center) - radius;
+        return dist > 0.0f ? dist : 0.0f;
+    }
+}
+
 // operator overload
 bool BoundingRegion::operator==(BoundingRegion br) {
     if (type != br.type) {
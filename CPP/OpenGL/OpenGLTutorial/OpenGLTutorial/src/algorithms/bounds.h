@@ -84,10 +84,13 @@ public:
     bool containsPoint(glm::vec3 pt);
 
     // determine if region completely inside
-    bool containsRegion(BoundingRegion br);
+    bool containsRegion(BoundingRegion &br);
 
     // determine if region intersects (partial containment)
-    bool intersectsWith(BoundingRegion br);
+    bool intersectsWith(BoundingRegion &br);
+
+    // distance from point to the region (0 if inside)
+    float distanceToPoint(glm::vec3 pt);
 
     // operator overload
     bool operator==(BoundingRegion br);
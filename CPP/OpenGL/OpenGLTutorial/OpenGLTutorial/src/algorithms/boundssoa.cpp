@@ -0,0 +1,278 @@
+#include "boundssoa.h"
+
+#include <algorithm>
+
+// AVX2 kernel is compiled for x86 and picked at runtime
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define BOUNDSSOA_AVX
+#define BOUNDSSOA_AVX_TARGET
+#include <intrin.h>
+#include <immintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BOUNDSSOA_AVX
+#define BOUNDSSOA_AVX_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#define BOUNDSSOA_WIDTH 8
+
+// determine if the cpu and os support AVX2
+static bool detectAVX2() {
+#if defined(BOUNDSSOA_AVX) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // AVX and OS saves the YMM registers
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(BOUNDSSOA_AVX)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+/*
+    constructor
+*/
+
+// initialize empty with allocator for the arrays
+BoundsSoA::BoundsSoA(PoolAllocator<float> allocator)
+    : data(allocator), count(0), capacity(0) {}
+
+/*
+    modifiers
+*/
+
+// set number of regions (values are undefined until set)
+void BoundsSoA::resize(unsigned int size) {
+    count = size;
+    if (size > capacity) {
+        // round up to a whole number of vectors
+        capacity = (size + BOUNDSSOA_WIDTH - 1) / BOUNDSSOA_WIDTH * BOUNDSSOA_WIDTH;
+        data.resize(NO_FIELDS * capacity);
+    }
+}
+
+// copy values of region into slot idx
+void BoundsSoA::set(unsigned int idx, BoundingRegion& br) {
+    if (br.type == BoundTypes::SPHERE) {
+        array(IS_SPHERE)[idx] = 1.0f;
+        array(CENTER_X)[idx] = br.center.x;
+        array(CENTER_Y)[idx] = br.center.y;
+        array(CENTER_Z)[idx] = br.center.z;
+        array(RADIUS)[idx] = br.radius;
+    }
+    else {
+        // same arithmetic as intersectsWith uses for boxes
+        glm::vec3 center = br.calculateCenter();
+        glm::vec3 half = br.calculateDimensions() / 2.0f;
+
+        array(IS_SPHERE)[idx] = 0.0f;
+        array(CENTER_X)[idx] = center.x;
+        array(CENTER_Y)[idx] = center.y;
+        array(CENTER_Z)[idx] = center.z;
+        array(HALF_X)[idx] = half.x;
+        array(HALF_Y)[idx] = half.y;
+        array(HALF_Z)[idx] = half.z;
+        array(MIN_X)[idx] = br.min.x;
+        array(MIN_Y)[idx] = br.min.y;
+        array(MIN_Z)[idx] = br.min.z;
+        array(MAX_X)[idx] = br.max.x;
+        array(MAX_Y)[idx] = br.max.y;
+        array(MAX_Z)[idx] = br.max.z;
+    }
+}
+
+/*
+    testing methods
+*/
+
+// test region against regions [start, end), results[i - start] is 1 if they overlap
+void BoundsSoA::intersectsWith(BoundingRegion& br, unsigned int start, unsigned int end, unsigned char* results) {
+    static const bool hasAVX2 = detectAVX2();
+
+    if (hasAVX2) {
+        unsigned int tail = intersectsWithAVX(br, start, end, results);
+        intersectsWithScalar(br, tail, end, results + (tail - start));
+    }
+    else {
+        intersectsWithScalar(br, start, end, results);
+    }
+}
+
+/*
+    accessors
+*/
+
+// number of regions
+unsigned int BoundsSoA::size() {
+    return count;
+}
+
+/*
+    private methods
+*/
+
+// get pointer to array of field
+float* BoundsSoA::array(field f) {
+    return data.data() + f * capacity;
+}
+
+// test region against regions [start, end) one at a time
+void BoundsSoA::intersectsWithScalar(BoundingRegion& br, unsigned int start, unsigned int end, unsigned char* results) {
+    float* isSphere = array(IS_SPHERE);
+    float* c[3] = { array(CENTER_X), array(CENTER_Y), array(CENTER_Z) };
+    float* r = array(RADIUS);
+    float* h[3] = { array(HALF_X), array(HALF_Y), array(HALF_Z) };
+    float* mn[3] = { array(MIN_X), array(MIN_Y), array(MIN_Z) };
+    float* mx[3] = { array(MAX_X), array(MAX_Y), array(MAX_Z) };
+
+    bool querySphere = br.type == BoundTypes::SPHERE;
+    glm::vec3 queryCenter = br.calculateCenter();
+    glm::vec3 queryHalf = br.calculateDimensions() / 2.0f;
+
+    for (unsigned int i = start; i < end; i++) {
+        bool ret = true;
+
+        if (isSphere[i] != 0.0f) {
+            if (querySphere) {
+                // both spheres
+                float distSquared = 0.0f;
+                for (int j = 0; j < 3; j++) {
+                    float diff = queryCenter[j] - c[j][i];
+                    distSquared += diff * diff;
+                }
+                float maxMagSquared = br.radius + r[i];
+                maxMagSquared *= maxMagSquared;
+                ret = distSquared <= maxMagSquared;
+            }
+            else {
+                // sphere against query box
+                float distSquared = 0.0f;
+                for (int j = 0; j < 3; j++) {
+                    float closestPt = std::max(br.min[j], std::min(c[j][i], br.max[j]));
+                    distSquared += (closestPt - c[j][i]) * (closestPt - c[j][i]);
+                }
+                ret = distSquared < (r[i] * r[i]);
+            }
+        }
+        else {
+            if (querySphere) {
+                // query sphere against box
+                float distSquared = 0.0f;
+                for (int j = 0; j < 3; j++) {
+                    float closestPt = std::max(mn[j][i], std::min(br.center[j], mx[j][i]));
+                    distSquared += (closestPt - br.center[j]) * (closestPt - br.center[j]);
+                }
+                ret = distSquared < (br.radius * br.radius);
+            }
+            else {
+                // both boxes
+                for (int j = 0; j < 3; j++) {
+                    if (std::abs(queryCenter[j] - c[j][i]) > queryHalf[j] + h[j][i]) {
+                        ret = false;
+                    }
+                }
+            }
+        }
+
+        results[i - start] = ret;
+    }
+}
+
+#ifdef BOUNDSSOA_AVX
+
+// test region against regions [start, end) 8 at a time (returns index where the scalar tail starts)
+BOUNDSSOA_AVX_TARGET
+unsigned int BoundsSoA::intersectsWithAVX(BoundingRegion& br, unsigned int start, unsigned int end, unsigned char* results) {
+    float* isSphere = array(IS_SPHERE);
+    float* c[3] = { array(CENTER_X), array(CENTER_Y), array(CENTER_Z) };
+    float* r = array(RADIUS);
+    float* h[3] = { array(HALF_X), array(HALF_Y), array(HALF_Z) };
+    float* mn[3] = { array(MIN_X), array(MIN_Y), array(MIN_Z) };
+    float* mx[3] = { array(MAX_X), array(MAX_Y), array(MAX_Z) };
+
+    bool querySphere = br.type == BoundTypes::SPHERE;
+    glm::vec3 queryCenter = br.calculateCenter();
+    glm::vec3 queryHalf = br.calculateDimensions() / 2.0f;
+
+    __m256 zero = _mm256_setzero_ps();
+    __m256 signMask = _mm256_set1_ps(-0.0f);
+
+    unsigned int i = start;
+    for (; i + BOUNDSSOA_WIDTH <= end; i += BOUNDSSOA_WIDTH) {
+        __m256 sphereLanes = _mm256_cmp_ps(_mm256_loadu_ps(isSphere + i), zero, _CMP_NEQ_OQ);
+        __m256 sphereHit, boxHit;
+
+        if (querySphere) {
+            __m256 qRadius = _mm256_set1_ps(br.radius);
+
+            // both spheres
+            __m256 distSquared = zero;
+            for (int j = 0; j < 3; j++) {
+                __m256 diff = _mm256_sub_ps(_mm256_set1_ps(queryCenter[j]), _mm256_loadu_ps(c[j] + i));
+                distSquared = _mm256_add_ps(distSquared, _mm256_mul_ps(diff, diff));
+            }
+            __m256 maxMagSquared = _mm256_add_ps(qRadius, _mm256_loadu_ps(r + i));
+            maxMagSquared = _mm256_mul_ps(maxMagSquared, maxMagSquared);
+            sphereHit = _mm256_cmp_ps(distSquared, maxMagSquared, _CMP_LE_OQ);
+
+            // query sphere against boxes
+            distSquared = zero;
+            for (int j = 0; j < 3; j++) {
+                __m256 qc = _mm256_set1_ps(br.center[j]);
+                __m256 closestPt = _mm256_max_ps(_mm256_loadu_ps(mn[j] + i), _mm256_min_ps(qc, _mm256_loadu_ps(mx[j] + i)));
+                __m256 diff = _mm256_sub_ps(closestPt, qc);
+                distSquared = _mm256_add_ps(distSquared, _mm256_mul_ps(diff, diff));
+            }
+            boxHit = _mm256_cmp_ps(distSquared, _mm256_mul_ps(qRadius, qRadius), _CMP_LT_OQ);
+        }
+        else {
+            // spheres against query box
+            __m256 distSquared = zero;
+            for (int j = 0; j < 3; j++) {
+                __m256 sc = _mm256_loadu_ps(c[j] + i);
+                __m256 closestPt = _mm256_max_ps(_mm256_set1_ps(br.min[j]), _mm256_min_ps(sc, _mm256_set1_ps(br.max[j])));
+                __m256 diff = _mm256_sub_ps(closestPt, sc);
+                distSquared = _mm256_add_ps(distSquared, _mm256_mul_ps(diff, diff));
+            }
+            __m256 radius = _mm256_loadu_ps(r + i);
+            sphereHit = _mm256_cmp_ps(distSquared, _mm256_mul_ps(radius, radius), _CMP_LT_OQ);
+
+            // both boxes (no separating axis)
+            boxHit = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int j = 0; j < 3; j++) {
+                __m256 dist = _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_set1_ps(queryCenter[j]), _mm256_loadu_ps(c[j] + i)));
+                __m256 sumHalf = _mm256_add_ps(_mm256_set1_ps(queryHalf[j]), _mm256_loadu_ps(h[j] + i));
+                boxHit = _mm256_and_ps(boxHit, _mm256_cmp_ps(dist, sumHalf, _CMP_NGT_UQ));
+            }
+        }
+
+        // pick result by type of each region
+        int mask = _mm256_movemask_ps(_mm256_blendv_ps(boxHit, sphereHit, sphereLanes));
+        for (int j = 0; j < BOUNDSSOA_WIDTH; j++) {
+            results[i - start + j] = (mask >> j) & 1;
+        }
+    }
+
+    return i;
+}
+
+#else
+
+// test region against regions [start, end) 8 at a time (returns index where the scalar tail starts)
+unsigned int BoundsSoA::intersectsWithAVX(BoundingRegion& br, unsigned int start, unsigned int end, unsigned char* results) {
+    // not available on this target
+    return start;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef BOUNDSSOA_H
+#define BOUNDSSOA_H
+
+#include <vector>
+
+#include "bounds.h"
+#include "nodepool.h"
+
+/*
+    copy of a list of bounding regions in structure of arrays layout
+    - one array per value (center, radius, half dimensions, min, max) so 8 regions load at once
+    - coarse tests against a range run 8 wide with AVX2 if the cpu has it, else one at a time
+    - same results as BoundingRegion::intersectsWith
+*/
+
+class BoundsSoA {
+public:
+    /*
+        constructor
+    */
+
+    // initialize empty with allocator for the arrays
+    BoundsSoA(PoolAllocator<float> allocator = PoolAllocator<float>());
+
+    /*
+        modifiers
+    */
+
+    // set number of regions (values are undefined until set)
+    void resize(unsigned int size);
+
+    // copy values of region into slot idx
+    void set(unsigned int idx, BoundingRegion& br);
+
+    /*
+        testing methods
+    */
+
+    // test region against regions [start, end), results[i - start] is 1 if they overlap
+    void intersectsWith(BoundingRegion& br, unsigned int start, unsigned int end, unsigned char* results);
+
+    /*
+        accessors
+    */
+
+    // number of regions
+    unsigned int size();
+
+private:
+    // indices of each array in the data block
+    enum field {
+        IS_SPHERE,          // 1 if sphere, 0 if box
+        CENTER_X, CENTER_Y, CENTER_Z,
+        RADIUS,             // spheres only
+        HALF_X, HALF_Y, HALF_Z,   // boxes only
+        MIN_X, MIN_Y, MIN_Z,      // boxes only
+        MAX_X, MAX_Y, MAX_Z,      // boxes only
+        NO_FIELDS
+    };
+
+    // all arrays in one block (array f starts at f * capacity)
+    std::vector<float, PoolAllocator<float>> data;
+
+    // number of regions
+    unsigned int count;
+    // number of slots in each array
+    unsigned int capacity;
+
+    // get pointer to array of field
+    float* array(field f);
+
+    // test region against regions [start, end) one at a time
+    void intersectsWithScalar(BoundingRegion& br, unsigned int start, unsigned int end, unsigned char* results);
+
+    // test region against regions [start, end) 8 at a time (returns index where the scalar tail starts)
+    unsigned int intersectsWithAVX(BoundingRegion& br, unsigned int start, unsigned int end, unsigned char* results);
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "broadphase.h"
+#include "octree.h"
+
+#include <algorithm>
+
+// determine if two regions have to be checked (different instances, at least one moved)
+bool Broadphase::needsCheck(BoundingRegion& a, BoundingRegion& b) {
+    if (a.instance == b.instance) {
+        // do not test collisions with the same instance
+        return false;
+    }
+
+    // if neither moved, nothing new to respond to
+    return States::isActive(&a.instance->state, INSTANCE_MOVED) ||
+        States::isActive(&b.instance->state, INSTANCE_MOVED);
+}
+
+// run fine grain check for each pair in the buffer and write the contacts in pair order (moved instances respond)
+void Broadphase::processPairs(std::vector<BroadphasePair>& pairs, std::vector<Contact>& contacts, ThreadPool* threadPool) {
+    contacts.clear();
+    unsigned int noPairs = pairs.size();
+
+    if (!threadPool || noPairs < MIN_PARALLEL_PAIRS) {
+        Contact contact;
+        for (unsigned int i = 0; i < noPairs; i++) {
+            BroadphasePair& p = pairs[i];
+            if (States::isActive(&p.b->instance->state, INSTANCE_MOVED) &&
+                Octree::checkCollisionsFine(*p.a, *p.b, contact)) {
+                contact.pairIdx = i;
+                contacts.push_back(contact);
+            }
+            if (States::isActive(&p.a->instance->state, INSTANCE_MOVED) &&
+                Octree::checkCollisionsFine(*p.b, *p.a, contact)) {
+                contact.pairIdx = i;
+                contacts.push_back(contact);
+            }
+        }
+
+        return;
+    }
+
+    /*
+        parallel fine grain check
+        - world space meshes are transformed up front, so the workers only read the instances
+        - each pair writes into its own two slots, gathered afterwards in pair order (same buffer as the serial check)
+    */
+    for (BroadphasePair& p : pairs) {
+        if (p.a->collisionMesh) {
+            p.a->instance->getWorldMesh(p.a->collisionMesh);
+        }
+        if (p.b->collisionMesh) {
+            p.b->instance->getWorldMesh(p.b->collisionMesh);
+        }
+    }
+
+    std::vector<Contact> slots(2 * noPairs);
+    std::vector<char> found(2 * noPairs, 0);
+    unsigned int noChunks = threadPool->size();
+    unsigned int chunkSize = (noPairs + noChunks - 1) / noChunks;
+
+    TaskCounter counter(0);
+    for (unsigned int start = 0; start < noPairs; start += chunkSize) {
+        unsigned int end = std::min(start + chunkSize, noPairs);
+        threadPool->push([&pairs, &slots, &found, start, end]() -> void {
+            for (unsigned int i = start; i < end; i++) {
+                BroadphasePair& p = pairs[i];
+                if (States::isActive(&p.b->instance->state, INSTANCE_MOVED)) {
+                    found[2 * i] = Octree::checkCollisionsFine(*p.a, *p.b, slots[2 * i]);
+                }
+                if (States::isActive(&p.a->instance->state, INSTANCE_MOVED)) {
+                    found[2 * i + 1] = Octree::checkCollisionsFine(*p.b, *p.a, slots[2 * i + 1]);
+                }
+            }
+        }, &counter);
+    }
+    threadPool->wait(counter);
+
+    for (unsigned int i = 0, len = slots.size(); i < len; i++) {
+        if (found[i]) {
+            slots[i].pairIdx = i / 2;
+            contacts.push_back(slots[i]);
+        }
+    }
+}
+
+// compare regions by their bounds in model space (identifies a region within its model)
+static int compareRegions(const BoundingRegion& a, const BoundingRegion& b) {
+    if (a.type != b.type) {
+        return a.type < b.type ? -1 : 1;
+    }
+
+    float va[6], vb[6];
+    if (a.type == BoundTypes::AABB) {
+        for (int i = 0; i < 3; i++) {
+            va[i] = a.ogMin[i];
+            va[i + 3] = a.ogMax[i];
+            vb[i] = b.ogMin[i];
+            vb[i + 3] = b.ogMax[i];
+        }
+    }
+    else {
+        for (int i = 0; i < 3; i++) {
+            va[i] = a.ogCenter[i];
+            vb[i] = b.ogCenter[i];
+        }
+        va[3] = a.ogRadius;
+        vb[3] = b.ogRadius;
+        va[4] = va[5] = vb[4] = vb[5] = 0.0f;
+    }
+
+    for (int i = 0; i < 6; i++) {
+        if (va[i] != vb[i]) {
+            return va[i] < vb[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// sort contacts by the ids of the instances, then by the regions in model space and the case,
+// so the result does not depend on the tree walk
+void Broadphase::sortContacts(std::vector<Contact>& contacts) {
+    std::stable_sort(contacts.begin(), contacts.end(), [](const Contact& a, const Contact& b) -> bool {
+        int cmp = a.obj->instance->instanceId.compare(b.obj->instance->instanceId);
+        if (cmp != 0) {
+            return cmp < 0;
+        }
+        cmp = a.br->instance->instanceId.compare(b.br->instance->instanceId);
+        if (cmp != 0) {
+            return cmp < 0;
+        }
+
+        // instances with several regions touch in more than one contact
+        cmp = compareRegions(*a.obj, *b.obj);
+        if (cmp != 0) {
+            return cmp < 0;
+        }
+        cmp = compareRegions(*a.br, *b.br);
+        if (cmp != 0) {
+            return cmp < 0;
+        }
+        return a.type < b.type;
+    });
+}
+
+// pass contacts to the responding instances in the order of the buffer
+void Broadphase::resolveContacts(std::vector<Contact>& contacts) {
+    for (Contact& c : contacts) {
+        c.obj->instance->handleCollision(c.br->instance, c.normal);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#define MIN_PARALLEL_PAIRS 64 // minimum pairs in the buffer to run the fine grain checks with worker threads
+
+#include <vector>
+
+#include "bounds.h"
+
+// forward declaration
+class ThreadPool;
+
+/*
+    pair of regions that passed the coarse check
+    - each pair is stored once per frame
+    - at least one of the instances has moved
+*/
+
+struct BroadphasePair {
+    BoundingRegion* a;
+    BoundingRegion* b;
+};
+
+/*
+    contact found by the fine grain check
+    - written to a per frame buffer by the narrow phase, resolved in a separate pass
+    - points to regions in the trees, so it is only valid until the next update or instance removal
+*/
+
+struct Contact {
+    // index of the pair in the broadphase buffer
+    unsigned int pairIdx;
+    // region that was hit
+    BoundingRegion* br;
+    // region of the instance that responds
+    BoundingRegion* obj;
+    // fine grain case (1: mesh/mesh, 2: mesh/sphere, 3: sphere/mesh, 4: sphere/sphere)
+    unsigned char type;
+
+    // direction of the collision (not normalized, sign is not significant)
+    glm::vec3 normal;
+    // penetration depth (0 if the test does not provide it)
+    float depth;
+    // point of contact in world space
+    glm::vec3 point;
+};
+
+/*
+    namespace to tie together the stages between the broad phase and the fine grain check
+*/
+
+namespace Broadphase {
+    // determine if two regions have to be checked (different instances, at least one moved)
+    bool needsCheck(BoundingRegion& a, BoundingRegion& b);
+
+    // run fine grain check for each pair in the buffer and write the contacts in pair order (moved instances respond)
+    // - pairs are split between worker threads if a pool is given and the buffer is large enough
+    void processPairs(std::vector<BroadphasePair>& pairs, std::vector<Contact>& contacts, ThreadPool* threadPool = nullptr);
+
+    // sort contacts by the ids of the instances, then by the regions in model space and the case,
+    // so the result does not depend on the tree walk
+    void sortContacts(std::vector<Contact>& contacts);
+
+    // pass contacts to the responding instances in the order of the buffer
+    void resolveContacts(std::vector<Contact>& contacts);
+}
+
+#endif
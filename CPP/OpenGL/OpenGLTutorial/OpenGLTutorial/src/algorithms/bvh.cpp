@@ -0,0 +1,748 @@
+#include "bvh.h"
+#include "octree.h"
+#include "../graphics/models/box.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_set>
+
+/*
+    utility methods
+*/
+
+// get AABB of a region (box or sphere)
+static void getBounds(BoundingRegion& br, glm::vec3& min, glm::vec3& max) {
+    glm::vec3 center = br.calculateCenter();
+    glm::vec3 halfDimensions = br.calculateDimensions() / 2.0f;
+    min = center - halfDimensions;
+    max = center + halfDimensions;
+}
+
+// get surface area of an AABB
+static float surfaceArea(glm::vec3 min, glm::vec3 max) {
+    glm::vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// add bytes to an FNV-1a hash
+static void hashBytes(unsigned long long& hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+// get bin of a center on an axis
+static int getBin(float center, float binMin, float scale) {
+    int bin = (int)((center - binMin) * scale);
+    return std::min(bin, BVH_BINS - 1);
+}
+
+/*
+    constructor
+*/
+
+// initialize empty (bounds are unused, the hierarchy fits its objects)
+BVH::BVH(BoundingRegion /*bounds*/)
+    : stats(new TreeStats()) {
+    // empty root so traversals need no checks
+    nodes.push_back({ BoundingRegion(glm::vec3(0.0f), glm::vec3(0.0f)), 0, 0 });
+}
+
+// free counters
+BVH::~BVH() {
+    delete stats;
+}
+
+/*
+    functionality
+*/
+
+// add instance to pending queue
+void BVH::addToPending(RigidBody* instance, Model* model) {
+    // get all bounding regions of model and put them in queue
+    for (BoundingRegion br : model->boundingRegions) {
+        br.instance = instance;
+        br.cell = nullptr;
+        br.transform();
+        queue.push_back(br);
+    }
+}
+
+// build tree from all objects (called during initialization and when objects change)
+void BVH::build() {
+    unsigned int noObjects = objects.size();
+    order.resize(noObjects);
+    for (unsigned int i = 0; i < noObjects; i++) {
+        order[i] = i;
+    }
+
+    nodes.clear();
+    nodes.push_back({ BoundingRegion(glm::vec3(0.0f), glm::vec3(0.0f)), 0, 0 });
+    if (noObjects) {
+        buildNode(0, 0, noObjects);
+    }
+    builtArea = surfaceArea(nodes[0].region.min, nodes[0].region.max);
+
+    // set state variables
+    treeBuilt = true;
+    treeReady = true;
+}
+
+// update objects in tree (called during each iteration of main loop)
+void BVH::update(Box& box) {
+    if (treeBuilt && treeReady) {
+        // remove objects that don't exist anymore (keep relative order)
+        unsigned int noAlive = 0;
+        for (unsigned int i = 0, len = objects.size(); i < len; i++) {
+            if (!States::isActive(&objects[i].instance->state, INSTANCE_DEAD)) {
+                if (noAlive != i) {
+                    objects[noAlive] = objects[i];
+                }
+                noAlive++;
+            }
+        }
+        bool removed = noAlive != objects.size();
+        objects.resize(noAlive);
+
+        // transform moved objects
+        bool moved = false;
+        for (BoundingRegion& br : objects) {
+            if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+                br.transform();
+                moved = true;
+            }
+        }
+
+        /*
+            keep tree up to date
+            - indices changed if objects were removed, so rebuild
+            - else refit in place, rebuild if the tree grew too much
+        */
+        if (removed) {
+            build();
+        }
+        else if (moved) {
+            refit();
+            if (surfaceArea(nodes[0].region.min, nodes[0].region.max) > builtArea * BVH_REBUILD_FACTOR) {
+                build();
+            }
+        }
+
+        for (bvhNode& n : nodes) {
+            box.positions.push_back(n.region.calculateCenter());
+            box.sizes.push_back(n.region.calculateDimensions());
+        }
+        for (BoundingRegion& br : objects) {
+            box.positions.push_back(br.calculateCenter());
+            box.sizes.push_back(br.calculateDimensions());
+        }
+    }
+
+    processPending();
+}
+
+// process pending queue
+void BVH::processPending() {
+    stats->pendingProcessed += queue.size();
+    if (treeBuilt && queue.size() == 0) {
+        return;
+    }
+
+    // new objects are sorted into the tree by a rebuild
+    objects.insert(objects.end(), queue.begin(), queue.end());
+    queue.clear();
+    build();
+}
+
+// collect overlapping pairs (at least one moved) by querying the tree with each moved object
+void BVH::collectPairs(std::vector<BroadphasePair>& pairs) {
+    for (BoundingRegion& br : objects) {
+        if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+            queryPairs(0, br, pairs);
+        }
+    }
+}
+
+// collect overlapping pairs between regions from another structure and the objects in the tree
+void BVH::collectPairs(std::vector<BoundingRegion*>& others, std::vector<BroadphasePair>& pairs) {
+    for (BoundingRegion* br : others) {
+        queryPairs(0, *br, pairs);
+    }
+}
+
+// collect regions of moved instances (to query other structures with)
+void BVH::collectMoved(std::vector<BoundingRegion*>& moved) {
+    for (BoundingRegion& br : objects) {
+        if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+            moved.push_back(&br);
+        }
+    }
+}
+
+// check collisions with a ray (children are visited front to back)
+BoundingRegion* BVH::checkCollisionsRay(Ray r, float& tmin) {
+    float tmin_tmp = std::numeric_limits<float>::max();
+    float tmax_tmp = std::numeric_limits<float>::lowest();
+
+    stats->raysCast++;
+
+    // check root region
+    if (!r.intersectsBoundingRegion(nodes[0].region, tmin_tmp, tmax_tmp) ||
+        tmin_tmp >= tmin) {
+        // no collision or found nearer collision
+        return nullptr;
+    }
+
+    return checkCollisionsRayNode(0, r, tmin);
+}
+
+// check collisions with a batch of rays (nearest hit and distance for each ray, null if no hit)
+void BVH::checkCollisionsRays(std::vector<Ray>& rays, std::vector<BoundingRegion*>& hits, std::vector<float>& tmin) {
+    unsigned int noRays = rays.size();
+    hits.assign(noRays, nullptr);
+    tmin.assign(noRays, std::numeric_limits<float>::max());
+
+    // traverse once for each packet of rays
+    for (unsigned int i = 0; i < noRays; i += RAYPACKET_SIZE) {
+        unsigned int noPacketRays = std::min(noRays - i, (unsigned int)RAYPACKET_SIZE);
+        RayPacket packet(&rays[i], noPacketRays);
+        checkCollisionsPacketNode(0, packet, &rays[i], &hits[i], &tmin[i]);
+    }
+}
+
+// collect instances with a region in the view frustum (appended to the list of each model, no duplicates)
+void BVH::frustumCull(Frustum& frustum, VisibleInstances& visible) {
+    frustumCullNode(0, frustum, visible, false);
+
+    // objects waiting in the queue (not in the tree yet) are tested directly
+    for (BoundingRegion& br : queue) {
+        if (frustum.intersectsRegion(br)) {
+            visible[br.instance->modelId].push_back(br.instance);
+        }
+    }
+
+    // instances with multiple regions may have been added more than once, keep the first
+    std::unordered_set<RigidBody*> found;
+    for (auto& pair : visible) {
+        std::vector<RigidBody*>& list = pair.second;
+        unsigned int noUnique = 0;
+        for (unsigned int i = 0, len = list.size(); i < len; i++) {
+            if (found.insert(list[i]).second) {
+                list[noUnique++] = list[i];
+            }
+        }
+        list.resize(noUnique);
+    }
+}
+
+// add structure of the tree to the counters (call after the update)
+void BVH::collectStats() {
+    collectStatsNode(0, 0);
+    stats->noQueued += queue.size();
+}
+
+// destroy object (free memory)
+void BVH::destroy() {
+    nodes.clear();
+    objects.clear();
+    order.clear();
+    queue.clear();
+}
+
+/*
+    snapshots
+*/
+
+// get hash of the pending objects and build settings (a snapshot is only valid for the same hash)
+unsigned long long BVH::hashPending() {
+    unsigned long long hash = 14695981039346656037ull;
+    int settings[] = { BVH_SNAPSHOT_VERSION, BVH_BINS, BVH_MAX_LEAF };
+    hashBytes(hash, settings, sizeof(settings));
+
+    for (BoundingRegion& br : queue) {
+        // instance and model the region belongs to
+        hashBytes(hash, br.instance->modelId.c_str(), br.instance->modelId.size() + 1);
+        hashBytes(hash, br.instance->instanceId.c_str(), br.instance->instanceId.size() + 1);
+
+        // transformed bounds
+        glm::vec3 min, max;
+        getBounds(br, min, max);
+        hashBytes(hash, &br.type, sizeof(br.type));
+        hashBytes(hash, &min[0], 3 * sizeof(float));
+        hashBytes(hash, &max[0], 3 * sizeof(float));
+    }
+
+    return hash;
+}
+
+// write built tree to a binary file
+bool BVH::saveSnapshot(std::string path, unsigned long long inputHash) {
+    if (!treeBuilt) {
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    bvhSnapshotHeader header = { { 'B', 'V', 'H', 'S' }, BVH_SNAPSHOT_VERSION, inputHash, (unsigned int)nodes.size(), (unsigned int)objects.size() };
+    file.write((char*)&header, sizeof(header));
+
+    std::vector<bvhSnapshotNode> records(nodes.size());
+    for (unsigned int i = 0, len = nodes.size(); i < len; i++) {
+        bvhNode& n = nodes[i];
+        records[i] = {
+            { n.region.min.x, n.region.min.y, n.region.min.z },
+            { n.region.max.x, n.region.max.y, n.region.max.z },
+            n.first, n.count
+        };
+    }
+    file.write((char*)records.data(), records.size() * sizeof(bvhSnapshotNode));
+    file.write((char*)order.data(), order.size() * sizeof(unsigned int));
+
+    return file.good();
+}
+
+// take pending objects as the tree stored in a snapshot (false if missing or stale, nothing changes then)
+bool BVH::loadSnapshot(std::string path, unsigned long long inputHash) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // header must match the pending objects
+    bvhSnapshotHeader header;
+    if (!file.read((char*)&header, sizeof(header)) ||
+        std::memcmp(header.magic, "BVHS", 4) != 0 ||
+        header.version != BVH_SNAPSHOT_VERSION ||
+        header.inputHash != inputHash ||
+        header.noObjects != queue.size() ||
+        header.noNodes == 0 ||
+        header.noNodes > 2 * header.noObjects + 1) {
+        return false;
+    }
+
+    // sections are stored in memory order, read each at once
+    std::vector<bvhSnapshotNode> records(header.noNodes);
+    std::vector<unsigned int> snapshotOrder(header.noObjects);
+    if (!file.read((char*)records.data(), records.size() * sizeof(bvhSnapshotNode)) ||
+        !file.read((char*)snapshotOrder.data(), snapshotOrder.size() * sizeof(unsigned int))) {
+        return false;
+    }
+
+    // reject references out of range (corrupt file), children are always stored after their parent
+    for (unsigned int i = 0; i < header.noNodes; i++) {
+        bvhSnapshotNode& r = records[i];
+        bool leaf = r.count || !r.first;
+        if (leaf
+            ? r.first + r.count > header.noObjects
+            : r.first <= i || r.first + 1 >= header.noNodes) {
+            return false;
+        }
+    }
+    for (unsigned int idx : snapshotOrder) {
+        if (idx >= header.noObjects) {
+            return false;
+        }
+    }
+
+    // take the pending objects in their queued order
+    stats->pendingProcessed += queue.size();
+    objects = std::move(queue);
+    queue.clear();
+    order = std::move(snapshotOrder);
+
+    nodes.resize(header.noNodes);
+    for (unsigned int i = 0; i < header.noNodes; i++) {
+        bvhSnapshotNode& r = records[i];
+        nodes[i] = {
+            BoundingRegion(glm::vec3(r.min[0], r.min[1], r.min[2]), glm::vec3(r.max[0], r.max[1], r.max[2])),
+            r.first, r.count
+        };
+    }
+    builtArea = surfaceArea(nodes[0].region.min, nodes[0].region.max);
+
+    // set state variables
+    treeBuilt = true;
+    treeReady = true;
+
+    return true;
+}
+
+/*
+    private
+*/
+
+// split objects [first, first + count) of the order list under node with the surface area heuristic
+void BVH::buildNode(unsigned int idx, unsigned int first, unsigned int count) {
+    // bounds of the objects and of their centers
+    glm::vec3 min(std::numeric_limits<float>::max()), max(std::numeric_limits<float>::lowest());
+    glm::vec3 centerMin = min, centerMax = max;
+    glm::vec3 objMin, objMax;
+    for (unsigned int i = first, end = first + count; i < end; i++) {
+        getBounds(objects[order[i]], objMin, objMax);
+        min = glm::min(min, objMin);
+        max = glm::max(max, objMax);
+
+        glm::vec3 center = (objMin + objMax) / 2.0f;
+        centerMin = glm::min(centerMin, center);
+        centerMax = glm::max(centerMax, center);
+    }
+
+    nodes[idx].region = BoundingRegion(min, max);
+    nodes[idx].first = first;
+    nodes[idx].count = count;
+
+    if (count <= BVH_MAX_LEAF) {
+        // small enough to test each object
+        return;
+    }
+
+    /*
+        find cheapest split
+        - centers are sorted into BVH_BINS bins on each axis
+        - cost of splitting after bin b = area(left) * count(left) + area(right) * count(right)
+    */
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    int bestBin = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = centerMax[axis] - centerMin[axis];
+        if (extent <= 0.0f) {
+            // all centers in one plane, cannot split on this axis
+            continue;
+        }
+        float scale = BVH_BINS / extent;
+
+        glm::vec3 binMin[BVH_BINS], binMax[BVH_BINS];
+        unsigned int binCount[BVH_BINS] = { 0 };
+        for (int b = 0; b < BVH_BINS; b++) {
+            binMin[b] = glm::vec3(std::numeric_limits<float>::max());
+            binMax[b] = glm::vec3(std::numeric_limits<float>::lowest());
+        }
+
+        for (unsigned int i = first, end = first + count; i < end; i++) {
+            getBounds(objects[order[i]], objMin, objMax);
+            int b = getBin((objMin[axis] + objMax[axis]) / 2.0f, centerMin[axis], scale);
+            binMin[b] = glm::min(binMin[b], objMin);
+            binMax[b] = glm::max(binMax[b], objMax);
+            binCount[b]++;
+        }
+
+        // sweep from the left for the area and count left of each split
+        float leftArea[BVH_BINS - 1];
+        unsigned int leftCount[BVH_BINS - 1];
+        glm::vec3 sweepMin(std::numeric_limits<float>::max()), sweepMax(std::numeric_limits<float>::lowest());
+        unsigned int sweepCount = 0;
+        for (int b = 0; b < BVH_BINS - 1; b++) {
+            if (binCount[b]) {
+                sweepMin = glm::min(sweepMin, binMin[b]);
+                sweepMax = glm::max(sweepMax, binMax[b]);
+                sweepCount += binCount[b];
+            }
+            leftArea[b] = sweepCount ? surfaceArea(sweepMin, sweepMax) : 0.0f;
+            leftCount[b] = sweepCount;
+        }
+
+        // sweep from the right and evaluate each split
+        sweepMin = glm::vec3(std::numeric_limits<float>::max());
+        sweepMax = glm::vec3(std::numeric_limits<float>::lowest());
+        sweepCount = 0;
+        for (int b = BVH_BINS - 1; b > 0; b--) {
+            if (binCount[b]) {
+                sweepMin = glm::min(sweepMin, binMin[b]);
+                sweepMax = glm::max(sweepMax, binMax[b]);
+                sweepCount += binCount[b];
+            }
+
+            if (!sweepCount || !leftCount[b - 1]) {
+                // one side would be empty
+                continue;
+            }
+
+            float cost = leftArea[b - 1] * leftCount[b - 1] + surfaceArea(sweepMin, sweepMax) * sweepCount;
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b - 1;
+            }
+        }
+    }
+
+    if (bestAxis == -1) {
+        // all centers coincide, keep as leaf
+        return;
+    }
+
+    // partition order list so objects left of the split come first
+    float scale = BVH_BINS / (centerMax[bestAxis] - centerMin[bestAxis]);
+    float binMin = centerMin[bestAxis];
+    unsigned int* mid = std::partition(&order[first], &order[first] + count, [&](unsigned int i) -> bool {
+        glm::vec3 objMin, objMax;
+        getBounds(objects[i], objMin, objMax);
+        return getBin((objMin[bestAxis] + objMax[bestAxis]) / 2.0f, binMin, scale) <= bestBin;
+    });
+    unsigned int noLeft = mid - &order[first];
+
+    // create children (pool may grow, so only refer to nodes by index)
+    unsigned int left = nodes.size();
+    nodes.push_back({ BoundingRegion(BoundTypes::AABB), 0, 0 });
+    nodes.push_back({ BoundingRegion(BoundTypes::AABB), 0, 0 });
+    nodes[idx].first = left;
+    nodes[idx].count = 0;
+
+    buildNode(left, first, noLeft);
+    buildNode(left + 1, first + noLeft, count - noLeft);
+}
+
+// recalculate bounds of every node from its objects or children
+void BVH::refit() {
+    // children are stored after their parent, so go in reverse
+    glm::vec3 objMin, objMax;
+    for (int idx = (int)nodes.size() - 1; idx >= 0; idx--) {
+        bvhNode& n = nodes[idx];
+        glm::vec3 min, max;
+        if (n.isLeaf()) {
+            if (!n.count) {
+                // empty root
+                continue;
+            }
+
+            // leaf: bounds of the objects
+            min = glm::vec3(std::numeric_limits<float>::max());
+            max = glm::vec3(std::numeric_limits<float>::lowest());
+            for (unsigned int i = n.first, end = n.first + n.count; i < end; i++) {
+                getBounds(objects[order[i]], objMin, objMax);
+                min = glm::min(min, objMin);
+                max = glm::max(max, objMax);
+            }
+        }
+        else {
+            // interior: bounds of the children
+            min = glm::min(nodes[n.first].region.min, nodes[n.first + 1].region.min);
+            max = glm::max(nodes[n.first].region.max, nodes[n.first + 1].region.max);
+        }
+
+        n.region.min = min;
+        n.region.max = max;
+    }
+}
+
+// collect overlapping pairs between object and the subtree starting at node
+void BVH::queryPairs(unsigned int idx, BoundingRegion& obj, std::vector<BroadphasePair>& pairs) {
+    bvhNode& n = nodes[idx];
+
+    stats->coarseTests++;
+    if (!n.region.intersectsWith(obj)) {
+        return;
+    }
+    stats->coarsePassed++;
+
+    if (n.isLeaf()) {
+        // leaf: test objects
+        for (unsigned int i = n.first, end = n.first + n.count; i < end; i++) {
+            BoundingRegion& br = objects[order[i]];
+            if (&br == &obj) {
+                continue;
+            }
+
+            if (States::isActive(&br.instance->state, INSTANCE_MOVED) && &br > &obj) {
+                // both moved, pair is added from the query of br
+                continue;
+            }
+
+            if (Broadphase::needsCheck(br, obj)) {
+                stats->coarseTests++;
+                if (br.intersectsWith(obj)) {
+                    stats->coarsePassed++;
+                    pairs.push_back({ &br, &obj });
+                }
+            }
+        }
+    }
+    else {
+        queryPairs(n.first, obj, pairs);
+        queryPairs(n.first + 1, obj, pairs);
+    }
+}
+
+// check collisions with a ray in subtree starting at node (the ray already entered the region)
+BoundingRegion* BVH::checkCollisionsRayNode(unsigned int idx, Ray& r, float& tmin) {
+    float tmin_tmp = std::numeric_limits<float>::max();
+    float tmax_tmp = std::numeric_limits<float>::lowest();
+    float t_tmp = std::numeric_limits<float>::max();
+
+    stats->rayNodesVisited++;
+
+    bvhNode& n = nodes[idx];
+    BoundingRegion* ret = nullptr, * ret_tmp = nullptr;
+
+    if (n.isLeaf()) {
+        // leaf: check objects
+        for (unsigned int i = n.first, end = n.first + n.count; i < end; i++) {
+            BoundingRegion& br = objects[order[i]];
+            tmin_tmp = std::numeric_limits<float>::max();
+            tmax_tmp = std::numeric_limits<float>::lowest();
+
+            // coarse check - check against BR
+            if (r.intersectsBoundingRegion(br, tmin_tmp, tmax_tmp)) {
+                if (tmin_tmp > tmin) {
+                    continue;
+                }
+                else if (br.collisionMesh) {
+                    // fine grain check with collision mesh
+                    t_tmp = std::numeric_limits<float>::max();
+                    if (r.intersectsMesh(br.collisionMesh, br.instance, t_tmp)) {
+                        if (t_tmp < tmin) {
+                            // found closer collision
+                            tmin = t_tmp;
+                            ret = &br;
+                        }
+                    }
+                }
+                else {
+                    // rely on coarse check
+                    if (tmin_tmp < tmin) {
+                        tmin = tmin_tmp;
+                        ret = &br;
+                    }
+                }
+            }
+        }
+
+        return ret;
+    }
+
+    // find children the ray enters before the nearest collision
+    Octree::RayEntry entries[2];
+    int noEntries = 0;
+    for (unsigned int child = n.first; child < n.first + 2; child++) {
+        if (r.intersectsBoundingRegion(nodes[child].region, tmin_tmp, tmax_tmp) &&
+            tmin_tmp < tmin) {
+            entries[noEntries++] = { (int)child, tmin_tmp };
+        }
+    }
+
+    // check children front to back
+    Octree::sortRayEntries(entries, noEntries);
+    for (int i = 0; i < noEntries; i++) {
+        if (entries[i].t >= tmin) {
+            // this and the other child are entered behind the nearest collision
+            break;
+        }
+
+        ret_tmp = checkCollisionsRayNode(entries[i].idx, r, tmin);
+        if (ret_tmp) {
+            ret = ret_tmp;
+        }
+    }
+
+    return ret;
+}
+
+// check collisions with a packet of rays in subtree starting at node
+void BVH::checkCollisionsPacketNode(unsigned int idx, RayPacket& packet, Ray* rays, BoundingRegion** hits, float* tmin) {
+    float tmin_tmp[RAYPACKET_SIZE];
+    float t_tmp;
+
+    bvhNode& n = nodes[idx];
+
+    // check current region
+    unsigned int mask = packet.intersectsBoundingRegion(n.region, tmin_tmp);
+    for (unsigned int i = 0; i < packet.noRays; i++) {
+        if (tmin_tmp[i] >= tmin[i]) {
+            // ray found nearer collision
+            mask &= ~(1u << i);
+        }
+    }
+    if (!mask) {
+        // no ray left to check in this region
+        return;
+    }
+
+    if (!n.isLeaf()) {
+        // check children
+        checkCollisionsPacketNode(n.first, packet, rays, hits, tmin);
+        checkCollisionsPacketNode(n.first + 1, packet, rays, hits, tmin);
+        return;
+    }
+
+    // leaf: check objects
+    for (unsigned int o = n.first, end = n.first + n.count; o < end; o++) {
+        BoundingRegion& br = objects[order[o]];
+
+        // coarse check - check against BR
+        unsigned int objMask = packet.intersectsBoundingRegion(br, tmin_tmp) & mask;
+
+        for (unsigned int i = 0; objMask; objMask >>= 1, i++) {
+            if (!(objMask & 1) || tmin_tmp[i] > tmin[i]) {
+                continue;
+            }
+            else if (br.collisionMesh) {
+                // fine grain check with collision mesh
+                t_tmp = std::numeric_limits<float>::max();
+                if (rays[i].intersectsMesh(br.collisionMesh, br.instance, t_tmp)) {
+                    if (t_tmp < tmin[i]) {
+                        // found closer collision
+                        tmin[i] = t_tmp;
+                        hits[i] = &br;
+                    }
+                }
+            }
+            else if (tmin_tmp[i] < tmin[i]) {
+                // rely on coarse check
+                tmin[i] = tmin_tmp[i];
+                hits[i] = &br;
+            }
+        }
+    }
+}
+
+// collect instances with a region in the view frustum in subtree starting at node (skip tests if inside is set)
+void BVH::frustumCullNode(unsigned int idx, Frustum& frustum, VisibleInstances& visible, bool inside) {
+    bvhNode& n = nodes[idx];
+    if (!inside) {
+        FrustumTest res = frustum.testRegion(n.region);
+        if (res == FrustumTest::OUTSIDE) {
+            // node and all objects in it are out of view
+            return;
+        }
+        // if the node is completely in view, so is everything below
+        inside = res == FrustumTest::INSIDE;
+    }
+
+    if (!n.isLeaf()) {
+        // check children
+        frustumCullNode(n.first, frustum, visible, inside);
+        frustumCullNode(n.first + 1, frustum, visible, inside);
+        return;
+    }
+
+    // leaf: check objects
+    for (unsigned int i = n.first, end = n.first + n.count; i < end; i++) {
+        BoundingRegion& br = objects[order[i]];
+        if (inside || frustum.intersectsRegion(br)) {
+            visible[br.instance->modelId].push_back(br.instance);
+        }
+    }
+}
+
+// add structure of subtree starting at node to the counters
+void BVH::collectStatsNode(unsigned int idx, unsigned int depth) {
+    bvhNode& n = nodes[idx];
+
+    stats->noNodes++;
+    stats->maxDepth = std::max(stats->maxDepth, depth);
+    stats->noObjects += n.count;
+    stats->maxObjectsPerNode = std::max(stats->maxObjectsPerNode, n.count);
+
+    if (!n.isLeaf()) {
+        collectStatsNode(n.first, depth + 1);
+        collectStatsNode(n.first + 1, depth + 1);
+    }
+}
@@ -0,0 +1,188 @@
+#ifndef BVH_H
+#define BVH_H
+
+#define BVH_BINS 12 // candidate split positions per axis when building
+#define BVH_MAX_LEAF 4 // most objects in a leaf
+#define BVH_REBUILD_FACTOR 2.0f // rebuild when refitting grows the root surface area by this factor
+#define BVH_SNAPSHOT_VERSION 1 // format of snapshot files (older files are rebuilt)
+
+#include <vector>
+#include <string>
+
+#include "states.hpp"
+#include "bounds.h"
+#include "ray.h"
+#include "frustum.h"
+#include "raypacket.h"
+#include "treestats.h"
+#include "broadphase.h"
+
+#include "../graphics/objects/model.h"
+
+// forward declaration
+class Model;
+class BoundingRegion;
+class Box;
+
+/*
+    structure to represent each node of the hierarchy
+*/
+
+struct bvhNode {
+    // bounds of everything below the node (AABB)
+    BoundingRegion region;
+
+    // leaf: index of the first object in the order list, interior: index of the left child (right child follows it)
+    unsigned int first;
+    // number of objects (0 if interior)
+    unsigned int count;
+
+    // if node holds objects (children never start at the root, so first = 0 without objects is an empty root)
+    bool isLeaf() {
+        return count || !first;
+    }
+};
+
+/*
+    records of a snapshot file
+    - header, then the nodes, then the order list
+    - objects are referenced by their index in the pending queue (the order instances were generated)
+*/
+
+struct bvhSnapshotHeader {
+    // "BVHS"
+    char magic[4];
+    // BVH_SNAPSHOT_VERSION
+    unsigned int version;
+    // hash of the pending objects the tree was built from
+    unsigned long long inputHash;
+    unsigned int noNodes;
+    unsigned int noObjects;
+};
+
+struct bvhSnapshotNode {
+    float min[3];
+    float max[3];
+    unsigned int first;
+    unsigned int count;
+};
+
+/*
+    bounding volume hierarchy
+    - binary tree over the objects, split with the surface area heuristic (binned centroids)
+    - nodes live in one array, children are stored after their parent
+    - moved objects are refitted in place, the tree is rebuilt when objects are added or removed
+        or when refitting has grown it too much
+    - same build/update/ray/collision entry points as Octree::node, so Scene::octree can switch to it
+*/
+
+class BVH {
+public:
+    // nodes (root is at index 0)
+    std::vector<bvhNode> nodes;
+    // bounds of all objects in the hierarchy
+    std::vector<BoundingRegion> objects;
+    // indices of the objects in leaf order
+    std::vector<unsigned int> order;
+
+    // if tree is ready
+    bool treeReady = false;
+    // if tree is built
+    bool treeBuilt = false;
+
+    // objects to be added at the next rebuild
+    std::vector<BoundingRegion> queue;
+
+    // surface area of the root when it was built
+    float builtArea = 0.0f;
+
+    // counters for the current frame
+    TreeStats* stats;
+
+    /*
+        constructor
+    */
+
+    // initialize empty (bounds are unused, the hierarchy fits its objects)
+    BVH(BoundingRegion bounds);
+
+    // free counters
+    ~BVH();
+
+    /*
+        functionality
+    */
+
+    // add instance to pending queue
+    void addToPending(RigidBody* instance, Model* model);
+
+    // build tree from all objects (called during initialization and when objects change)
+    void build();
+
+    // update objects in tree (called during each iteration of main loop)
+    void update(Box& box);
+
+    // process pending queue
+    void processPending();
+
+    // collect overlapping pairs (at least one moved) by querying the tree with each moved object
+    void collectPairs(std::vector<BroadphasePair>& pairs);
+
+    // collect overlapping pairs between regions from another structure and the objects in the tree
+    void collectPairs(std::vector<BoundingRegion*>& others, std::vector<BroadphasePair>& pairs);
+
+    // collect regions of moved instances (to query other structures with)
+    void collectMoved(std::vector<BoundingRegion*>& moved);
+
+    // check collisions with a ray (children are visited front to back)
+    BoundingRegion* checkCollisionsRay(Ray r, float& tmin);
+
+    // check collisions with a batch of rays (nearest hit and distance for each ray, null if no hit)
+    void checkCollisionsRays(std::vector<Ray>& rays, std::vector<BoundingRegion*>& hits, std::vector<float>& tmin);
+
+    // collect instances with a region in the view frustum (appended to the list of each model, no duplicates)
+    void frustumCull(Frustum& frustum, VisibleInstances& visible);
+
+    // add structure of the tree to the counters (call after the update)
+    void collectStats();
+
+    // destroy object (free memory)
+    void destroy();
+
+    /*
+        snapshots
+    */
+
+    // get hash of the pending objects and build settings (a snapshot is only valid for the same hash)
+    unsigned long long hashPending();
+
+    // write built tree to a binary file
+    bool saveSnapshot(std::string path, unsigned long long inputHash);
+
+    // take pending objects as the tree stored in a snapshot (false if missing or stale, nothing changes then)
+    bool loadSnapshot(std::string path, unsigned long long inputHash);
+
+private:
+    // split objects [first, first + count) of the order list under node with the surface area heuristic
+    void buildNode(unsigned int idx, unsigned int first, unsigned int count);
+
+    // recalculate bounds of every node from its objects or children
+    void refit();
+
+    // collect overlapping pairs between object and the subtree starting at node
+    void queryPairs(unsigned int idx, BoundingRegion& obj, std::vector<BroadphasePair>& pairs);
+
+    // check collisions with a ray in subtree starting at node (the ray already entered the region)
+    BoundingRegion* checkCollisionsRayNode(unsigned int idx, Ray& r, float& tmin);
+
+    // check collisions with a packet of rays in subtree starting at node
+    void checkCollisionsPacketNode(unsigned int idx, RayPacket& packet, Ray* rays, BoundingRegion** hits, float* tmin);
+
+    // collect instances with a region in the view frustum in subtree starting at node (skip tests if inside is set)
+    void frustumCullNode(unsigned int idx, Frustum& frustum, VisibleInstances& visible, bool inside);
+
+    // add structure of subtree starting at node to the counters
+    void collectStatsNode(unsigned int idx, unsigned int depth);
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "frustum.h"
+
+/*
+    constructors
+*/
+
+// default (contains everything)
+Frustum::Frustum() {
+    for (int i = 0; i < 6; i++) {
+        planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+// extract planes from combined matrix (projection * view)
+Frustum::Frustum(glm::mat4 viewProjection) {
+    // rows of the matrix (glm is column major)
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    // clip space -w <= x, y, z <= w
+    planes[0] = rows[3] + rows[0]; // left
+    planes[1] = rows[3] - rows[0]; // right
+    planes[2] = rows[3] + rows[1]; // bottom
+    planes[3] = rows[3] - rows[1]; // top
+    planes[4] = rows[3] + rows[2]; // near
+    planes[5] = rows[3] - rows[2]; // far
+
+    // normalize so the distances are in world units (needed for spheres)
+    for (int i = 0; i < 6; i++) {
+        float len = glm::length(glm::vec3(planes[i]));
+        if (len > 0.0f) {
+            planes[i] /= len;
+        }
+    }
+}
+
+// extract planes from camera matrices
+Frustum::Frustum(glm::mat4 view, glm::mat4 projection)
+    : Frustum(projection * view) {}
+
+/*
+    modifiers
+*/
+
+// move each plane outwards by distance (regions up to distance outside of the frustum pass)
+void Frustum::expand(float distance) {
+    // normals are unit length, so the distance is in world units
+    for (int i = 0; i < 6; i++) {
+        planes[i].w += distance;
+    }
+}
+
+/*
+    testing methods
+*/
+
+// determine if point is inside the frustum
+bool Frustum::containsPoint(glm::vec3 pt) {
+    for (int i = 0; i < 6; i++) {
+        if (glm::dot(glm::vec3(planes[i]), pt) + planes[i].w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// test a bounding region (AABB or sphere) against the frustum
+FrustumTest Frustum::testRegion(BoundingRegion& br) {
+    FrustumTest ret = FrustumTest::INSIDE;
+
+    for (int i = 0; i < 6; i++) {
+        glm::vec3 normal(planes[i]);
+
+        if (br.type == BoundTypes::AABB) {
+            // corner furthest along the normal (p-vertex) and the opposite one (n-vertex)
+            glm::vec3 p = br.min, n = br.max;
+            for (int j = 0; j < 3; j++) {
+                if (normal[j] >= 0.0f) {
+                    p[j] = br.max[j];
+                    n[j] = br.min[j];
+                }
+            }
+
+            if (glm::dot(normal, p) + planes[i].w < 0.0f) {
+                // whole box behind plane
+                return FrustumTest::OUTSIDE;
+            }
+            if (glm::dot(normal, n) + planes[i].w < 0.0f) {
+                ret = FrustumTest::INTERSECT;
+            }
+        }
+        else {
+            // signed distance of the center
+            float dist = glm::dot(normal, br.center) + planes[i].w;
+            if (dist < -br.radius) {
+                // whole sphere behind plane
+                return FrustumTest::OUTSIDE;
+            }
+            if (dist < br.radius) {
+                ret = FrustumTest::INTERSECT;
+            }
+        }
+    }
+
+    return ret;
+}
+
+// determine if bounding region is at least partially inside the frustum
+bool Frustum::intersectsRegion(BoundingRegion& br) {
+    return testRegion(br) != FrustumTest::OUTSIDE;
+}
@@ -0,0 +1,71 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "bounds.h"
+
+/*
+    view frustum
+    - 6 planes extracted from a (projection * view) matrix
+    - each plane is stored as (normal, distance) with the normal pointing inwards
+    - only needs the matrix, so it can be tested without a GL context
+*/
+
+// lists of visible instances for each model id
+typedef std::unordered_map<std::string, std::vector<RigidBody*>> VisibleInstances;
+
+/*
+    enum for results of a frustum test
+*/
+
+enum class FrustumTest : char {
+    OUTSIDE = -1,   // completely outside of at least one plane
+    INTERSECT = 0,  // crosses at least one plane
+    INSIDE = 1      // completely inside all planes
+};
+
+class Frustum {
+public:
+    // planes (left, right, bottom, top, near, far)
+    glm::vec4 planes[6];
+
+    /*
+        constructors
+    */
+
+    // default (contains everything)
+    Frustum();
+
+    // extract planes from combined matrix (projection * view)
+    Frustum(glm::mat4 viewProjection);
+
+    // extract planes from camera matrices
+    Frustum(glm::mat4 view, glm::mat4 projection);
+
+    /*
+        modifiers
+    */
+
+    // move each plane outwards by distance (regions up to distance outside of the frustum pass)
+    void expand(float distance);
+
+    /*
+        testing methods
+    */
+
+    // determine if point is inside the frustum
+    bool containsPoint(glm::vec3 pt);
+
+    // test a bounding region (AABB or sphere) against the frustum
+    FrustumTest testRegion(BoundingRegion& br);
+
+    // determine if bounding region is at least partially inside the frustum
+    bool intersectsRegion(BoundingRegion& br);
+};
+
+#endif
@@ -0,0 +1,461 @@
+#include "hashgrid.h"
+#include "../graphics/models/box.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
+/*
+    utility methods
+*/
+
+// get AABB of a region (box or sphere)
+static void getBounds(BoundingRegion& br, glm::vec3& min, glm::vec3& max) {
+    glm::vec3 center = br.calculateCenter();
+    glm::vec3 halfDimensions = br.calculateDimensions() / 2.0f;
+    min = center - halfDimensions;
+    max = center + halfDimensions;
+}
+
+/*
+    constructor
+*/
+
+// initialize empty (bounds are unused, cells are hashed so the grid is unbounded)
+HashGrid::HashGrid(BoundingRegion /*bounds*/)
+    : bounds(glm::vec3(0.0f), glm::vec3(0.0f)), stats(new TreeStats()) {}
+
+// free counters
+HashGrid::~HashGrid() {
+    delete stats;
+}
+
+/*
+    functionality
+*/
+
+// add instance to pending queue
+void HashGrid::addToPending(RigidBody* instance, Model* model) {
+    // get all bounding regions of model and put them in queue
+    for (BoundingRegion br : model->boundingRegions) {
+        br.instance = instance;
+        br.cell = nullptr;
+        br.transform();
+        queue.push_back(br);
+    }
+}
+
+// sort objects into the buckets (called during initialization and each update)
+void HashGrid::build() {
+    unsigned int noObjects = objects.size();
+
+    // at least twice as many buckets as objects (power of 2)
+    unsigned int noBuckets = HASHGRID_MIN_BUCKETS;
+    while (noBuckets < 2 * noObjects) {
+        noBuckets <<= 1;
+    }
+
+    cellStart.assign(noBuckets + 1, 0);
+    bucketLast.assign(noBuckets, std::numeric_limits<unsigned int>::max());
+    cellMin.resize(noObjects);
+    cellMax.resize(noObjects);
+    large.clear();
+
+    /*
+        counting sort
+        - count entries of each bucket (stored one ahead)
+        - prefix sum gives the first entry of each bucket
+        - place objects in their buckets
+    */
+    glm::vec3 min(std::numeric_limits<float>::max()), max(std::numeric_limits<float>::lowest());
+    glm::vec3 objMin, objMax;
+    for (unsigned int i = 0; i < noObjects; i++) {
+        getBounds(objects[i], objMin, objMax);
+        cellMin[i] = getCell(objMin);
+        cellMax[i] = getCell(objMax);
+        if (isLarge(i)) {
+            large.push_back(i);
+            continue;
+        }
+
+        min = glm::min(min, objMin);
+        max = glm::max(max, objMax);
+
+        for (int x = cellMin[i].x; x <= cellMax[i].x; x++) {
+            for (int y = cellMin[i].y; y <= cellMax[i].y; y++) {
+                for (int z = cellMin[i].z; z <= cellMax[i].z; z++) {
+                    unsigned int bucket = getBucket(glm::ivec3(x, y, z));
+                    if (bucketLast[bucket] != i) {
+                        bucketLast[bucket] = i;
+                        cellStart[bucket + 1]++;
+                    }
+                }
+            }
+        }
+    }
+
+    for (unsigned int b = 1; b <= noBuckets; b++) {
+        cellStart[b] += cellStart[b - 1];
+    }
+
+    cellObjects.resize(cellStart[noBuckets]);
+    bucketFill.assign(cellStart.begin(), cellStart.end() - 1);
+    bucketLast.assign(noBuckets, std::numeric_limits<unsigned int>::max());
+    for (unsigned int i = 0; i < noObjects; i++) {
+        if (isLarge(i)) {
+            continue;
+        }
+
+        for (int x = cellMin[i].x; x <= cellMax[i].x; x++) {
+            for (int y = cellMin[i].y; y <= cellMax[i].y; y++) {
+                for (int z = cellMin[i].z; z <= cellMax[i].z; z++) {
+                    unsigned int bucket = getBucket(glm::ivec3(x, y, z));
+                    if (bucketLast[bucket] != i) {
+                        bucketLast[bucket] = i;
+                        cellObjects[bucketFill[bucket]++] = i;
+                    }
+                }
+            }
+        }
+    }
+
+    bounds = cellObjects.size()
+        ? BoundingRegion(min, max)
+        : BoundingRegion(glm::vec3(0.0f), glm::vec3(0.0f));
+
+    // set state variables
+    treeBuilt = true;
+    treeReady = true;
+}
+
+// update objects in grid (called during each iteration of main loop)
+void HashGrid::update(Box& box) {
+    if (treeBuilt && treeReady) {
+        // remove objects that don't exist anymore (keep relative order)
+        unsigned int noAlive = 0;
+        for (unsigned int i = 0, len = objects.size(); i < len; i++) {
+            if (!States::isActive(&objects[i].instance->state, INSTANCE_DEAD)) {
+                if (noAlive != i) {
+                    objects[noAlive] = objects[i];
+                }
+                noAlive++;
+            }
+        }
+        objects.resize(noAlive);
+
+        // transform moved objects
+        for (BoundingRegion& br : objects) {
+            if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+                br.transform();
+            }
+        }
+    }
+
+    // new objects are sorted in with the rest
+    stats->pendingProcessed += queue.size();
+    objects.insert(objects.end(), queue.begin(), queue.end());
+    queue.clear();
+    build();
+
+    for (BoundingRegion& br : objects) {
+        box.positions.push_back(br.calculateCenter());
+        box.sizes.push_back(br.calculateDimensions());
+    }
+}
+
+// process pending queue
+void HashGrid::processPending() {
+    if (treeBuilt && queue.size() == 0) {
+        return;
+    }
+
+    stats->pendingProcessed += queue.size();
+    objects.insert(objects.end(), queue.begin(), queue.end());
+    queue.clear();
+    build();
+}
+
+// collect overlapping pairs (at least one moved) by querying the cells of each moved object
+void HashGrid::collectPairs(std::vector<BroadphasePair>& pairs) {
+    for (unsigned int i = 0, len = objects.size(); i < len; i++) {
+        if (!States::isActive(&objects[i].instance->state, INSTANCE_MOVED)) {
+            continue;
+        }
+
+        if (isLarge(i)) {
+            // test against everything (moved objects in cells add the pair from their own query)
+            for (unsigned int j = 0; j < len; j++) {
+                if (j == i || (States::isActive(&objects[j].instance->state, INSTANCE_MOVED) &&
+                    (!isLarge(j) || j > i))) {
+                    continue;
+                }
+                addPair(j, i, pairs);
+            }
+            continue;
+        }
+
+        // objects sharing a cell
+        for (int x = cellMin[i].x; x <= cellMax[i].x; x++) {
+            for (int y = cellMin[i].y; y <= cellMax[i].y; y++) {
+                for (int z = cellMin[i].z; z <= cellMax[i].z; z++) {
+                    glm::ivec3 cell(x, y, z);
+                    unsigned int bucket = getBucket(cell);
+                    for (unsigned int k = cellStart[bucket], end = cellStart[bucket + 1]; k < end; k++) {
+                        unsigned int j = cellObjects[k];
+                        if (j == i) {
+                            continue;
+                        }
+
+                        if (States::isActive(&objects[j].instance->state, INSTANCE_MOVED) && j > i) {
+                            // both moved, pair is added from the query of j
+                            continue;
+                        }
+
+                        addPair(j, i, cell, pairs);
+                    }
+                }
+            }
+        }
+
+        // objects too large for the cells
+        for (unsigned int j : large) {
+            addPair(j, i, pairs);
+        }
+    }
+}
+
+// collect regions of moved instances (to query other structures with)
+void HashGrid::collectMoved(std::vector<BoundingRegion*>& moved) {
+    for (BoundingRegion& br : objects) {
+        if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+            moved.push_back(&br);
+        }
+    }
+}
+
+// check collisions with a ray (cells are walked along the ray until the nearest hit)
+BoundingRegion* HashGrid::checkCollisionsRay(Ray r, float& tmin) {
+    BoundingRegion* ret = nullptr;
+
+    stats->raysCast++;
+
+    // objects too large for the cells
+    for (unsigned int idx : large) {
+        checkCollisionsRayObject(r, objects[idx], tmin, ret);
+    }
+
+    // clip ray to the bounds of the cells
+    float tenter = std::numeric_limits<float>::max();
+    float texit = std::numeric_limits<float>::lowest();
+    if (cellObjects.size() == 0 ||
+        !r.intersectsBoundingRegion(bounds, tenter, texit) ||
+        tenter >= tmin) {
+        return ret;
+    }
+    tenter = std::max(tenter, 0.0f);
+
+    /*
+        walk the cells along the ray (3D DDA)
+        - tNext is the distance at which the ray leaves the current cell on each axis
+        - stop once the nearest hit is before the ray leaves the current cell
+    */
+    glm::ivec3 gridMin = getCell(bounds.min);
+    glm::ivec3 gridMax = getCell(bounds.max);
+    glm::ivec3 cell = glm::clamp(getCell(r.origin + tenter * r.dir), gridMin, gridMax);
+    glm::ivec3 step;
+    glm::vec3 tNext, tDelta;
+    for (int i = 0; i < 3; i++) {
+        if (r.dir[i] > 0.0f) {
+            step[i] = 1;
+            tNext[i] = ((cell[i] + 1) * cellSize - r.origin[i]) * r.invdir[i];
+            tDelta[i] = cellSize * r.invdir[i];
+        }
+        else if (r.dir[i] < 0.0f) {
+            step[i] = -1;
+            tNext[i] = (cell[i] * cellSize - r.origin[i]) * r.invdir[i];
+            tDelta[i] = -cellSize * r.invdir[i];
+        }
+        else {
+            // never leaves the cell on this axis
+            step[i] = 0;
+            tNext[i] = std::numeric_limits<float>::max();
+            tDelta[i] = std::numeric_limits<float>::max();
+        }
+    }
+
+    while (true) {
+        stats->rayNodesVisited++;
+
+        unsigned int bucket = getBucket(cell);
+        for (unsigned int k = cellStart[bucket], end = cellStart[bucket + 1]; k < end; k++) {
+            checkCollisionsRayObject(r, objects[cellObjects[k]], tmin, ret);
+        }
+
+        int axis = tNext.x < tNext.y
+            ? (tNext.x < tNext.z ? 0 : 2)
+            : (tNext.y < tNext.z ? 1 : 2);
+        if (tmin <= tNext[axis] || tNext[axis] > texit) {
+            // nearest hit is in the cells walked so far, or the ray left the bounds
+            break;
+        }
+
+        cell[axis] += step[axis];
+        if (cell[axis] < gridMin[axis] || cell[axis] > gridMax[axis]) {
+            break;
+        }
+        tNext[axis] += tDelta[axis];
+    }
+
+    return ret;
+}
+
+// check collisions with a batch of rays (nearest hit and distance for each ray, null if no hit)
+void HashGrid::checkCollisionsRays(std::vector<Ray>& rays, std::vector<BoundingRegion*>& hits, std::vector<float>& tmin) {
+    unsigned int noRays = rays.size();
+    hits.assign(noRays, nullptr);
+    tmin.assign(noRays, std::numeric_limits<float>::max());
+
+    // each ray walks its own cells
+    for (unsigned int i = 0; i < noRays; i++) {
+        hits[i] = checkCollisionsRay(rays[i], tmin[i]);
+    }
+}
+
+// collect instances with a region in the view frustum (appended to the list of each model, no duplicates)
+void HashGrid::frustumCull(Frustum& frustum, VisibleInstances& visible) {
+    // flat list, so test every object
+    for (BoundingRegion& br : objects) {
+        if (frustum.intersectsRegion(br)) {
+            visible[br.instance->modelId].push_back(br.instance);
+        }
+    }
+
+    // objects waiting in the queue (not in the grid yet) are tested directly
+    for (BoundingRegion& br : queue) {
+        if (frustum.intersectsRegion(br)) {
+            visible[br.instance->modelId].push_back(br.instance);
+        }
+    }
+
+    // instances with multiple regions may have been added more than once, keep the first
+    std::unordered_set<RigidBody*> found;
+    for (auto& pair : visible) {
+        std::vector<RigidBody*>& list = pair.second;
+        unsigned int noUnique = 0;
+        for (unsigned int i = 0, len = list.size(); i < len; i++) {
+            if (found.insert(list[i]).second) {
+                list[noUnique++] = list[i];
+            }
+        }
+        list.resize(noUnique);
+    }
+}
+
+// add structure of the grid to the counters (call after the update)
+void HashGrid::collectStats() {
+    // each bucket in use counts as a node
+    for (unsigned int b = 0, noBuckets = cellStart.size() - 1; b < noBuckets; b++) {
+        unsigned int size = cellStart[b + 1] - cellStart[b];
+        if (size) {
+            stats->noNodes++;
+            stats->maxObjectsPerNode = std::max(stats->maxObjectsPerNode, size);
+        }
+    }
+    stats->noObjects += objects.size();
+    stats->noQueued += queue.size();
+}
+
+// destroy object (free memory)
+void HashGrid::destroy() {
+    objects.clear();
+    cellStart.clear();
+    cellObjects.clear();
+    large.clear();
+    bucketLast.clear();
+    bucketFill.clear();
+    cellMin.clear();
+    cellMax.clear();
+    queue.clear();
+}
+
+/*
+    private
+*/
+
+// get cell containing point
+glm::ivec3 HashGrid::getCell(glm::vec3 pt) {
+    return glm::ivec3(glm::floor(pt / cellSize));
+}
+
+// get bucket of cell
+unsigned int HashGrid::getBucket(glm::ivec3 cell) {
+    // large primes, number of buckets is a power of 2
+    unsigned int hash = ((unsigned int)cell.x * 73856093u) ^
+        ((unsigned int)cell.y * 19349663u) ^
+        ((unsigned int)cell.z * 83492791u);
+    return hash & (cellStart.size() - 2);
+}
+
+// determine if object covers too many cells to be stored in them
+bool HashGrid::isLarge(unsigned int idx) {
+    glm::ivec3 span = cellMax[idx] - cellMin[idx] + 1;
+    return (long long)span.x * span.y * span.z > HASHGRID_MAX_CELLS;
+}
+
+// coarse check two objects and add them to the buffer if they may collide (counted in the stats)
+void HashGrid::addPair(unsigned int a, unsigned int b, std::vector<BroadphasePair>& pairs) {
+    if (!Broadphase::needsCheck(objects[a], objects[b])) {
+        return;
+    }
+
+    stats->coarseTests++;
+    if (objects[a].intersectsWith(objects[b])) {
+        stats->coarsePassed++;
+        pairs.push_back({ &objects[a], &objects[b] });
+    }
+}
+
+// add pair if the objects may collide and cell holds the min corner of their overlap (each pair is added from one cell)
+void HashGrid::addPair(unsigned int a, unsigned int b, glm::ivec3 cell, std::vector<BroadphasePair>& pairs) {
+    glm::vec3 minA, maxA, minB, maxB;
+    getBounds(objects[a], minA, maxA);
+    getBounds(objects[b], minB, maxB);
+    if (getCell(glm::max(minA, minB)) != cell) {
+        // overlap starts in another cell (or the object came from another cell in the same bucket)
+        return;
+    }
+
+    addPair(a, b, pairs);
+}
+
+// test ray against region, updates nearest hit
+void HashGrid::checkCollisionsRayObject(Ray& r, BoundingRegion& br, float& tmin, BoundingRegion*& ret) {
+    float tmin_tmp = std::numeric_limits<float>::max();
+    float tmax_tmp = std::numeric_limits<float>::lowest();
+    float t_tmp = std::numeric_limits<float>::max();
+
+    // coarse check - check against BR
+    if (r.intersectsBoundingRegion(br, tmin_tmp, tmax_tmp)) {
+        if (tmin_tmp > tmin) {
+            return;
+        }
+        else if (br.collisionMesh) {
+            // fine grain check with collision mesh
+            t_tmp = std::numeric_limits<float>::max();
+            if (r.intersectsMesh(br.collisionMesh, br.instance, t_tmp)) {
+                if (t_tmp < tmin) {
+                    // found closer collision
+                    tmin = t_tmp;
+                    ret = &br;
+                }
+            }
+        }
+        else {
+            // rely on coarse check
+            if (tmin_tmp < tmin) {
+                tmin = tmin_tmp;
+                ret = &br;
+            }
+        }
+    }
+}
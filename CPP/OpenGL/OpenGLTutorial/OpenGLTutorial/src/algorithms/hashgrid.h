@@ -0,0 +1,138 @@
+#ifndef HASHGRID_H
+#define HASHGRID_H
+
+#define HASHGRID_MIN_BUCKETS 64 // fewest buckets in the table
+#define HASHGRID_MAX_CELLS 64 // objects covering more cells are tested against everything instead
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "states.hpp"
+#include "bounds.h"
+#include "ray.h"
+#include "frustum.h"
+#include "treestats.h"
+#include "broadphase.h"
+
+#include "../graphics/objects/model.h"
+
+// forward declaration
+class Model;
+class BoundingRegion;
+class Box;
+
+/*
+    uniform spatial hash grid
+    - space is split into cubes of cellSize, each cell is hashed into a fixed number of buckets
+    - rebuilt each frame with a counting sort, so the objects of a bucket are contiguous in one array
+    - an object is stored in every cell its bounds cover, oversized objects are kept in a separate list
+    - meant for many similar sized moving objects (cellSize about their diameter)
+    - same build/update/ray/collision entry points as Octree::node, so Scene::octree can switch to it
+*/
+
+class HashGrid {
+public:
+    // size of each cell
+    float cellSize = 1.0f;
+
+    // bounds of all objects in the grid
+    std::vector<BoundingRegion> objects;
+
+    // first entry of each bucket in cellObjects (bucket i is [cellStart[i], cellStart[i + 1]))
+    std::vector<unsigned int> cellStart;
+    // indices of the objects in each bucket
+    std::vector<unsigned int> cellObjects;
+    // objects covering more than HASHGRID_MAX_CELLS cells
+    std::vector<unsigned int> large;
+    // last object added to each bucket while sorting (an object is added once even if several of its cells share a bucket)
+    std::vector<unsigned int> bucketLast;
+    // next free entry of each bucket while sorting
+    std::vector<unsigned int> bucketFill;
+
+    // range of cells covered by each object
+    std::vector<glm::ivec3> cellMin;
+    std::vector<glm::ivec3> cellMax;
+
+    // bounds of the objects stored in cells (AABB)
+    BoundingRegion bounds;
+
+    // if tree is ready
+    bool treeReady = false;
+    // if tree is built
+    bool treeBuilt = false;
+
+    // objects to be added at the next update
+    std::vector<BoundingRegion> queue;
+
+    // counters for the current frame
+    TreeStats* stats;
+
+    /*
+        constructor
+    */
+
+    // initialize empty (bounds are unused, cells are hashed so the grid is unbounded)
+    HashGrid(BoundingRegion bounds);
+
+    // free counters
+    ~HashGrid();
+
+    /*
+        functionality
+    */
+
+    // add instance to pending queue
+    void addToPending(RigidBody* instance, Model* model);
+
+    // sort objects into the buckets (called during initialization and each update)
+    void build();
+
+    // update objects in grid (called during each iteration of main loop)
+    void update(Box& box);
+
+    // process pending queue
+    void processPending();
+
+    // collect overlapping pairs (at least one moved) by querying the cells of each moved object
+    void collectPairs(std::vector<BroadphasePair>& pairs);
+
+    // collect regions of moved instances (to query other structures with)
+    void collectMoved(std::vector<BoundingRegion*>& moved);
+
+    // check collisions with a ray (cells are walked along the ray until the nearest hit)
+    BoundingRegion* checkCollisionsRay(Ray r, float& tmin);
+
+    // check collisions with a batch of rays (nearest hit and distance for each ray, null if no hit)
+    void checkCollisionsRays(std::vector<Ray>& rays, std::vector<BoundingRegion*>& hits, std::vector<float>& tmin);
+
+    // collect instances with a region in the view frustum (appended to the list of each model, no duplicates)
+    void frustumCull(Frustum& frustum, VisibleInstances& visible);
+
+    // add structure of the grid to the counters (call after the update)
+    void collectStats();
+
+    // destroy object (free memory)
+    void destroy();
+
+private:
+    // get cell containing point
+    glm::ivec3 getCell(glm::vec3 pt);
+
+    // get bucket of cell
+    unsigned int getBucket(glm::ivec3 cell);
+
+    // determine if object covers too many cells to be stored in them
+    bool isLarge(unsigned int idx);
+
+    // coarse check two objects and add them to the buffer if they may collide (counted in the stats)
+    void addPair(unsigned int a, unsigned int b, std::vector<BroadphasePair>& pairs);
+
+    // add pair if the objects may collide and cell holds the min corner of their overlap (each pair is added from one cell)
+    void addPair(unsigned int a, unsigned int b, glm::ivec3 cell, std::vector<BroadphasePair>& pairs);
+
+    // test ray against region, updates nearest hit
+    void checkCollisionsRayObject(Ray& r, BoundingRegion& br, float& tmin, BoundingRegion*& ret);
+};
+
+#endif
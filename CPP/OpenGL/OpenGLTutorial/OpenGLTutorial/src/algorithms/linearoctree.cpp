@@ -0,0 +1,838 @@
+#include "linearoctree.h"
+#include "../graphics/models/box.hpp"
+
+#include <algorithm>
+#include <limits>
+
+/*
+    constructor
+*/
+
+// initialize with bounds of the root (no objects yet)
+Octree::LinearTree::LinearTree(BoundingRegion bounds)
+    : stats(new TreeStats()) {
+    nodes.push_back(linearNode());
+    setupNode(0, ROOT_CODE, 0, bounds);
+}
+
+// free counters
+Octree::LinearTree::~LinearTree() {
+    delete stats;
+}
+
+/*
+    functionality
+*/
+
+// add instance to pending queue
+void Octree::LinearTree::addToPending(RigidBody* instance, Model* model) {
+    // get all bounding regions of model and put them in queue
+    for (BoundingRegion br : model->boundingRegions) {
+        br.instance = instance;
+        br.transform();
+        queue.push(br);
+    }
+}
+
+// build tree (called during initialization)
+void Octree::LinearTree::build() {
+    buildNode(0);
+
+    // set state variables
+    treeBuilt = true;
+    treeReady = true;
+}
+
+// update objects in tree (called during each iteration of main loop)
+void Octree::LinearTree::update(Box& box) {
+    if (treeBuilt && treeReady) {
+        /*
+            sweep the pool linearly
+            - countdown timers
+        */
+        for (unsigned int idx = 0, noNodes = nodes.size(); idx < noNodes; idx++) {
+            linearNode& n = nodes[idx];
+            if (!n.code) {
+                // free slot
+                continue;
+            }
+
+            box.positions.push_back(n.region.calculateCenter());
+            box.sizes.push_back(n.region.calculateDimensions());
+
+            // countdown timer
+            if (n.noObjects == 0) {
+                if (!n.activeOctants) {
+                    // ensure no child leaves
+                    if (n.currentLifespan == -1) {
+                        // initial check
+                        n.currentLifespan = n.maxLifespan;
+                    }
+                    else if (n.currentLifespan > 0) {
+                        // decrement
+                        n.currentLifespan--;
+                    }
+                }
+            }
+            else {
+                if (n.currentLifespan != -1) {
+                    if (n.maxLifespan <= 64) {
+                        // extend lifespan because "hotspot"
+                        n.maxLifespan <<= 2;
+                    }
+                }
+            }
+        }
+
+        /*
+            sweep the table linearly
+            - remove objects that don't exist anymore (in reverse, the swapped in object was already checked)
+            - transform moved objects
+        */
+        for (int i = (int)regions.size() - 1; i >= 0; i--) {
+            // remove if kill switch active
+            if (States::isActive(&regions[i].instance->state, INSTANCE_DEAD)) {
+                unlinkObject(i);
+                removeObject(i);
+            }
+        }
+
+        std::vector<unsigned int> movedObjects;
+        for (unsigned int i = 0, noObjects = regions.size(); i < noObjects; i++) {
+            BoundingRegion& br = regions[i];
+            if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+                // if moved switch active, transform region and push to list
+                br.transform();
+                movedObjects.push_back(i);
+            }
+            box.positions.push_back(br.calculateCenter());
+            box.sizes.push_back(br.calculateDimensions());
+        }
+
+        // remove dead branches
+        for (unsigned int idx = 0, noNodes = nodes.size(); idx < noNodes; idx++) {
+            if (!nodes[idx].code) {
+                continue;
+            }
+
+            for (int i = 0; i < NO_CHILDREN; i++) {
+                int childIdx = getChildIdx(idx, i);
+                if (childIdx != -1 && nodes[childIdx].currentLifespan == 0) {
+                    // active and run out of time
+                    if (nodes[childIdx].noObjects > 0 || nodes[childIdx].activeOctants) {
+                        // branch is dead but has children, so reset
+                        nodes[childIdx].currentLifespan = -1;
+                    }
+                    else {
+                        // branch is dead
+                        releaseChild(idx, i);
+                        stats->branchesPruned++;
+                    }
+                }
+            }
+        }
+
+        /*
+            move moved objects into new nodes
+            - objects only change lists here, so the indices in the table stay valid
+            - objects that left the root are removed from the table afterwards
+        */
+        std::vector<unsigned int> escaped;
+        for (unsigned int objIdx : movedObjects) {
+            BoundingRegion& movedObj = regions[objIdx];
+
+            // traverse up tree until find a node that completely encloses the object
+            unsigned int current = links[objIdx].cell;
+            while (!nodes[current].region.containsRegion(movedObj) &&
+                nodes[current].code != ROOT_CODE) {
+                current = nodes[current].parent;
+            }
+
+            // remove from list and insert into found region
+            unlinkObject(objIdx);
+            if (nodes[current].region.containsRegion(movedObj)) {
+                insertNode(current, objIdx);
+            }
+            else {
+                // left the root, return to queue
+                queue.push(movedObj);
+                escaped.push_back(objIdx);
+            }
+        }
+
+        // highest index first, so the object swapped into each slot is never one still to remove
+        for (int i = (int)escaped.size() - 1; i >= 0; i--) {
+            removeObject(escaped[i]);
+        }
+    }
+
+    processPending();
+
+    if (treeBuilt && tableDirty) {
+        sortObjects();
+    }
+}
+
+// process pending queue
+void Octree::LinearTree::processPending() {
+    stats->pendingProcessed += queue.size();
+    if (!treeBuilt) {
+        // add objects to be sorted into branches when built
+        while (queue.size() != 0) {
+            linkObject(addObject(queue.front()), 0);
+            queue.pop();
+        }
+        build();
+    }
+    else {
+        for (int i = 0, len = queue.size(); i < len; i++) {
+            BoundingRegion br = queue.front();
+            if (nodes[0].region.containsRegion(br)) {
+                // insert object immediately
+                insertNode(0, addObject(br));
+            }
+            else {
+                // return to queue (outside of the root, only update region if it moved)
+                if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+                    br.transform();
+                }
+                queue.push(br);
+            }
+            queue.pop();
+        }
+    }
+}
+
+// dynamically insert object into tree
+bool Octree::LinearTree::insert(BoundingRegion obj) {
+    unsigned int objIdx = addObject(obj);
+    if (!insertNode(0, objIdx)) {
+        // outside of the root
+        removeObject(objIdx);
+        return false;
+    }
+    return true;
+}
+
+// collect overlapping pairs (at least one moved) in one pass over the tree
+void Octree::LinearTree::collectPairs(std::vector<BroadphasePair>& pairs) {
+    std::vector<BoundingRegion*> ancestors;
+    collectPairsNode(0, pairs, ancestors);
+}
+
+// collect regions of moved instances (to query other structures with)
+void Octree::LinearTree::collectMoved(std::vector<BoundingRegion*>& moved) {
+    for (BoundingRegion& br : regions) {
+        if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+            moved.push_back(&br);
+        }
+    }
+}
+
+// check collisions with a ray (children are visited front to back)
+BoundingRegion* Octree::LinearTree::checkCollisionsRay(Ray r, float& tmin) {
+    float tmin_tmp = std::numeric_limits<float>::max();
+    float tmax_tmp = std::numeric_limits<float>::lowest();
+
+    stats->raysCast++;
+
+    // check root region
+    if (!r.intersectsBoundingRegion(nodes[0].region, tmin_tmp, tmax_tmp) ||
+        tmin_tmp >= tmin) {
+        // no collision or found nearer collision
+        return nullptr;
+    }
+
+    return checkCollisionsRayNode(0, r, tmin);
+}
+
+// check collisions with a batch of rays (nearest hit and distance for each ray, null if no hit)
+void Octree::LinearTree::checkCollisionsRays(std::vector<Ray>& rays, std::vector<BoundingRegion*>& hits, std::vector<float>& tmin) {
+    unsigned int noRays = rays.size();
+    hits.assign(noRays, nullptr);
+    tmin.assign(noRays, std::numeric_limits<float>::max());
+
+    // traverse once for each packet of rays
+    for (unsigned int i = 0; i < noRays; i += RAYPACKET_SIZE) {
+        unsigned int noPacketRays = std::min(noRays - i, (unsigned int)RAYPACKET_SIZE);
+        RayPacket packet(&rays[i], noPacketRays);
+        checkCollisionsPacketNode(0, packet, &rays[i], &hits[i], &tmin[i]);
+    }
+}
+
+// collect instances with a region in the view frustum (appended to the list of each model, no duplicates)
+void Octree::LinearTree::frustumCull(Frustum& frustum, VisibleInstances& visible) {
+    frustumCullNode(0, frustum, visible, false);
+
+    // objects waiting in the queue (outside of the tree) are tested directly
+    for (int i = 0, len = queue.size(); i < len; i++) {
+        BoundingRegion& br = queue.front();
+        if (frustum.intersectsRegion(br)) {
+            visible[br.instance->modelId].push_back(br.instance);
+        }
+        queue.push(br);
+        queue.pop();
+    }
+
+    // instances with multiple regions may have been added more than once, keep the first
+    std::unordered_set<RigidBody*> found;
+    for (auto& pair : visible) {
+        std::vector<RigidBody*>& list = pair.second;
+        unsigned int noUnique = 0;
+        for (unsigned int i = 0, len = list.size(); i < len; i++) {
+            if (found.insert(list[i]).second) {
+                list[noUnique++] = list[i];
+            }
+        }
+        list.resize(noUnique);
+    }
+}
+
+// add structure of the tree to the counters (call after the update)
+void Octree::LinearTree::collectStats() {
+    for (linearNode& n : nodes) {
+        if (!n.code) {
+            // free slot
+            continue;
+        }
+
+        // 3 bits per level below the sentinel bit
+        unsigned int depth = 0;
+        for (mortonCode code = n.code; code > ROOT_CODE; code = parentCode(code)) {
+            depth++;
+        }
+
+        stats->noNodes++;
+        stats->maxDepth = std::max(stats->maxDepth, depth);
+        stats->noObjects += n.noObjects;
+        stats->maxObjectsPerNode = std::max(stats->maxObjectsPerNode, n.noObjects);
+    }
+    stats->noQueued += queue.size();
+}
+
+// destroy object (free memory)
+void Octree::LinearTree::destroy() {
+    // keep the root (every entry point starts there), without children or objects
+    nodes.resize(1);
+    setupNode(0, ROOT_CODE, 0, nodes[0].region);
+    freeBlocks.clear();
+    regions.clear();
+    links.clear();
+    tableDirty = false;
+    while (queue.size() != 0) {
+        queue.pop();
+    }
+}
+
+/*
+    accessors
+*/
+
+// get index of node with code (-1 if not in tree)
+int Octree::LinearTree::getIdx(mortonCode code) {
+    if (!code) {
+        return -1;
+    }
+
+    // number of levels below the root
+    int depth = 0;
+    for (mortonCode c = code; c > ROOT_CODE; c = parentCode(c)) {
+        depth++;
+    }
+
+    // follow the octants from the top
+    int idx = 0;
+    for (int level = depth - 1; level >= 0 && idx != -1; level--) {
+        idx = getChildIdx(idx, (int)((code >> (3 * level)) & 7));
+    }
+    return idx;
+}
+
+/*
+    private functionality
+*/
+
+// set up slot in pool
+void Octree::LinearTree::setupNode(unsigned int idx, mortonCode code, unsigned int parent, BoundingRegion bounds) {
+    linearNode& n = nodes[idx];
+    n.code = code;
+    n.parent = parent;
+    n.firstChild = 0;
+    n.activeOctants = 0;
+    n.maxLifespan = 8;
+    n.currentLifespan = -1;
+    n.region = bounds;
+    n.firstObject = NO_OBJECT;
+    n.noObjects = 0;
+}
+
+// set up child in octant (the block of children is allocated with the first one)
+unsigned int Octree::LinearTree::allocateChild(unsigned int idx, int octant, BoundingRegion bounds) {
+    if (!nodes[idx].firstChild) {
+        unsigned int block;
+        if (freeBlocks.size() != 0) {
+            // reuse free block
+            block = freeBlocks.back();
+            freeBlocks.pop_back();
+        }
+        else {
+            // append new block of free slots
+            block = nodes.size();
+            nodes.resize(block + NO_CHILDREN);
+            for (int i = 0; i < NO_CHILDREN; i++) {
+                nodes[block + i].code = 0;
+            }
+        }
+        nodes[idx].firstChild = block;
+    }
+
+    unsigned int childIdx = nodes[idx].firstChild + octant;
+    setupNode(childIdx, childCode(nodes[idx].code, octant), idx, bounds);
+    States::activateIndex(&nodes[idx].activeOctants, octant);
+
+    return childIdx;
+}
+
+// return child in octant to the pool (the block is freed with the last one)
+void Octree::LinearTree::releaseChild(unsigned int idx, int octant) {
+    nodes[nodes[idx].firstChild + octant].code = 0;
+    States::deactivateIndex(&nodes[idx].activeOctants, octant);
+
+    if (!nodes[idx].activeOctants) {
+        freeBlocks.push_back(nodes[idx].firstChild);
+        nodes[idx].firstChild = 0;
+    }
+}
+
+// add object to the table (not in any node yet)
+unsigned int Octree::LinearTree::addObject(BoundingRegion& obj) {
+    regions.push_back(obj);
+    links.push_back({ 0, NO_OBJECT, NO_OBJECT });
+    tableDirty = true;
+    return regions.size() - 1;
+}
+
+// remove object from the table (must not be in any node)
+void Octree::LinearTree::removeObject(unsigned int objIdx) {
+    tableDirty = true;
+
+    unsigned int last = regions.size() - 1;
+    if (objIdx != last) {
+        // move last object into the slot and point its neighbours to it
+        regions[objIdx] = regions[last];
+        linearLink& link = links[objIdx];
+        link = links[last];
+        if (link.prev != NO_OBJECT) {
+            links[link.prev].next = objIdx;
+        }
+        else {
+            nodes[link.cell].firstObject = objIdx;
+        }
+        if (link.next != NO_OBJECT) {
+            links[link.next].prev = objIdx;
+        }
+    }
+    regions.pop_back();
+    links.pop_back();
+}
+
+// reorder the table so the objects of each node are consecutive, in depth first order of the nodes
+void Octree::LinearTree::sortObjects() {
+    sortedRegions.clear();
+    sortedLinks.clear();
+    sortedRegions.reserve(regions.size());
+    sortedLinks.reserve(regions.size());
+
+    sortStack.clear();
+    sortStack.push_back(0);
+    while (sortStack.size() != 0) {
+        unsigned int idx = sortStack.back();
+        sortStack.pop_back();
+
+        // copy list, each object links to its neighbours in the table
+        int first = sortedRegions.size();
+        for (int i = nodes[idx].firstObject; i != NO_OBJECT; i = links[i].next) {
+            int objIdx = sortedRegions.size();
+            sortedRegions.push_back(regions[i]);
+            sortedLinks.push_back({ idx, objIdx + 1, objIdx == first ? NO_OBJECT : objIdx - 1 });
+        }
+        if (nodes[idx].noObjects) {
+            sortedLinks.back().next = NO_OBJECT;
+            nodes[idx].firstObject = first;
+        }
+
+        // children (first octant on top)
+        for (int i = NO_CHILDREN - 1; i >= 0; i--) {
+            int childIdx = getChildIdx(idx, i);
+            if (childIdx != -1) {
+                sortStack.push_back(childIdx);
+            }
+        }
+    }
+
+    // the old table becomes the scratch buffer for the next sort
+    regions.swap(sortedRegions);
+    links.swap(sortedLinks);
+    tableDirty = false;
+}
+
+// add object to the list of a node
+void Octree::LinearTree::linkObject(unsigned int objIdx, unsigned int cell) {
+    linearLink& link = links[objIdx];
+    if (link.cell != cell) {
+        // objects of the node are no longer consecutive (relinking into the same node keeps them in place)
+        tableDirty = true;
+    }
+    link.cell = cell;
+    link.prev = NO_OBJECT;
+    link.next = nodes[cell].firstObject;
+    if (link.next != NO_OBJECT) {
+        links[link.next].prev = objIdx;
+    }
+    nodes[cell].firstObject = objIdx;
+    nodes[cell].noObjects++;
+}
+
+// remove object from the list of its node
+void Octree::LinearTree::unlinkObject(unsigned int objIdx) {
+    linearLink& link = links[objIdx];
+    if (link.prev != NO_OBJECT) {
+        links[link.prev].next = link.next;
+    }
+    else {
+        nodes[link.cell].firstObject = link.next;
+    }
+    if (link.next != NO_OBJECT) {
+        links[link.next].prev = link.prev;
+    }
+    link.next = link.prev = NO_OBJECT;
+    nodes[link.cell].noObjects--;
+}
+
+// build subtree starting at node
+void Octree::LinearTree::buildNode(unsigned int idx) {
+    // variable declarations
+    BoundingRegion octants[NO_CHILDREN];
+    glm::vec3 dimensions = nodes[idx].region.calculateDimensions();
+
+    /*
+        termination conditions (don't subdivide further)
+        - 1 or less objects (ie an empty leaf node or node with 1 object)
+        - dimensions are too small
+    */
+
+    // <= 1 objects
+    if (nodes[idx].noObjects <= 1) {
+        return;
+    }
+
+    // too small
+    for (int i = 0; i < 3; i++) {
+        if (dimensions[i] < MIN_BOUNDS) {
+            return;
+        }
+    }
+
+    // create regions
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        calculateBounds(octants[i], (Octant)(1 << i), nodes[idx].region);
+    }
+
+    // move objects into the octants that contain them (pool may grow, so only refer to nodes by index)
+    unsigned char newOctants = 0;
+    for (int objIdx = nodes[idx].firstObject, next; objIdx != NO_OBJECT; objIdx = next) {
+        next = links[objIdx].next;
+        for (int j = 0; j < NO_CHILDREN; j++) {
+            if (octants[j].containsRegion(regions[objIdx])) {
+                // octant contains region, generate new child for the first object
+                if (!States::isIndexActive(&newOctants, j)) {
+                    allocateChild(idx, j, octants[j]);
+                    States::activateIndex(&newOctants, j);
+                }
+                unlinkObject(objIdx);
+                linkObject(objIdx, nodes[idx].firstChild + j);
+                break;
+            }
+        }
+    }
+
+    // populate octants
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (States::isIndexActive(&newOctants, i)) {
+            buildNode(nodes[idx].firstChild + i);
+        }
+    }
+}
+
+// insert object (not in any node) into subtree starting at node
+bool Octree::LinearTree::insertNode(unsigned int idx, unsigned int objIdx) {
+    /*
+        termination conditions
+        - no objects (an empty leaf node)
+        - dimensions are less than MIN_BOUNDS
+    */
+
+    glm::vec3 dimensions = nodes[idx].region.calculateDimensions();
+    if (nodes[idx].noObjects == 0 ||
+        dimensions.x < MIN_BOUNDS ||
+        dimensions.y < MIN_BOUNDS ||
+        dimensions.z < MIN_BOUNDS
+        ) {
+        linkObject(objIdx, idx);
+        return true;
+    }
+
+    // safeguard if object doesn't fit
+    if (!nodes[idx].region.containsRegion(regions[objIdx])) {
+        return nodes[idx].code == ROOT_CODE
+            ? false
+            : insertNode(nodes[idx].parent, objIdx);
+    }
+
+    // create regions if not defined
+    BoundingRegion octants[NO_CHILDREN];
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        int childIdx = getChildIdx(idx, i);
+        if (childIdx != -1) {
+            // child exists, so take its region
+            octants[i] = nodes[childIdx].region;
+        }
+        else {
+            // get region for this octant
+            calculateBounds(octants[i], (Octant)(1 << i), nodes[idx].region);
+        }
+    }
+
+    linkObject(objIdx, idx);
+
+    // determine which octants to put objects in (pool may grow, so only refer to nodes by index)
+    unsigned char newOctants = 0;
+    for (int i = nodes[idx].firstObject, next; i != NO_OBJECT; i = next) {
+        next = links[i].next;
+        for (int j = 0; j < NO_CHILDREN; j++) {
+            if (octants[j].containsRegion(regions[i])) {
+                unlinkObject(i);
+                if (States::isIndexActive(&nodes[idx].activeOctants, j) &&
+                    !States::isIndexActive(&newOctants, j)) {
+                    // child exists
+                    insertNode(nodes[idx].firstChild + j, i);
+                }
+                else {
+                    // create new node for the first object
+                    if (!States::isIndexActive(&newOctants, j)) {
+                        allocateChild(idx, j, octants[j]);
+                        States::activateIndex(&newOctants, j);
+                    }
+                    linkObject(i, nodes[idx].firstChild + j);
+                }
+                break;
+            }
+        }
+    }
+
+    // build new octants
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (States::isIndexActive(&newOctants, i)) {
+            buildNode(nodes[idx].firstChild + i);
+        }
+    }
+
+    return true;
+}
+
+// coarse check two regions and add them to the buffer if they may collide (counted in the stats)
+void Octree::LinearTree::addPair(BoundingRegion& a, BoundingRegion& b, std::vector<BroadphasePair>& pairs) {
+    if (!Broadphase::needsCheck(a, b)) {
+        return;
+    }
+
+    stats->coarseTests++;
+    if (a.intersectsWith(b)) {
+        stats->coarsePassed++;
+        pairs.push_back({ &a, &b });
+    }
+}
+
+// collect overlapping pairs in subtree starting at node against itself and its ancestors
+void Octree::LinearTree::collectPairsNode(unsigned int idx, std::vector<BroadphasePair>& pairs, std::vector<BoundingRegion*>& ancestors) {
+    unsigned int noAncestors = ancestors.size();
+    for (int i = nodes[idx].firstObject; i != NO_OBJECT; i = links[i].next) {
+        // objects in the nodes above
+        for (unsigned int j = 0; j < noAncestors; j++) {
+            addPair(*ancestors[j], regions[i], pairs);
+        }
+
+        // objects later in the same node
+        for (int j = links[i].next; j != NO_OBJECT; j = links[j].next) {
+            addPair(regions[i], regions[j], pairs);
+        }
+
+        // visible to the nodes below
+        ancestors.push_back(&regions[i]);
+    }
+
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        int childIdx = getChildIdx(idx, i);
+        if (childIdx != -1) {
+            collectPairsNode(childIdx, pairs, ancestors);
+        }
+    }
+    ancestors.resize(noAncestors);
+}
+
+// check collisions with a ray in subtree starting at node (the ray already entered the region)
+BoundingRegion* Octree::LinearTree::checkCollisionsRayNode(unsigned int idx, Ray& r, float& tmin) {
+    float tmin_tmp = std::numeric_limits<float>::max();
+    float tmax_tmp = std::numeric_limits<float>::lowest();
+    float t_tmp = std::numeric_limits<float>::max();
+
+    stats->rayNodesVisited++;
+
+    BoundingRegion* ret = nullptr, * ret_tmp = nullptr;
+
+    // check objects in the node
+    for (int i = nodes[idx].firstObject; i != NO_OBJECT; i = links[i].next) {
+        BoundingRegion& br = regions[i];
+        tmin_tmp = std::numeric_limits<float>::max();
+        tmax_tmp = std::numeric_limits<float>::lowest();
+
+        // coarse check - check against BR
+        if (r.intersectsBoundingRegion(br, tmin_tmp, tmax_tmp)) {
+            if (tmin_tmp > tmin) {
+                continue;
+            }
+            else if (br.collisionMesh) {
+                // fine grain check with collision mesh
+                t_tmp = std::numeric_limits<float>::max();
+                if (r.intersectsMesh(br.collisionMesh, br.instance, t_tmp)) {
+                    if (t_tmp < tmin) {
+                        // found closer collision
+                        tmin = t_tmp;
+                        ret = &br;
+                    }
+                }
+            }
+            else {
+                // rely on coarse check
+                if (tmin_tmp < tmin) {
+                    tmin = tmin_tmp;
+                    ret = &br;
+                }
+            }
+        }
+    }
+
+    // find children the ray enters before the nearest collision
+    RayEntry entries[NO_CHILDREN];
+    int noEntries = 0;
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        int childIdx = getChildIdx(idx, i);
+        if (childIdx != -1 &&
+            r.intersectsBoundingRegion(nodes[childIdx].region, tmin_tmp, tmax_tmp) &&
+            tmin_tmp < tmin) {
+            entries[noEntries++] = { childIdx, tmin_tmp };
+        }
+    }
+
+    // check children front to back
+    sortRayEntries(entries, noEntries);
+    for (int i = 0; i < noEntries; i++) {
+        if (entries[i].t >= tmin) {
+            // this and all further children are entered behind the nearest collision
+            break;
+        }
+
+        ret_tmp = checkCollisionsRayNode(entries[i].idx, r, tmin);
+        if (ret_tmp) {
+            ret = ret_tmp;
+        }
+    }
+
+    return ret;
+}
+
+// collect instances with a region in the view frustum in subtree starting at node (skip tests if inside is set)
+void Octree::LinearTree::frustumCullNode(unsigned int idx, Frustum& frustum, VisibleInstances& visible, bool inside) {
+    if (!inside) {
+        FrustumTest res = frustum.testRegion(nodes[idx].region);
+        if (res == FrustumTest::OUTSIDE) {
+            // cell and all objects in it are out of view
+            return;
+        }
+        // if the cell is completely in view, so is everything below
+        inside = res == FrustumTest::INSIDE;
+    }
+
+    // check objects in the node
+    for (int i = nodes[idx].firstObject; i != NO_OBJECT; i = links[i].next) {
+        BoundingRegion& br = regions[i];
+        if (inside || frustum.intersectsRegion(br)) {
+            visible[br.instance->modelId].push_back(br.instance);
+        }
+    }
+
+    // check children
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        int childIdx = getChildIdx(idx, i);
+        if (childIdx != -1) {
+            frustumCullNode(childIdx, frustum, visible, inside);
+        }
+    }
+}
+
+// check collisions with a packet of rays in subtree starting at node
+void Octree::LinearTree::checkCollisionsPacketNode(unsigned int idx, RayPacket& packet, Ray* rays, BoundingRegion** hits, float* tmin) {
+    float tmin_tmp[RAYPACKET_SIZE];
+    float t_tmp;
+
+    // check current region
+    unsigned int mask = packet.intersectsBoundingRegion(nodes[idx].region, tmin_tmp);
+    for (unsigned int i = 0; i < packet.noRays; i++) {
+        if (tmin_tmp[i] >= tmin[i]) {
+            // ray found nearer collision
+            mask &= ~(1u << i);
+        }
+    }
+    if (!mask) {
+        // no ray left to check in this region
+        return;
+    }
+
+    // check objects in the node
+    for (int objIdx = nodes[idx].firstObject; objIdx != NO_OBJECT; objIdx = links[objIdx].next) {
+        BoundingRegion& br = regions[objIdx];
+
+        // coarse check - check against BR
+        unsigned int objMask = packet.intersectsBoundingRegion(br, tmin_tmp) & mask;
+
+        for (unsigned int i = 0; objMask; objMask >>= 1, i++) {
+            if (!(objMask & 1) || tmin_tmp[i] > tmin[i]) {
+                continue;
+            }
+            else if (br.collisionMesh) {
+                // fine grain check with collision mesh
+                t_tmp = std::numeric_limits<float>::max();
+                if (rays[i].intersectsMesh(br.collisionMesh, br.instance, t_tmp)) {
+                    if (t_tmp < tmin[i]) {
+                        // found closer collision
+                        tmin[i] = t_tmp;
+                        hits[i] = &br;
+                    }
+                }
+            }
+            else if (tmin_tmp[i] < tmin[i]) {
+                // rely on coarse check
+                tmin[i] = tmin_tmp[i];
+                hits[i] = &br;
+            }
+        }
+    }
+
+    // check children
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        int childIdx = getChildIdx(idx, i);
+        if (childIdx != -1) {
+            checkCollisionsPacketNode(childIdx, packet, rays, hits, tmin);
+        }
+    }
+}
@@ -0,0 +1,232 @@
+#ifndef LINEAROCTREE_H
+#define LINEAROCTREE_H
+
+#include <vector>
+#include <queue>
+
+#include "octree.h"
+
+/*
+    linear octree
+    - all nodes live in one contiguous pool
+    - each node is labelled with its locational (Morton) code
+        root = 1, child of code c in octant i = (c << 3) | i
+    - the children of a node are allocated as one block of NO_CHILDREN consecutive slots,
+        so the index of a child is the index of the block plus the octant
+    - all objects live in one contiguous table, each node links the objects it holds
+        (removed objects are swapped with the last one, the table is put back in tree order after an update that changed it)
+    - kept as the plain reference tree: empty branches are pruned by the original lifespan countdown,
+        the split/merge policy (SplitPolicy) is only implemented by Octree::node
+    - cells are tight, loose mode (looseness) is only implemented by Octree::node
+    - regions live in its own table, not in the shared BoundsTable with stable handles and SoA bounds
+*/
+
+namespace Octree {
+    // type of a locational code (1 sentinel bit + 3 bits per level)
+    typedef unsigned long long mortonCode;
+
+    // code of the root node
+    const mortonCode ROOT_CODE = 1;
+
+    // get code of the child in octant idx
+    inline mortonCode childCode(mortonCode code, int idx) {
+        return (code << 3) | (mortonCode)idx;
+    }
+
+    // get code of the parent
+    inline mortonCode parentCode(mortonCode code) {
+        return code >> 3;
+    }
+
+    // index of no object in the table
+    const int NO_OBJECT = -1;
+
+    /*
+        structure to represent each node in the pool
+    */
+    struct linearNode {
+        // locational code (0 if the slot is free)
+        mortonCode code;
+
+        // index of the parent (root points to itself)
+        unsigned int parent;
+        // index of the block of children (0 if no block, the root is never a child)
+        unsigned int firstChild;
+
+        // switch for active octants
+        unsigned char activeOctants;
+
+        // maximum possible lifespan
+        short maxLifespan;
+        // current lifespan
+        short currentLifespan;
+
+        // region of bounds of cell (AABB)
+        BoundingRegion region;
+
+        // first object in the list of the node
+        int firstObject;
+        // number of objects in the list
+        unsigned int noObjects;
+    };
+
+    /*
+        structure to link each object in the table into the list of its node
+    */
+    struct linearLink {
+        // index of the node holding the object
+        unsigned int cell;
+
+        // neighbours in the list of the node
+        int next;
+        int prev;
+    };
+
+    /*
+        class to represent the whole linear octree
+    */
+    class LinearTree {
+    public:
+        // contiguous pool of nodes (root is at index 0)
+        std::vector<linearNode> nodes;
+        // indices of free blocks of children in the pool
+        std::vector<unsigned int> freeBlocks;
+
+        // contiguous table of objects in the tree (regions kept apart from the links, the pair tests only read regions)
+        std::vector<BoundingRegion> regions;
+        std::vector<linearLink> links;
+        // if objects were added, removed or moved to another node since the table was put in tree order
+        bool tableDirty = false;
+
+        // if tree is ready
+        bool treeReady = false;
+        // if tree is built
+        bool treeBuilt = false;
+
+        // queue of objects to be dynamically inserted
+        std::queue<BoundingRegion> queue;
+
+        // counters for the current frame
+        TreeStats* stats;
+
+    private:
+        // scratch buffers to put the table in tree order (kept to reuse their memory)
+        std::vector<BoundingRegion> sortedRegions;
+        std::vector<linearLink> sortedLinks;
+        std::vector<unsigned int> sortStack;
+
+    public:
+
+        /*
+            constructor
+        */
+
+        // initialize with bounds of the root (no objects yet)
+        LinearTree(BoundingRegion bounds);
+
+        // free counters
+        ~LinearTree();
+
+        /*
+            functionality
+        */
+
+        // add instance to pending queue
+        void addToPending(RigidBody* instance, Model* model);
+
+        // build tree (called during initialization)
+        void build();
+
+        // update objects in tree (called during each iteration of main loop)
+        void update(Box& box);
+
+        // process pending queue
+        void processPending();
+
+        // dynamically insert object into tree
+        bool insert(BoundingRegion obj);
+
+        // collect overlapping pairs (at least one moved) in one pass over the tree
+        void collectPairs(std::vector<BroadphasePair>& pairs);
+
+        // collect regions of moved instances (to query other structures with)
+        void collectMoved(std::vector<BoundingRegion*>& moved);
+
+        // check collisions with a ray (children are visited front to back)
+        BoundingRegion* checkCollisionsRay(Ray r, float& tmin);
+
+        // check collisions with a batch of rays (nearest hit and distance for each ray, null if no hit)
+        void checkCollisionsRays(std::vector<Ray>& rays, std::vector<BoundingRegion*>& hits, std::vector<float>& tmin);
+
+        // collect instances with a region in the view frustum (appended to the list of each model, no duplicates)
+        void frustumCull(Frustum& frustum, VisibleInstances& visible);
+
+        // add structure of the tree to the counters (call after the update)
+        void collectStats();
+
+        // destroy object (free memory, the root is kept empty)
+        void destroy();
+
+        /*
+            accessors
+        */
+
+        // get index of node with code (-1 if not in tree)
+        int getIdx(mortonCode code);
+
+        // get index of child in octant (-1 if inactive)
+        int getChildIdx(unsigned int idx, int octant) {
+            return States::isIndexActive(&nodes[idx].activeOctants, octant)
+                ? (int)nodes[idx].firstChild + octant
+                : -1;
+        }
+
+    private:
+        // set up slot in pool
+        void setupNode(unsigned int idx, mortonCode code, unsigned int parent, BoundingRegion bounds);
+
+        // set up child in octant (the block of children is allocated with the first one)
+        unsigned int allocateChild(unsigned int idx, int octant, BoundingRegion bounds);
+
+        // return child in octant to the pool (the block is freed with the last one)
+        void releaseChild(unsigned int idx, int octant);
+
+        // add object to the table (not in any node yet)
+        unsigned int addObject(BoundingRegion& obj);
+
+        // remove object from the table (must not be in any node)
+        void removeObject(unsigned int objIdx);
+
+        // reorder the table so the objects of each node are consecutive, in depth first order of the nodes
+        void sortObjects();
+
+        // add object to the list of a node
+        void linkObject(unsigned int objIdx, unsigned int cell);
+
+        // remove object from the list of its node
+        void unlinkObject(unsigned int objIdx);
+
+        // build subtree starting at node
+        void buildNode(unsigned int idx);
+
+        // insert object (not in any node) into subtree starting at node
+        bool insertNode(unsigned int idx, unsigned int objIdx);
+
+        // coarse check two regions and add them to the buffer if they may collide (counted in the stats)
+        void addPair(BoundingRegion& a, BoundingRegion& b, std::vector<BroadphasePair>& pairs);
+
+        // collect overlapping pairs in subtree starting at node against itself and the objects of its ancestors
+        void collectPairsNode(unsigned int idx, std::vector<BroadphasePair>& pairs, std::vector<BoundingRegion*>& ancestors);
+
+        // check collisions with a ray in subtree starting at node (the ray already entered the region)
+        BoundingRegion* checkCollisionsRayNode(unsigned int idx, Ray& r, float& tmin);
+
+        // check collisions with a packet of rays in subtree starting at node
+        void checkCollisionsPacketNode(unsigned int idx, RayPacket& packet, Ray* rays, BoundingRegion** hits, float* tmin);
+
+        // collect instances with a region in the view frustum in subtree starting at node (skip tests if inside is set)
+        void frustumCullNode(unsigned int idx, Frustum& frustum, VisibleInstances& visible, bool inside);
+    };
+}
+
+#endif
@@ -56,6 +56,20 @@ glm::vec3 mat4vec3mult(glm::mat4& m, glm::vec3& v) {
     return ret;
 }
 
+void transformBounds(glm::mat4& m, glm::vec3& min, glm::vec3& max) {
+    glm::vec3 center = (min + max) / 2.0f;
+    glm::vec3 halfDimensions = (max - min) / 2.0f;
+
+    // each new half dimension is the largest reach of the transformed box along that axis
+    glm::vec3 newCenter = mat4vec3mult(m, center);
+    glm::vec3 newHalfDimensions = glm::abs(glm::vec3(m[0])) * halfDimensions[0]
+        + glm::abs(glm::vec3(m[1])) * halfDimensions[1]
+        + glm::abs(glm::vec3(m[2])) * halfDimensions[2];
+
+    min = newCenter - newHalfDimensions;
+    max = newCenter + newHalfDimensions;
+}
+
 glm::vec3 linCombSolution(glm::vec3 A, glm::vec3 B, glm::vec3 C, glm::vec3 point) {
     // represent the point as a linear combination of the 3 basis vectors
     glm::mat4x3 m(A, B, C, point);
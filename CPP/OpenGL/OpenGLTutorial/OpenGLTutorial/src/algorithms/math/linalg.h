@@ -50,6 +50,9 @@ LinePlaneIntCase linePlaneIntersection(glm::vec3 P1, glm::vec3 norm, glm::vec3 U
 
 glm::vec3 mat4vec3mult(glm::mat4& m, glm::vec3& v);
 
+// get bounds of a box after an affine transformation (still axis aligned, so may grow)
+void transformBounds(glm::mat4& m, glm::vec3& min, glm::vec3& max);
+
 glm::vec3 linCombSolution(glm::vec3 A, glm::vec3 B, glm::vec3 C, glm::vec3 point);
 
 bool faceContainsPointRange(glm::vec3 A, glm::vec3 B, glm::vec3 N, glm::vec3 point, float radius);
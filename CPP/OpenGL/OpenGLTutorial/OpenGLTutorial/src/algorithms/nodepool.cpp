@@ -0,0 +1,124 @@
+#include "nodepool.h"
+
+#include <cstring>
+
+/*
+    constructor
+*/
+
+// initialize with size of each chunk (no memory reserved yet)
+NodePool::NodePool(size_t chunkSize)
+    : currentChunk(0), offset(0), chunkSize(chunkSize),
+    liveNodes(0), bytesReserved(0), bytesUsed(0) {
+    memset(freeLists, 0, sizeof(freeLists));
+}
+
+// free all chunks
+NodePool::~NodePool() {
+    for (chunk& c : chunks) {
+        ::operator delete(c.data);
+    }
+}
+
+/*
+    functionality
+*/
+
+// get block of at least bytes
+void* NodePool::allocate(size_t bytes) {
+    unsigned int sizeClass = getClass(bytes);
+    size_t blockSize = (size_t)POOL_MIN_BLOCK << sizeClass;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bytesUsed += blockSize;
+
+    // reuse freed block
+    if (freeLists[sizeClass]) {
+        void* ret = freeLists[sizeClass];
+        freeLists[sizeClass] = *(void**)ret;
+        return ret;
+    }
+
+    // find chunk with room for the block (rest of skipped chunks is unused until reset)
+    while (currentChunk < chunks.size() &&
+        offset + blockSize > chunks[currentChunk].size) {
+        currentChunk++;
+        offset = 0;
+    }
+
+    if (currentChunk == chunks.size()) {
+        // reserve new chunk
+        chunk c;
+        c.size = blockSize > chunkSize ? blockSize : chunkSize;
+        c.data = (char*)::operator new(c.size);
+        chunks.push_back(c);
+        bytesReserved += c.size;
+        offset = 0;
+    }
+
+    void* ret = chunks[currentChunk].data + offset;
+    offset += blockSize;
+    return ret;
+}
+
+// return block of bytes to its free list
+void NodePool::deallocate(void* ptr, size_t bytes) {
+    if (!ptr) {
+        return;
+    }
+
+    unsigned int sizeClass = getClass(bytes);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bytesUsed -= (size_t)POOL_MIN_BLOCK << sizeClass;
+
+    // push on free list
+    *(void**)ptr = freeLists[sizeClass];
+    freeLists[sizeClass] = ptr;
+}
+
+// recycle all blocks at once (chunks stay reserved)
+void NodePool::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    currentChunk = 0;
+    offset = 0;
+    memset(freeLists, 0, sizeof(freeLists));
+
+    liveNodes = 0;
+    bytesUsed = 0;
+}
+
+/*
+    accessors
+*/
+
+// number of nodes currently constructed in the pool
+unsigned int NodePool::getLiveNodes() {
+    return liveNodes;
+}
+
+// bytes reserved from the system
+size_t NodePool::getBytesReserved() {
+    return bytesReserved;
+}
+
+// bytes in blocks that are currently handed out
+size_t NodePool::getBytesUsed() {
+    return bytesUsed;
+}
+
+/*
+    private methods
+*/
+
+// get index of the block size that fits bytes
+unsigned int NodePool::getClass(size_t bytes) {
+    unsigned int ret = 0;
+    size_t blockSize = POOL_MIN_BLOCK;
+    while (blockSize < bytes) {
+        blockSize <<= 1;
+        ret++;
+    }
+    return ret;
+}
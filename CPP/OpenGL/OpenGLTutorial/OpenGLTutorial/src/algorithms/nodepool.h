@@ -0,0 +1,174 @@
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include <vector>
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+
+#define POOL_CHUNK_SIZE 65536   // bytes reserved at once
+#define POOL_MIN_BLOCK 16       // smallest block handed out (also the alignment)
+#define POOL_NO_CLASSES 40      // number of block sizes (POOL_MIN_BLOCK << i)
+
+/*
+    pool for tree nodes and their object storage
+    - memory is reserved in chunks and handed out in blocks rounded up to a power of 2
+    - freed blocks go on a free list for their size and are reused first
+    - reset() recycles every block at once without touching them, so everything allocated
+        from the pool must be trivially destructible or only own memory from the same pool
+*/
+
+class NodePool {
+public:
+    /*
+        constructor
+    */
+
+    // initialize with size of each chunk (no memory reserved yet)
+    NodePool(size_t chunkSize = POOL_CHUNK_SIZE);
+
+    // free all chunks
+    ~NodePool();
+
+    /*
+        functionality
+    */
+
+    // get block of at least bytes
+    void* allocate(size_t bytes);
+
+    // return block of bytes to its free list
+    void deallocate(void* ptr, size_t bytes);
+
+    // construct node in the pool
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        T* ret = new (allocate(sizeof(T))) T(std::forward<Args>(args)...);
+        liveNodes++;
+        return ret;
+    }
+
+    // destruct node and return it to the pool
+    template <typename T>
+    void release(T* obj) {
+        obj->~T();
+        deallocate(obj, sizeof(T));
+        liveNodes--;
+    }
+
+    // recycle all blocks at once (chunks stay reserved)
+    void reset();
+
+    /*
+        accessors
+    */
+
+    // number of nodes currently constructed in the pool
+    unsigned int getLiveNodes();
+
+    // bytes reserved from the system
+    size_t getBytesReserved();
+
+    // bytes in blocks that are currently handed out
+    size_t getBytesUsed();
+
+private:
+    /*
+        structure to represent each chunk of reserved memory
+    */
+    struct chunk {
+        char* data;
+        size_t size;
+    };
+
+    // reserved chunks (reused in order after a reset)
+    std::vector<chunk> chunks;
+    // chunk currently being handed out
+    unsigned int currentChunk;
+    // offset of next free byte in the current chunk
+    size_t offset;
+
+    // heads of free lists for each block size (next pointer is stored in the block)
+    void* freeLists[POOL_NO_CLASSES];
+
+    // default size of each chunk
+    size_t chunkSize;
+
+    // statistics
+    std::atomic<unsigned int> liveNodes;
+    size_t bytesReserved;
+    size_t bytesUsed;
+
+    // pool is shared by worker threads when building
+    std::mutex mutex;
+
+    // get index of the block size that fits bytes
+    static unsigned int getClass(size_t bytes);
+};
+
+/*
+    allocator for standard containers that takes memory from a node pool
+    - uses the global heap if no pool is set
+    - moves/swaps carry the pool with the memory
+*/
+
+template <typename T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    // pool to take memory from (global heap if null)
+    NodePool* pool;
+
+    /*
+        constructors
+    */
+
+    // initialize with pool
+    PoolAllocator(NodePool* pool = nullptr)
+        : pool(pool) {}
+
+    // convert from allocator of another type
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other)
+        : pool(other.pool) {}
+
+    /*
+        functionality
+    */
+
+    // get memory for n values
+    T* allocate(size_t n) {
+        return pool
+            ? (T*)pool->allocate(n * sizeof(T))
+            : (T*)::operator new(n * sizeof(T));
+    }
+
+    // return memory of n values
+    void deallocate(T* ptr, size_t n) {
+        if (pool) {
+            pool->deallocate(ptr, n * sizeof(T));
+        }
+        else {
+            ::operator delete(ptr);
+        }
+    }
+};
+
+// allocators are interchangeable if they use the same pool
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b) {
+    return a.pool == b.pool;
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b) {
+    return a.pool != b.pool;
+}
+
+#endif
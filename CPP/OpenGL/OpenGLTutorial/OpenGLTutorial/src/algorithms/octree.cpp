@@ -2,6 +2,10 @@
 #include "avl.h"
 #include "../graphics/models/box.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <functional>
+
 // calculate bounds of specified quadrant in bounding region
 void Octree::calculateBounds(BoundingRegion &out, Octant octant, BoundingRegion parentRegion) {
     // find min and max points of corresponding octant
@@ -33,23 +37,359 @@ void Octree::calculateBounds(BoundingRegion &out, Octant octant, BoundingRegion
     }
 }
 
+// fine grain check between two regions that passed the coarse check (contact for obj to respond to br)
+bool Octree::checkCollisionsFine(BoundingRegion &br, BoundingRegion &obj, Contact &contact) {
+    unsigned int noFacesBr = br.collisionMesh ? br.collisionMesh->faces.size() : 0;
+    unsigned int noFacesObj = obj.collisionMesh ? obj.collisionMesh->faces.size() : 0;
+
+    contact.br = &br;
+    contact.obj = &obj;
+
+    if (noFacesBr) {
+        if (noFacesObj) {
+            // both have collision meshes
+            // traverse the face hierarchies of br and obj together
+            contact.type = 1;
+            return br.collisionMesh->collidesWithMesh(
+                br.instance,
+                obj.collisionMesh,
+                obj.instance,
+                contact.normal,
+                contact.depth,
+                contact.point
+            );
+        }
+        else {
+            // br has a collision mesh, obj does not
+            // check faces in br near the obj's sphere
+            contact.type = 2;
+            return br.collisionMesh->collidesWithSphere(
+                br.instance,
+                obj,
+                contact.normal,
+                contact.depth,
+                contact.point
+            );
+        }
+    }
+    else {
+        if (noFacesObj) {
+            // obj has a collision mesh, br does not
+            // check faces in obj near br's sphere
+            contact.type = 3;
+            return obj.collisionMesh->collidesWithSphere(
+                obj.instance,
+                br,
+                contact.normal,
+                contact.depth,
+                contact.point
+            );
+        }
+        else {
+            // neither have a collision mesh
+            // coarse grain test pased (test collision between spheres)
+            contact.type = 4;
+            contact.normal = obj.center - br.center;
+
+            float distance = glm::length(contact.normal);
+            contact.depth = br.radius + obj.radius - distance;
+            contact.point = distance > 0.0f
+                ? br.center + contact.normal * (br.radius / distance)
+                : br.center;
+
+            return true;
+        }
+    }
+}
+
+// sort entries by entry distance (nearest first)
+void Octree::sortRayEntries(RayEntry* entries, int noEntries) {
+    // insertion sort, at most NO_CHILDREN entries
+    for (int i = 1; i < noEntries; i++) {
+        RayEntry entry = entries[i];
+        int j = i - 1;
+        for (; j >= 0 && entries[j].t > entry.t; j--) {
+            entries[j + 1] = entries[j];
+        }
+        entries[j + 1] = entry;
+    }
+}
+
+/*
+    bounds table
+*/
+
+// add record held by cell, returns its index
+unsigned int Octree::BoundsTable::add(BoundingRegion br, node* cell, bool inQueue) {
+    br.cell = cell;
+    regions.push_back(br);
+    queued.push_back(inQueue);
+    return regions.size() - 1;
+}
+
+// set node holding record
+void Octree::BoundsTable::setCell(unsigned int idx, node* cell, bool inQueue) {
+    regions[idx].cell = cell;
+    queued[idx] = inQueue;
+    cell->boundsDirty = true;
+}
+
+// remove record (the last record takes its index)
+void Octree::BoundsTable::remove(unsigned int idx) {
+    unsigned int last = regions.size() - 1;
+    if (idx != last) {
+        // move last record into the slot and update the node holding it
+        regions[idx] = regions[last];
+        queued[idx] = queued[last];
+        if (regions[idx].cell) {
+            regions[idx].cell->replaceObject(last, idx, queued[idx]);
+        }
+    }
+
+    regions.pop_back();
+    queued.pop_back();
+}
+
+// remove all records
+void Octree::BoundsTable::clear() {
+    regions.clear();
+    queued.clear();
+}
+
 /*
     constructors
 */
 
 // default
 Octree::node::node()
-    : region(BoundTypes::AABB) {}
+    : table(new BoundsTable()), stats(new TreeStats()), region(BoundTypes::AABB) {}
 
 // initialize with bounds (no objects yet)
 Octree::node::node(BoundingRegion bounds)
-    : region(bounds) {}
+    : table(new BoundsTable()), stats(new TreeStats()), region(bounds) {}
 
 // initialize with bounds and list of objects
-Octree::node::node(BoundingRegion bounds, std::vector<BoundingRegion> objectList)
-    : region(bounds) {
-    // insert entire list of objects
-    objects.insert(objects.end(), objectList.begin(), objectList.end());
+Octree::node::node(BoundingRegion bounds, objectList objectList)
+    : objects(std::move(objectList)), queue(objects.get_allocator()),
+    objectBounds(objects.get_allocator()), region(bounds) {}
+
+// free table and counters if root
+Octree::node::~node() {
+    if (!parent) {
+        delete table;
+        delete stats;
+    }
+}
+
+/*
+    placement
+*/
+
+// get bounds used for containment and culling (region scaled by looseness)
+BoundingRegion Octree::node::looseRegion() {
+    return looseRegion(region);
+}
+
+// get loose bounds of a cell with region bounds
+BoundingRegion Octree::node::looseRegion(BoundingRegion& bounds) {
+    if (looseness == 1.0f) {
+        return bounds;
+    }
+
+    glm::vec3 center = bounds.calculateCenter();
+    glm::vec3 halfDimensions = bounds.calculateDimensions() * (0.5f * looseness);
+    return BoundingRegion(center - halfDimensions, center + halfDimensions);
+}
+
+// determine if object can be stored in this node
+bool Octree::node::fits(BoundingRegion& obj) {
+    if (looseness == 1.0f) {
+        return region.containsRegion(obj);
+    }
+
+    return looseRegion().containsRegion(obj);
+}
+
+// determine if the objects of this node should be split into children (see SplitPolicy)
+bool Octree::node::shouldSplit() {
+    return objects.size() > policy.splitObjects ||
+        (objects.size() >= policy.mergeObjects && queryCost > policy.splitCost);
+}
+
+// get index of octant to place object in (-1 if it stays in this node)
+int Octree::node::getOctant(BoundingRegion& obj, BoundingRegion octants[NO_CHILDREN]) {
+    if (looseness == 1.0f) {
+        // tight: first octant that completely contains the object
+        for (int i = 0; i < NO_CHILDREN; i++) {
+            if (octants[i].containsRegion(obj)) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /*
+        loose: octant is picked by the center of the object
+        - z decides between O1-O4 (+) and O5-O8 (-)
+        - x, y go counterclockwise from (+, +) as in calculateBounds
+        then the object has to fit in the loose bounds of that octant
+    */
+    glm::vec3 center = region.calculateCenter();
+    glm::vec3 objCenter = obj.calculateCenter();
+
+    int idx = objCenter.z >= center.z ? 0 : 4;
+    if (objCenter.y >= center.y) {
+        idx += objCenter.x >= center.x ? 0 : 1;
+    }
+    else {
+        idx += objCenter.x >= center.x ? 3 : 2;
+    }
+
+    return looseRegion(octants[idx]).containsRegion(obj) ? idx : -1;
+}
+
+/*
+    memory
+*/
+
+// set up empty lists that take memory from the pool
+void Octree::node::initLists(objectList lists[NO_CHILDREN]) {
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        lists[i] = objectList(PoolAllocator<BoundingRegion>(pool));
+    }
+}
+
+// create child in octant with bounds and list of objects (from the pool if set)
+Octree::node* Octree::node::createChild(int octant, BoundingRegion bounds, objectList& list) {
+    node* child = pool
+        ? pool->create<node>(bounds, std::move(list))
+        : new node(bounds, std::move(list));
+
+    // inherit settings
+    child->parent = this;
+    child->threadPool = threadPool;
+    child->pool = pool;
+    child->table = table;
+    child->stats = stats;
+    child->looseness = looseness;
+    child->policy = policy;
+
+    children[octant] = child;
+    States::activateIndex(&activeOctants, octant); // activate octant
+
+    return child;
+}
+
+// release child in octant and its subtree (back to the pool if set, records leave the table or go to the task)
+void Octree::node::releaseChild(int octant, UpdateTask* task) {
+    node* child = children[octant];
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (States::isIndexActive(&child->activeOctants, i)) {
+            child->releaseChild(i, task);
+        }
+    }
+
+    // remove records of the child (records moved into freed slots update their own node)
+    while (child->objects.size() != 0) {
+        unsigned int idx = child->objects.back();
+        child->objects.pop_back();
+        removeRecord(idx, task);
+    }
+    while (child->queue.size() != 0) {
+        unsigned int idx = child->queue.back();
+        child->queue.pop_back();
+        removeRecord(idx, task);
+    }
+
+    if (pool) {
+        pool->release(child);
+    }
+    else {
+        delete child;
+    }
+
+    children[octant] = nullptr;
+    States::deactivateIndex(&activeOctants, octant);
+}
+
+// move objects and queued objects of the subtree starting at child into this node
+void Octree::node::takeObjects(node* child) {
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (States::isIndexActive(&child->activeOctants, i)) {
+            takeObjects(child->children[i]);
+        }
+    }
+
+    for (unsigned int idx : child->objects) {
+        objects.push_back(idx);
+        table->setCell(idx, this, false);
+    }
+    child->objects.clear();
+    child->boundsDirty = true;
+    boundsDirty = true;
+
+    for (unsigned int idx : child->queue) {
+        queue.push_back(idx);
+        table->setCell(idx, this, true);
+    }
+    child->queue.clear();
+}
+
+// replace index of record held in this node (after the record was moved in the table)
+void Octree::node::replaceObject(unsigned int from, unsigned int to, bool inQueue) {
+    if (inQueue) {
+        std::replace(queue.begin(), queue.end(), from, to);
+    }
+    else {
+        std::replace(objects.begin(), objects.end(), from, to);
+        boundsDirty = true;
+    }
+}
+
+// copy bounds of the objects into objectBounds if they changed
+void Octree::node::refreshBounds() {
+    if (!boundsDirty) {
+        return;
+    }
+
+    objectBounds.resize(objects.size());
+    for (unsigned int i = 0, len = objects.size(); i < len; i++) {
+        objectBounds.set(i, table->regions[objects[i]]);
+    }
+    boundsDirty = false;
+}
+
+// refresh bounds of every node in the subtree (subtrees at PARALLEL_UPDATE_DEPTH are added to the counter if set)
+void Octree::node::refreshBoundsTree(unsigned int depth, TaskCounter* counter) {
+    if (counter && depth == PARALLEL_UPDATE_DEPTH) {
+        threadPool->push([this]() -> void {
+            refreshBoundsTree(0, nullptr);
+        }, counter);
+        return;
+    }
+
+    refreshBounds();
+    for (unsigned char flags = activeOctants, i = 0;
+        flags > 0;
+        flags >>= 1, i++) {
+        if (States::isIndexActive(&flags, 0) && children[i]) {
+            children[i]->refreshBoundsTree(depth + 1, counter);
+        }
+    }
+}
+
+// test region against objects [start, end) of this node, results[i - start] is 1 if they overlap
+// (one at a time if the copy of the bounds is out of date, queries do not change the node)
+void Octree::node::testObjects(BoundingRegion& br, unsigned int start, unsigned int end, unsigned char* results) {
+    if (!boundsDirty) {
+        objectBounds.intersectsWith(br, start, end, results);
+        return;
+    }
+
+    // objects changed outside of an update (processPending or build without update)
+    for (unsigned int i = start; i < end; i++) {
+        results[i - start] = br.intersectsWith(table->regions[objects[i]]) ? 1 : 0;
+    }
 }
 
 /*
@@ -62,25 +402,33 @@ void Octree::node::addToPending(RigidBody* instance, Model *model) {
     for (BoundingRegion br : model->boundingRegions) {
         br.instance = instance;
         br.transform();
-        queue.push(br);
+        queue.push_back(table->add(br, this, true));
     }
 }
 
 // build tree (called during initialization)
 void Octree::node::build() {
+    if (threadPool && objects.size() >= MIN_PARALLEL_BUILD) {
+        // large enough to split up between worker threads
+        TaskCounter counter(0);
+        buildParallel(counter);
+        threadPool->wait(counter);
+        return;
+    }
+
     // variable declarations
     BoundingRegion octants[NO_CHILDREN];
     glm::vec3 dimensions = region.calculateDimensions();
-    std::vector<BoundingRegion> octLists[NO_CHILDREN]; // array of lists of objects in each octant
+    objectList octLists[NO_CHILDREN]; // array of lists of objects in each octant
     
     /*
         termination conditions (don't subdivide further)
-        - 1 or less objects (ie an empty leaf node or node with 1 object)
+        - few enough objects (see SplitPolicy)
         - dimesnions are too small
     */
 
-    // <= 1 objects
-    if (objects.size() <= 1) {
+    // few objects
+    if (!shouldSplit()) {
         // set state variables
         goto setVars;
     }
@@ -97,34 +445,36 @@ void Octree::node::build() {
     for (int i = 0; i < NO_CHILDREN; i++) {
         calculateBounds(octants[i], (Octant)(1 << i), region);
     }
+    initLists(octLists);
 
-    // determine which octants to place objects in
-    for (int i = 0, len = objects.size(); i < len; i++) {
-        BoundingRegion br = objects[i];
-        for (int j = 0; j < NO_CHILDREN; j++) {
-            if (octants[j].containsRegion(br)) {
+    // determine which octants to place objects in (keep relative order, no erasing from the list)
+    {
+        objectList remaining(objects.get_allocator());
+        for (unsigned int idx : objects) {
+            int j = getOctant(table->regions[idx], octants);
+            if (j != -1) {
                 // octant contains region
-                octLists[j].push_back(br);
-                objects.erase(objects.begin() + i);
-
-                // offset because removed object from list
-                i--;
-                len--;
-                break;
+                octLists[j].push_back(idx);
+            }
+            else {
+                // no octant fully contains region, stays in this node
+                remaining.push_back(idx);
             }
         }
+        objects.swap(remaining);
+        boundsDirty = true;
     }
 
     // populate octants
     for (int i = 0; i < NO_CHILDREN; i++) {
         if (octLists[i].size() != 0) {
             // if children go into this octant, generate new child
-            children[i] = new node(octants[i], octLists[i]);
-            States::activateIndex(&activeOctants, i); // activate octant
-            children[i]->parent = this;
-            children[i]->build();
+            createChild(i, octants[i], octLists[i])->build();
         }
     }
+    if (activeOctants) {
+        stats->nodesSplit++;
+    }
     
 setVars:
     // set state variables
@@ -132,199 +482,533 @@ setVars:
     treeReady = true;
 
     // set pointer to current cell of each object
-    for (int i = 0; i < objects.size(); i++) {
-        objects[i].cell = this;
+    for (unsigned int idx : objects) {
+        table->setCell(idx, this, false);
     }
 }
 
-// update objects in tree (called during each iteration of main loop)
-void Octree::node::update(Box &box) {
-    if (treeBuilt && treeReady) {
-        box.positions.push_back(region.calculateCenter());
-        box.sizes.push_back(region.calculateDimensions());
-
-        // countdown timer
-        if (objects.size() == 0) {
-            if (!activeOctants) {
-                // ensure no child leaves
-                if (currentLifespan == -1) {
-                    // initial check
-                    currentLifespan = maxLifespan;
-                }
-                else if (currentLifespan > 0) {
-                    // decrement
-                    currentLifespan--;
-                }
-            }
+// build tree with worker threads, subtrees are added to the counter (same result as build)
+void Octree::node::buildParallel(TaskCounter& counter) {
+    // variable declarations
+    BoundingRegion octants[NO_CHILDREN];
+    glm::vec3 dimensions = region.calculateDimensions();
+    objectList octLists[NO_CHILDREN]; // array of lists of objects in each octant
+
+    // same termination conditions as build
+    bool subdivide = shouldSplit();
+    for (int i = 0; i < 3; i++) {
+        if (dimensions[i] < MIN_BOUNDS) {
+            subdivide = false;
         }
-        else {
-            if (currentLifespan != -1) {
-                if (maxLifespan <= 64) {
-                    // extend lifespan because "hotspot"
-                    maxLifespan <<= 2;
-                }
-            }
+    }
+
+    if (subdivide) {
+        // create regions
+        for (int i = 0; i < NO_CHILDREN; i++) {
+            calculateBounds(octants[i], (Octant)(1 << i), region);
         }
+        initLists(octLists);
 
-        // remove objects that don't exist anymore
-        for (int i = 0, listSize = objects.size(); i < listSize; i++) {
-            // remove if kill switch active
-            if (States::isActive(&objects[i].instance->state, INSTANCE_DEAD)) {
-                objects.erase(objects.begin() + i);
-                // offset because removed item from list
-                i--;
-                listSize--;
-            }
+        /*
+            determine which octant each object goes in
+            - split list into one contiguous chunk per worker
+            - each object takes the octant from getOctant (-1 to stay in this node)
+        */
+        unsigned int noObjects = objects.size();
+        std::vector<signed char> octantIdx(noObjects);
+        unsigned int noChunks = threadPool->size();
+        unsigned int chunkSize = (noObjects + noChunks - 1) / noChunks;
+
+        TaskCounter partitionCounter(0);
+        for (unsigned int start = 0; start < noObjects; start += chunkSize) {
+            unsigned int end = std::min(start + chunkSize, noObjects);
+            threadPool->push([this, &octants, &octantIdx, start, end]() -> void {
+                for (unsigned int i = start; i < end; i++) {
+                    octantIdx[i] = getOctant(table->regions[objects[i]], octants);
+                }
+            }, &partitionCounter);
         }
+        threadPool->wait(partitionCounter);
 
-        // get moved objects that were in this leaf in previous frame
-        std::stack<int> movedObjects;
-        for (int i = 0, listSize = objects.size(); i < listSize; i++) {
-            if (States::isActive(&objects[i].instance->state, INSTANCE_MOVED)) {
-                // if moved switch active, transform region and push to list
-                objects[i].transform();
-                movedObjects.push(i);
+        // gather in original order so each list matches the serial build
+        objectList remaining(objects.get_allocator());
+        for (unsigned int i = 0; i < noObjects; i++) {
+            if (octantIdx[i] == -1) {
+                remaining.push_back(objects[i]);
+            }
+            else {
+                octLists[octantIdx[i]].push_back(objects[i]);
             }
-            box.positions.push_back(objects[i].calculateCenter());
-            box.sizes.push_back(objects[i].calculateDimensions());
         }
+        objects.swap(remaining);
+        boundsDirty = true;
 
-        // remove dead branches
-        unsigned char flags = activeOctants;
-        for (int i = 0;
-            flags > 0;
-            flags >>= 1, i++) {
-            if (States::isIndexActive(&flags, 0) && children[i]->currentLifespan == 0) {
-                // active and run out of time
-                if (children[i]->objects.size() > 0) {
-                    // branch is dead but has children, so reset
-                    children[i]->currentLifespan = -1;
+        // populate octants, large subtrees are built as separate tasks
+        if (std::any_of(octLists, octLists + NO_CHILDREN, [](objectList& list) -> bool { return list.size() != 0; })) {
+            stats->nodesSplit++;
+        }
+        for (int i = 0; i < NO_CHILDREN; i++) {
+            if (octLists[i].size() != 0) {
+                node* child = createChild(i, octants[i], octLists[i]);
+                if (child->objects.size() >= MIN_PARALLEL_BUILD) {
+                    threadPool->push([child, &counter]() -> void {
+                        child->buildParallel(counter);
+                    }, &counter);
                 }
                 else {
-                    // branch is dead
-                    free(children[i]);
-                    children[i] = nullptr;
-                    States::deactivateIndex(&activeOctants, i);
+                    threadPool->push([child]() -> void {
+                        child->build();
+                    }, &counter);
                 }
             }
         }
+    }
+
+    // set state variables
+    treeBuilt = true;
+    treeReady = true;
+
+    // set pointer to current cell of each object
+    for (unsigned int idx : objects) {
+        table->setCell(idx, this, false);
+    }
+}
+
+// update objects in tree (called during each iteration of main loop)
+void Octree::node::update(Box &box) {
+    if (parallelUpdate && threadPool && !parent && treeBuilt && treeReady) {
+        updateParallel(box);
+
+        // copy bounds for the queries of this frame (subtrees on the worker threads)
+        TaskCounter counter(0);
+        refreshBoundsTree(0, &counter);
+        threadPool->wait(counter);
+    }
+    else {
+        update(box, nullptr);
+
+        // copy bounds for the queries of this frame
+        refreshBoundsTree(0, nullptr);
+    }
+}
+
+// update objects in subtree (removals and moves out of the subtree are deferred to the task if set)
+void Octree::node::update(Box& box, UpdateTask* task) {
+    if (treeBuilt && treeReady) {
+        // merged objects are updated with the rest of this node
+        mergeChildren(task);
+        updateObjects(box, task);
 
         // update child nodes
-        if (children != nullptr) {
-            // go through each octant using flags
-            for (unsigned char flags = activeOctants, i = 0;
-                flags > 0;
-                flags >>= 1, i++) {
-                if (States::isIndexActive(&flags, 0)) {
-                    // active octant
-                    if (children[i] != nullptr) {
-                        // child not null
-                        children[i]->update(box);
-                    }
-                }
+        // go through each octant using flags
+        for (unsigned char flags = activeOctants, i = 0;
+            flags > 0;
+            flags >>= 1, i++) {
+            if (States::isIndexActive(&flags, 0) && children[i]) {
+                children[i]->update(box, task);
             }
         }
-        
-        // move moved objects into new nodes
-        BoundingRegion movedObj; // placeholder
-        while (movedObjects.size() != 0) {
-            /*
-                for each moved object
-                - traverse up tree (start with current node) until find a node that completely encloses the object
-                - call insert (push object as far down as possible)
-            */
 
-            movedObj = objects[movedObjects.top()]; // set to top object in stack
-            node* current = this; // placeholder
+        moveObjects(task);
+        processPending(task);
+        finishUpdate();
+    }
+    else {
+        processPending(task);
+    }
+}
 
-            while (!current->region.containsRegion(movedObj)) {
-                if (current->parent != nullptr) {
-                    // set current to current's parent (recursion)
-                    current = current->parent;
-                }
-                else {
-                    break; // if root node, the leave
+// update objects in tree with worker threads (same tree as the serial update)
+void Octree::node::updateParallel(Box& box) {
+    /*
+        three phases
+        - top levels: update own objects and prune branches, collect the nodes at PARALLEL_UPDATE_DEPTH
+        - each collected subtree is updated as a task, table removals and objects leaving the subtree are deferred
+        - sync point: in the order of the serial update, place objects that left the subtrees,
+            move objects and process queues of the top levels, then remove the deferred records
+    */
+    std::vector<node*> roots;
+    updateTop(box, 0, roots);
+
+    std::vector<UpdateTask> tasks(roots.size());
+    TaskCounter counter(0);
+    for (unsigned int i = 0, len = roots.size(); i < len; i++) {
+        UpdateTask* task = &tasks[i];
+        task->root = roots[i];
+        threadPool->push([task]() -> void {
+            task->root->update(task->box, task);
+        }, &counter);
+    }
+    threadPool->wait(counter);
+
+    UpdateTask sync;
+    unsigned int next = 0;
+    updateBottom(box, 0, tasks, next, sync);
+
+    // remove highest indices first so no deferred record is moved by a removal
+    for (UpdateTask& task : tasks) {
+        sync.removed.insert(sync.removed.end(), task.removed.begin(), task.removed.end());
+    }
+    std::sort(sync.removed.begin(), sync.removed.end(), std::greater<unsigned int>());
+    for (unsigned int idx : sync.removed) {
+        table->remove(idx);
+    }
+}
+
+// first phase of the parallel update for the top levels (nodes at PARALLEL_UPDATE_DEPTH are added to roots)
+void Octree::node::updateTop(Box& box, unsigned int depth, std::vector<node*>& roots) {
+    mergeChildren(nullptr);
+    updateObjects(box, nullptr);
+
+    for (unsigned char flags = activeOctants, i = 0;
+        flags > 0;
+        flags >>= 1, i++) {
+        if (States::isIndexActive(&flags, 0) && children[i]) {
+            if (depth + 1 == PARALLEL_UPDATE_DEPTH) {
+                roots.push_back(children[i]);
+            }
+            else {
+                children[i]->updateTop(box, depth + 1, roots);
+            }
+        }
+    }
+}
+
+// last phase of the parallel update for the top levels (tasks are taken in the order of updateTop)
+void Octree::node::updateBottom(Box& box, unsigned int depth, std::vector<UpdateTask>& tasks, unsigned int& next, UpdateTask& sync) {
+    for (unsigned char flags = activeOctants, i = 0;
+        flags > 0;
+        flags >>= 1, i++) {
+        if (States::isIndexActive(&flags, 0) && children[i]) {
+            if (depth + 1 == PARALLEL_UPDATE_DEPTH) {
+                UpdateTask& task = tasks[next++];
+                box.positions.insert(box.positions.end(), task.box.positions.begin(), task.box.positions.end());
+                box.sizes.insert(box.sizes.end(), task.box.sizes.begin(), task.box.sizes.end());
+
+                // continue search for a node that fits from the parent of the subtree
+                for (unsigned int idx : task.escaped) {
+                    node* current = this;
+                    while (!current->fits(table->regions[idx]) && current->parent != nullptr) {
+                        current = current->parent;
+                    }
+                    current->queue.push_back(idx);
+                    table->setCell(idx, current, true);
                 }
             }
+            else {
+                children[i]->updateBottom(box, depth + 1, tasks, next, sync);
+            }
+        }
+    }
 
-            /*
-                once finished
-                - remove from objects list
-                - remove from movedObjects stack
-                - insert into found region
-            */
-            objects.erase(objects.begin() + movedObjects.top());
-            movedObjects.pop();
-            current->queue.push(movedObj);
+    moveObjects(&sync);
+    processPending(&sync);
+    finishUpdate();
+}
 
-            // collision detection
-            // itself
-            current = movedObj.cell;
-            current->checkCollisionsSelf(movedObj);
+// update counters, remove dead objects and transform moved objects of this node
+void Octree::node::updateObjects(Box& box, UpdateTask* task) {
+    box.positions.push_back(region.calculateCenter());
+    box.sizes.push_back(region.calculateDimensions());
 
-            // children
-            current->checkCollisionsChildren(movedObj);
+    // average cost of the queries since the last update
+    queryCost = 0.75f * queryCost + 0.25f * queryTests;
+    queryTests = 0;
 
-            // parents
-            while (current->parent) {
+    // remove objects that don't exist anymore
+    for (int i = 0, listSize = objects.size(); i < listSize; i++) {
+        // remove if kill switch active
+        unsigned int idx = objects[i];
+        if (States::isActive(&table->regions[idx].instance->state, INSTANCE_DEAD)) {
+            objects.erase(objects.begin() + i);
+            removeRecord(idx, task);
+            boundsDirty = true;
+            // offset because removed item from list
+            i--;
+            listSize--;
+        }
+    }
+
+    // transform moved objects that were in this leaf in previous frame
+    for (int i = 0, listSize = objects.size(); i < listSize; i++) {
+        BoundingRegion& br = table->regions[objects[i]];
+        if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+            br.transform();
+        }
+        box.positions.push_back(br.calculateCenter());
+        box.sizes.push_back(br.calculateDimensions());
+    }
+}
+
+// merge children into this node once the subtree stayed small for policy.mergeDelay frames
+void Octree::node::mergeChildren(UpdateTask* task) {
+    // objects in the subtree (counts of the children are from their last update)
+    unsigned int noObjects = objects.size() + queue.size();
+    for (unsigned char flags = activeOctants, i = 0;
+        flags > 0;
+        flags >>= 1, i++) {
+        if (States::isIndexActive(&flags, 0)) {
+            noObjects += children[i]->subtreeObjects;
+        }
+    }
+
+    if (!activeOctants || noObjects >= policy.mergeObjects) {
+        // leaf or still full enough
+        mergeCountdown = -1;
+        return;
+    }
+
+    // countdown timer (hysteresis, a subtree that empties briefly is kept)
+    if (mergeCountdown == -1) {
+        mergeCountdown = policy.mergeDelay;
+    }
+    if (mergeCountdown > 0) {
+        mergeCountdown--;
+        stats->mergesPending++;
+        return;
+    }
+
+    // pull objects up, then release the empty children
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (States::isIndexActive(&activeOctants, i)) {
+            takeObjects(children[i]);
+            releaseChild(i, task);
+            stats->branchesPruned++;
+        }
+    }
+    mergeCountdown = -1;
+}
+
+// split leaf if it got too full or too costly to query, then count the objects of the subtree
+void Octree::node::finishUpdate() {
+    if (!activeOctants && shouldSplit()) {
+        build();
+    }
+
+    subtreeObjects = objects.size() + queue.size();
+    for (unsigned char flags = activeOctants, i = 0;
+        flags > 0;
+        flags >>= 1, i++) {
+        if (States::isIndexActive(&flags, 0)) {
+            subtreeObjects += children[i]->subtreeObjects;
+        }
+    }
+}
+
+// move moved objects of this node into the queue of the nodes that fit them
+void Octree::node::moveObjects(UpdateTask* task) {
+    /*
+        for each moved object (last first)
+        - traverse up tree (start with current node) until find a node that completely encloses the object
+        - the queue of that node inserts it (push object as far down as possible)
+        - objects that leave the subtree of a task are placed at the sync point
+    */
+    for (int i = (int)objects.size() - 1; i >= 0; i--) {
+        unsigned int movedIdx = objects[i];
+        if (!States::isActive(&table->regions[movedIdx].instance->state, INSTANCE_MOVED)) {
+            continue;
+        }
+
+        node* current = this; // placeholder
+        bool escaped = false;
+        while (!current->fits(table->regions[movedIdx])) {
+            if (task && current == task->root) {
+                // the rest of the search is outside of the subtree
+                escaped = true;
+                break;
+            }
+            else if (current->parent != nullptr) {
+                // set current to current's parent (recursion)
                 current = current->parent;
-                current->checkCollisionsSelf(movedObj);
             }
+            else {
+                break; // if root node, the leave
+            }
+        }
+
+        // remove from objects list and insert into found region
+        objects.erase(objects.begin() + i);
+        boundsDirty = true;
+        if (escaped) {
+            task->escaped.push_back(movedIdx);
+        }
+        else {
+            current->queue.push_back(movedIdx);
+            table->setCell(movedIdx, current, true);
         }
     }
+}
 
-    processPending();
+// remove record from the table (deferred to the task if set)
+void Octree::node::removeRecord(unsigned int idx, UpdateTask* task) {
+    if (task) {
+        task->removed.push_back(idx);
+    }
+    else {
+        table->remove(idx);
+    }
 }
 
-// process pending queue
-void Octree::node::processPending() {
+// process pending queue (removals are deferred to the task if set)
+void Octree::node::processPending(UpdateTask* task) {
     if (!treeBuilt) {
         // add objects to be sorted into branches when built
-        while (queue.size() != 0) {
-            objects.push_back(queue.front());
-            queue.pop();
+        stats->pendingProcessed += queue.size();
+        for (int i = 0, len = queue.size(); i < len; i++) {
+            unsigned int idx = queue.front();
+            queue.pop_front();
+
+            // make room for objects outside of the root
+            BoundingRegion& br = table->regions[idx];
+            if ((!parent && grow(br)) || fits(br)) {
+                objects.push_back(idx);
+            }
+            else {
+                // outside of the world, wait in queue
+                queue.push_back(idx);
+            }
         }
         build();
     }
     else {
+        stats->pendingProcessed += queue.size();
         for (int i = 0, len = queue.size(); i < len; i++) {
-            BoundingRegion br = queue.front();
-            if (region.containsRegion(br)) {
+            unsigned int idx = queue.front();
+            queue.pop_front();
+
+            BoundingRegion& br = table->regions[idx];
+            if (States::isActive(&br.instance->state, INSTANCE_DEAD)) {
+                // object doesn't exist anymore
+                removeRecord(idx, task);
+            }
+            else if ((!parent && grow(br)) || fits(br)) {
                 // insert object immediately
-                insert(br);
+                insert(idx);
             }
             else {
-                // return to queue
-                br.transform();
-                queue.push(br);
+                // return to queue (outside of the world, only update region if it moved)
+                if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+                    br.transform();
+                }
+                queue.push_back(idx);
             }
-            queue.pop();
         }
     }
 }
 
+// double root toward object until it contains the object (false if the root would pass worldLimit)
+bool Octree::node::grow(BoundingRegion& obj) {
+    // tight bounds, so the object can also go down in a loose tree
+    while (!region.containsRegion(obj)) {
+        /*
+            double the region on each axis toward the object
+            - the old region becomes one octant of the new region
+            - a new child takes the old region with all children and the objects that fit in it
+        */
+        glm::vec3 dimensions = region.calculateDimensions();
+        if (2.0f * std::max(dimensions.x, std::max(dimensions.y, dimensions.z)) > worldLimit) {
+            return false;
+        }
+
+        glm::vec3 center = region.calculateCenter();
+        glm::vec3 objCenter = obj.calculateCenter();
+        BoundingRegion oldRegion = region;
+        bool positive[3]; // if the old region is on the positive side of the new center
+        for (int i = 0; i < 3; i++) {
+            positive[i] = objCenter[i] < center[i];
+            if (positive[i]) {
+                region.min[i] -= dimensions[i];
+            }
+            else {
+                region.max[i] += dimensions[i];
+            }
+        }
+
+        stats->rootGrowths++;
+        if (!treeBuilt) {
+            // objects are sorted when the tree is built
+            continue;
+        }
+
+        // octant order: (+x, +y), (-x, +y), (-x, -y), (+x, -y) with +z first, then -z
+        int octant = positive[0]
+            ? (positive[1] ? 0 : 3)
+            : (positive[1] ? 1 : 2);
+        if (!positive[2]) {
+            octant += 4;
+        }
+
+        // detach children
+        node* oldChildren[NO_CHILDREN];
+        unsigned char oldActiveOctants = activeOctants;
+        for (int i = 0; i < NO_CHILDREN; i++) {
+            oldChildren[i] = children[i];
+            children[i] = nullptr;
+        }
+        activeOctants = 0;
+
+        // new child takes the old region and children
+        objectList list = objectList(PoolAllocator<unsigned int>(pool));
+        node* child = createChild(octant, oldRegion, list);
+        for (int i = 0; i < NO_CHILDREN; i++) {
+            child->children[i] = oldChildren[i];
+            if (oldChildren[i]) {
+                oldChildren[i]->parent = child;
+            }
+        }
+        child->activeOctants = oldActiveOctants;
+        child->treeBuilt = true;
+        child->treeReady = true;
+
+        // objects that fit in the old region go down with it
+        for (int i = 0, len = objects.size(); i < len; i++) {
+            unsigned int idx = objects[i];
+            if (child->fits(table->regions[idx])) {
+                child->objects.push_back(idx);
+                table->setCell(idx, child, false);
+                objects.erase(objects.begin() + i);
+                i--;
+                len--;
+            }
+        }
+
+        // count of the new child (the parent merges its children if they look empty)
+        child->subtreeObjects = child->objects.size();
+        for (unsigned char flags = child->activeOctants, i = 0;
+            flags > 0;
+            flags >>= 1, i++) {
+            if (States::isIndexActive(&flags, 0)) {
+                child->subtreeObjects += child->children[i]->subtreeObjects;
+            }
+        }
+        boundsDirty = true;
+    }
+
+    return true;
+}
+
 // dynamically insert object into node
-bool Octree::node::insert(BoundingRegion obj) {
+bool Octree::node::insert(unsigned int idx) {
     /*
         termination conditions
-        - no objects (an empty leaf node)
+        - leaf with room for the object (see SplitPolicy)
         - dimensions are less than MIN_BOUNDS
     */
 
     glm::vec3 dimensions = region.calculateDimensions();
-    if (objects.size() == 0 ||
+    if ((!activeOctants && objects.size() < policy.splitObjects) ||
         dimensions.x < MIN_BOUNDS ||
         dimensions.y < MIN_BOUNDS ||
         dimensions.z < MIN_BOUNDS
         ) {
-        obj.cell = this;
-        objects.push_back(obj);
+        table->setCell(idx, this, false);
+        objects.push_back(idx);
         return true;
     }
 
     // safeguard if object doesn't fit
-    if (!region.containsRegion(obj)) {
-        return parent == nullptr ? false : parent->insert(obj);
+    if (!fits(table->regions[idx])) {
+        return parent == nullptr ? false : parent->insert(idx);
     }
 
     // create regions if not defined
@@ -340,21 +1024,21 @@ bool Octree::node::insert(BoundingRegion obj) {
         }
     }
 
-    objects.push_back(obj);
+    objects.push_back(idx);
+    bool leaf = !activeOctants;
 
     // determine which octants to put objects in
-    std::vector<BoundingRegion> octLists[NO_CHILDREN]; // array of list of objects in each octant
+    objectList octLists[NO_CHILDREN]; // array of list of objects in each octant
+    initLists(octLists);
     for (int i = 0, len = objects.size(); i < len; i++) {
-        objects[i].cell = this;
-        for (int j = 0; j < NO_CHILDREN; j++) {
-            if (octants[j].containsRegion(objects[i])) {
-                octLists[j].push_back(objects[i]);
-                // remove from objects list
-                objects.erase(objects.begin() + i);
-                i--;
-                len--;
-                break;
-            }
+        table->setCell(objects[i], this, false);
+        int j = getOctant(table->regions[objects[i]], octants);
+        if (j != -1) {
+            octLists[j].push_back(objects[i]);
+            // remove from objects list
+            objects.erase(objects.begin() + i);
+            i--;
+            len--;
         }
     }
 
@@ -363,228 +1047,573 @@ bool Octree::node::insert(BoundingRegion obj) {
         if (octLists[i].size() != 0) {
             // objects exist in this octant
             if (children[i]) {
-                for (BoundingRegion br : octLists[i]) {
-                    children[i]->insert(br);
+                for (unsigned int objIdx : octLists[i]) {
+                    children[i]->insert(objIdx);
                 }
             }
             else {
                 // create new node
-                children[i] = new node(octants[i], octLists[i]);
-                children[i]->parent = this;
-                States::activateIndex(&activeOctants, i);
-                children[i]->build();
+                createChild(i, octants[i], octLists[i])->build();
             }
         }
     }
+    if (leaf && activeOctants) {
+        stats->nodesSplit++;
+    }
 
     return true;
 }
 
-// check collisions with all objects in node
-void Octree::node::checkCollisionsSelf(BoundingRegion obj) {
-    for (BoundingRegion br : objects) {
-        if (br.instance->instanceId == obj.instance->instanceId) {
-            // do not test collisions with the same instance
-            continue;
+// collect overlapping pairs (at least one moved) in one pass over the tree
+void Octree::node::collectPairs(std::vector<BroadphasePair>& pairs) {
+    if (looseness != 1.0f) {
+        // loose cells overlap, so pairs can span sibling subtrees
+        collectPairsLoose(pairs, this);
+        return;
+    }
+
+    std::vector<node*> ancestors;
+    collectPairs(pairs, ancestors);
+}
+
+// collect regions of moved instances (to query other structures with)
+void Octree::node::collectMoved(std::vector<BoundingRegion*>& moved) {
+    // every record of the tree is in the table of the root
+    for (BoundingRegion& br : table->regions) {
+        if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+            moved.push_back(&br);
         }
+    }
+}
 
-        // coarse check for bounding region intersection
-        if (br.intersectsWith(obj)) {
-            // coarse check passed
-
-            unsigned int noFacesBr = br.collisionMesh ? br.collisionMesh->faces.size() : 0;
-            unsigned int noFacesObj = obj.collisionMesh ? obj.collisionMesh->faces.size() : 0;
-
-            glm::vec3 norm;
-
-            if (noFacesBr) {
-                unsigned int noFacesBr = br.collisionMesh->faces.size();
-
-                if (noFacesObj) {
-                    // both have collision meshes
-                    unsigned int noFacesObj = obj.collisionMesh->faces.size();
-
-                    // check all faces in br against all faces in obj
-                    for (unsigned int i = 0; i < noFacesBr; i++) {
-                        for (unsigned int j = 0; j < noFacesObj; j++) {
-                            if (br.collisionMesh->faces[i].collidesWithFace(
-                                br.instance,
-                                obj.collisionMesh->faces[j],
-                                obj.instance,
-                                norm
-                            )) {
-                                std::cout << "Case 1: Instance " << br.instance->instanceId
-                                    << " (" << br.instance->modelId << ") collides with instance "
-                                    << obj.instance->instanceId << " (" << obj.instance->modelId << ")" << std::endl;
-                                
-                                obj.instance->handleCollision(br.instance, norm);
-                                
-                                break;
-                            }
-                        }
-                    }
-                }
-                else {
-                    // br has a collision mesh, obj does not
-                    // check all faces in br against the obj's sphere
-                    for (unsigned int i = 0; i < noFacesBr; i++) {
-                        if (br.collisionMesh->faces[i].collidesWithSphere(
-                            br.instance,
-                            obj,
-                            norm
-                        )) {
-                            std::cout << "Case 2: Instance " << br.instance->instanceId
-                                << " (" << br.instance->modelId << ") collides with instance "
-                                << obj.instance->instanceId << " (" << obj.instance->modelId << ")" << std::endl;
-                            
-                            obj.instance->handleCollision(br.instance, norm);
-                            
-                            break;
-                        }
-                    }
+// collect overlapping pairs in this subtree against itself and the objects of its ancestors
+void Octree::node::collectPairs(std::vector<BroadphasePair>& pairs, std::vector<node*>& ancestors) {
+    /*
+        each pair is visited exactly once
+        - objects later in the same node
+        - objects in the nodes above (objects in sibling subtrees sit in disjoint cells)
+    */
+    unsigned char hits[QUERY_BATCH];
+    for (unsigned int i = 0, len = objects.size(); i < len; i++) {
+        BoundingRegion& obj = table->regions[objects[i]];
+
+        // test against the rest of the node in batches
+        for (unsigned int start = i + 1; start < len; start += QUERY_BATCH) {
+            unsigned int end = std::min(start + QUERY_BATCH, len);
+            testObjects(obj, start, end, hits);
+            for (unsigned int j = start; j < end; j++) {
+                BoundingRegion& br = table->regions[objects[j]];
+                stats->coarsePassed += hits[j - start];
+                if (hits[j - start] && Broadphase::needsCheck(obj, br)) {
+                    pairs.push_back({ &obj, &br });
                 }
             }
-            else {
-                if (noFacesObj) {
-                    // obj has a collision mesh, br does not
-                    // check all faces in obj against br's sphere
-                    unsigned int noFacesObj = obj.collisionMesh->faces.size();
-
-                    for (int i = 0; i < noFacesObj; i++) {
-                        if (obj.collisionMesh->faces[i].collidesWithSphere(
-                            obj.instance,
-                            br,
-                            norm
-                        )) {
-                            std::cout << "Case 3: Instance " << br.instance->instanceId
-                                << " (" << br.instance->modelId << ") collides with instance "
-                                << obj.instance->instanceId << " (" << obj.instance->modelId << ")" << std::endl;
-                            
-                            obj.instance->handleCollision(br.instance, norm);
-
-                            break;
-                        }
+        }
+        stats->coarseTests += len - i - 1;
+        queryTests += len - i - 1;
+
+        for (node* ancestor : ancestors) {
+            unsigned int noObjects = ancestor->objects.size();
+            for (unsigned int start = 0; start < noObjects; start += QUERY_BATCH) {
+                unsigned int end = std::min(start + QUERY_BATCH, noObjects);
+                ancestor->testObjects(obj, start, end, hits);
+                for (unsigned int j = start; j < end; j++) {
+                    BoundingRegion& br = table->regions[ancestor->objects[j]];
+                    stats->coarsePassed += hits[j - start];
+                    if (hits[j - start] && Broadphase::needsCheck(br, obj)) {
+                        pairs.push_back({ &br, &obj });
                     }
                 }
-                else {
-                    // neither have a collision mesh
-                    // coarse grain test pased (test collision between spheres)
-                    std::cout << "Case 4: Instance " << br.instance->instanceId
-                        << " (" << br.instance->modelId << ") collides with instance "
-                        << obj.instance->instanceId << " (" << obj.instance->modelId << ")" << std::endl;
-                
-                    norm = obj.center - br.center;
-
-                    obj.instance->handleCollision(br.instance, norm);
-                }
             }
+            stats->coarseTests += noObjects;
+            ancestor->queryTests += noObjects;
         }
     }
+
+    // go through each octant using flags
+    ancestors.push_back(this);
+    for (unsigned char flags = activeOctants, i = 0;
+        flags > 0;
+        flags >>= 1, i++) {
+        if (States::isIndexActive(&flags, 0) && children[i]) {
+            children[i]->collectPairs(pairs, ancestors);
+        }
+    }
+    ancestors.pop_back();
 }
 
-// check collisions with all objects in child nodes
-void Octree::node::checkCollisionsChildren(BoundingRegion obj) {
-    if (children) {
-        for (int flags = activeOctants, i = 0;
-            flags > 0;
-            flags >>= 1, i++) {
-            if (States::isIndexActive(&flags, 0) && children[i]) {
-                children[i]->checkCollisionsSelf(obj);
-                children[i]->checkCollisionsChildren(obj);
+// collect overlapping pairs of moved objects in this subtree by querying the tree from the root (loose mode)
+void Octree::node::collectPairsLoose(std::vector<BroadphasePair>& pairs, node* root) {
+    for (unsigned int idx : objects) {
+        BoundingRegion& obj = table->regions[idx];
+        if (States::isActive(&obj.instance->state, INSTANCE_MOVED)) {
+            root->queryPairs(obj, pairs);
+        }
+    }
+
+    for (unsigned char flags = activeOctants, i = 0;
+        flags > 0;
+        flags >>= 1, i++) {
+        if (States::isIndexActive(&flags, 0) && children[i]) {
+            children[i]->collectPairsLoose(pairs, root);
+        }
+    }
+}
+
+// collect overlapping pairs between object and every loose cell it touches
+void Octree::node::queryPairs(BoundingRegion& obj, std::vector<BroadphasePair>& pairs) {
+    BoundingRegion bounds = looseRegion();
+    if (!bounds.intersectsWith(obj)) {
+        stats->coarseTests++;
+        return;
+    }
+    stats->coarsePassed++;
+
+    // test against the objects in the node in batches
+    unsigned int noObjects = objects.size();
+    stats->coarseTests += noObjects + 1; // including the cell
+    queryTests += noObjects;
+
+    unsigned char hits[QUERY_BATCH];
+    for (unsigned int start = 0; start < noObjects; start += QUERY_BATCH) {
+        unsigned int end = std::min(start + QUERY_BATCH, noObjects);
+        testObjects(obj, start, end, hits);
+
+        for (unsigned int i = start; i < end; i++) {
+            BoundingRegion& br = table->regions[objects[i]];
+            stats->coarsePassed += hits[i - start];
+            if (!hits[i - start] || &br == &obj) {
+                continue;
+            }
+
+            if (States::isActive(&br.instance->state, INSTANCE_MOVED) && &br > &obj) {
+                // both moved, pair is added from the query of br
+                continue;
+            }
+
+            if (Broadphase::needsCheck(br, obj)) {
+                pairs.push_back({ &br, &obj });
             }
         }
     }
+
+    for (unsigned char flags = activeOctants, i = 0;
+        flags > 0;
+        flags >>= 1, i++) {
+        if (States::isIndexActive(&flags, 0) && children[i]) {
+            children[i]->queryPairs(obj, pairs);
+        }
+    }
 }
 
-// check collisions with a ray
+// check collisions with a ray (children are visited front to back)
 BoundingRegion* Octree::node::checkCollisionsRay(Ray r, float& tmin) {
     float tmin_tmp = std::numeric_limits<float>::max();
     float tmax_tmp = std::numeric_limits<float>::lowest();
-    float t_tmp = std::numeric_limits<float>::max();
+
+    stats->raysCast++;
 
     // check current region
-    if (r.intersectsBoundingRegion(region, tmin_tmp, tmax_tmp)) {
-        // know ray collides with the current region
-        if (tmin_tmp >= tmin) {
-            // found nearer collision
-            return nullptr;
-        }
+    if (!r.intersectsBoundingRegion(looseRegion(), tmin_tmp, tmax_tmp) ||
+        tmin_tmp >= tmin) {
+        // no collision or found nearer collision
+        return nullptr;
+    }
 
-        BoundingRegion* ret = nullptr, * ret_tmp = nullptr;
+    return checkCollisionsRayNode(r, tmin);
+}
 
-        // check objects in the node
-        for (BoundingRegion& br : this->objects) {
-            tmin_tmp = std::numeric_limits<float>::max();
-            tmax_tmp = std::numeric_limits<float>::lowest();
+// check collisions with a ray in this node and its children (the ray already entered the region)
+BoundingRegion* Octree::node::checkCollisionsRayNode(Ray& r, float& tmin) {
+    float tmin_tmp = std::numeric_limits<float>::max();
+    float tmax_tmp = std::numeric_limits<float>::lowest();
+    float t_tmp = std::numeric_limits<float>::max();
 
-            // coarse check - check against BR
-            if (r.intersectsBoundingRegion(br, tmin_tmp, tmax_tmp)) {
-                std::cout << "Passed coarse check, ";
-                if (tmin_tmp > tmin) {
-                    continue;
-                }
-                else if (br.collisionMesh) {
-                    // fine grain check with collision mesh
-                    t_tmp = std::numeric_limits<float>::max();
-                    if (r.intersectsMesh(br.collisionMesh, br.instance, t_tmp)) {
-                        if (t_tmp < tmin) {
-                            // found closer collision
-                            tmin = t_tmp;
-                            ret = &br;
-                        }
-                    }
-                }
-                else {
-                    // rely on coarse check
-                    if (tmin_tmp < tmin) {
-                        tmin = tmin_tmp;
+    stats->rayNodesVisited++;
+    queryTests += objects.size();
+
+    BoundingRegion* ret = nullptr, * ret_tmp = nullptr;
+
+    // check objects in the node
+    for (unsigned int idx : objects) {
+        BoundingRegion& br = table->regions[idx];
+        tmin_tmp = std::numeric_limits<float>::max();
+        tmax_tmp = std::numeric_limits<float>::lowest();
+
+        // coarse check - check against BR
+        if (r.intersectsBoundingRegion(br, tmin_tmp, tmax_tmp)) {
+            if (tmin_tmp > tmin) {
+                continue;
+            }
+            else if (br.collisionMesh) {
+                // fine grain check with collision mesh
+                t_tmp = std::numeric_limits<float>::max();
+                if (r.intersectsMesh(br.collisionMesh, br.instance, t_tmp)) {
+                    if (t_tmp < tmin) {
+                        // found closer collision
+                        tmin = t_tmp;
                         ret = &br;
                     }
                 }
             }
             else {
-                std::cout << "Failed coarse check, ";
+                // rely on coarse check
+                if (tmin_tmp < tmin) {
+                    tmin = tmin_tmp;
+                    ret = &br;
+                }
             }
         }
+    }
+
+    // find active children the ray enters before the nearest collision
+    RayEntry entries[NO_CHILDREN];
+    int noEntries = 0;
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (States::isIndexActive(&activeOctants, i) &&
+            r.intersectsBoundingRegion(children[i]->looseRegion(), tmin_tmp, tmax_tmp) &&
+            tmin_tmp < tmin) {
+            entries[noEntries++] = { i, tmin_tmp };
+        }
+    }
+
+    // check children front to back
+    sortRayEntries(entries, noEntries);
+    for (int i = 0; i < noEntries; i++) {
+        if (entries[i].t >= tmin) {
+            // this and all further children are entered behind the nearest collision
+            break;
+        }
+
+        ret_tmp = children[entries[i].idx]->checkCollisionsRayNode(r, tmin);
+        if (ret_tmp) {
+            ret = ret_tmp;
+        }
+    }
+
+    return ret;
+}
+
+// check collisions with a batch of rays (nearest hit and distance for each ray, null if no hit)
+void Octree::node::checkCollisionsRays(std::vector<Ray>& rays, std::vector<BoundingRegion*>& hits, std::vector<float>& tmin) {
+    unsigned int noRays = rays.size();
+    hits.assign(noRays, nullptr);
+    tmin.assign(noRays, std::numeric_limits<float>::max());
+
+    // traverse once for each packet of rays
+    for (unsigned int i = 0; i < noRays; i += RAYPACKET_SIZE) {
+        unsigned int noPacketRays = std::min(noRays - i, (unsigned int)RAYPACKET_SIZE);
+        RayPacket packet(&rays[i], noPacketRays);
+        checkCollisionsPacket(packet, &rays[i], &hits[i], &tmin[i]);
+    }
+}
 
-        // check children
-        if (children) {
-            for (unsigned char flags = activeOctants, i = 0;
-                flags;
-                flags >>= 1, i++) {
-                ret_tmp = children[i]->checkCollisionsRay(r, tmin);
-                if (ret_tmp) {
-                    ret = ret_tmp;
+// check collisions with a packet of rays (updates nearest hit and distance of each ray in the packet)
+void Octree::node::checkCollisionsPacket(RayPacket& packet, Ray* rays, BoundingRegion** hits, float* tmin) {
+    float tmin_tmp[RAYPACKET_SIZE];
+    float t_tmp;
+
+    // check current region
+    BoundingRegion bounds = looseRegion();
+    unsigned int mask = packet.intersectsBoundingRegion(bounds, tmin_tmp);
+    for (unsigned int i = 0; i < packet.noRays; i++) {
+        if (tmin_tmp[i] >= tmin[i]) {
+            // ray found nearer collision
+            mask &= ~(1u << i);
+        }
+    }
+    if (!mask) {
+        // no ray left to check in this region
+        return;
+    }
+
+    // check objects in the node
+    for (unsigned int idx : objects) {
+        BoundingRegion& br = table->regions[idx];
+
+        // coarse check - check against BR
+        unsigned int objMask = packet.intersectsBoundingRegion(br, tmin_tmp) & mask;
+
+        for (unsigned int i = 0; objMask; objMask >>= 1, i++) {
+            if (!(objMask & 1) || tmin_tmp[i] > tmin[i]) {
+                continue;
+            }
+            else if (br.collisionMesh) {
+                // fine grain check with collision mesh
+                t_tmp = std::numeric_limits<float>::max();
+                if (rays[i].intersectsMesh(br.collisionMesh, br.instance, t_tmp)) {
+                    if (t_tmp < tmin[i]) {
+                        // found closer collision
+                        tmin[i] = t_tmp;
+                        hits[i] = &br;
+                    }
                 }
             }
+            else if (tmin_tmp[i] < tmin[i]) {
+                // rely on coarse check
+                tmin[i] = tmin_tmp[i];
+                hits[i] = &br;
+            }
         }
+    }
 
-        return ret;
+    // check children
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (States::isIndexActive(&activeOctants, i)) {
+            children[i]->checkCollisionsPacket(packet, rays, hits, tmin);
+        }
     }
+}
+
+// collect instances with a region in the view frustum (appended to the list of each model, no duplicates)
+void Octree::node::frustumCull(Frustum& frustum, VisibleInstances& visible) {
+    frustumCull(frustum, visible, false);
+
+    // objects waiting in the queue (outside of the tree) are tested directly
+    for (unsigned int idx : queue) {
+        BoundingRegion& br = table->regions[idx];
+        if (frustum.intersectsRegion(br)) {
+            visible[br.instance->modelId].push_back(br.instance);
+        }
+    }
+
+    // instances with multiple regions may have been added more than once, keep the first
+    std::unordered_set<RigidBody*> found;
+    for (auto& pair : visible) {
+        std::vector<RigidBody*>& list = pair.second;
+        unsigned int noUnique = 0;
+        for (unsigned int i = 0, len = list.size(); i < len; i++) {
+            if (found.insert(list[i]).second) {
+                list[noUnique++] = list[i];
+            }
+        }
+        list.resize(noUnique);
+    }
+}
+
+// collect instances with a region in the view frustum in this subtree (skip tests if inside is set)
+void Octree::node::frustumCull(Frustum& frustum, VisibleInstances& visible, bool inside) {
+    if (!inside) {
+        BoundingRegion bounds = looseRegion();
+        FrustumTest res = frustum.testRegion(bounds);
+        if (res == FrustumTest::OUTSIDE) {
+            // cell and all objects in it are out of view
+            return;
+        }
+        // if the cell is completely in view, so is everything below
+        inside = res == FrustumTest::INSIDE;
+    }
+
+    // check objects in the node
+    for (unsigned int idx : objects) {
+        BoundingRegion& br = table->regions[idx];
+        if (inside || frustum.intersectsRegion(br)) {
+            visible[br.instance->modelId].push_back(br.instance);
+        }
+    }
+
+    // check children
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (States::isIndexActive(&activeOctants, i)) {
+            children[i]->frustumCull(frustum, visible, inside);
+        }
+    }
+}
+
+/*
+    spatial queries
+*/
+
+// add region to the k nearest if it is nearer than the farthest (results stay sorted)
+static void insertNearest(BoundingRegion* br, float dist, unsigned int k, BoundingRegion** results, float* distances, unsigned int& found) {
+    if (found == k && dist >= distances[k - 1]) {
+        // not nearer than any result
+        return;
+    }
+
+    // shift farther results back (the farthest drops out if full)
+    int i = found < k ? found++ : k - 1;
+    for (; i > 0 && distances[i - 1] > dist; i--) {
+        results[i] = results[i - 1];
+        distances[i] = distances[i - 1];
+    }
+    results[i] = br;
+    distances[i] = dist;
+}
+
+// collect regions overlapping a sphere (the first maxResults are written, returns number found)
+unsigned int Octree::node::querySphere(glm::vec3 center, float radius, BoundingRegion** results, unsigned int maxResults) {
+    BoundingRegion range(center, radius);
+    return queryRange(range, results, maxResults);
+}
 
-    return nullptr;
+// collect regions overlapping a box (the first maxResults are written, returns number found)
+unsigned int Octree::node::queryBox(glm::vec3 min, glm::vec3 max, BoundingRegion** results, unsigned int maxResults) {
+    BoundingRegion range(min, max);
+    return queryRange(range, results, maxResults);
+}
+
+// collect regions overlapping a range (the first maxResults are written, returns number found)
+unsigned int Octree::node::queryRange(BoundingRegion& range, BoundingRegion** results, unsigned int maxResults) {
+    unsigned int found = 0;
+    queryRangeNode(range, results, maxResults, found);
+
+    // objects waiting in the queue (outside of the tree) are tested directly
+    for (unsigned int idx : queue) {
+        BoundingRegion& br = table->regions[idx];
+        if (range.intersectsWith(br)) {
+            if (found < maxResults) {
+                results[found] = &br;
+            }
+            found++;
+        }
+    }
+
+    return found;
+}
+
+// collect regions overlapping a range in this subtree (found counts every match)
+void Octree::node::queryRangeNode(BoundingRegion& range, BoundingRegion** results, unsigned int maxResults, unsigned int& found) {
+    BoundingRegion bounds = looseRegion();
+    if (!bounds.intersectsWith(range)) {
+        return;
+    }
+
+    // test against the objects in the node in batches
+    unsigned char hits[QUERY_BATCH];
+    for (unsigned int start = 0, noObjects = objects.size(); start < noObjects; start += QUERY_BATCH) {
+        unsigned int end = std::min(start + QUERY_BATCH, noObjects);
+        testObjects(range, start, end, hits);
+
+        for (unsigned int i = start; i < end; i++) {
+            if (hits[i - start]) {
+                if (found < maxResults) {
+                    results[found] = &table->regions[objects[i]];
+                }
+                found++;
+            }
+        }
+    }
+
+    // check children
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (States::isIndexActive(&activeOctants, i)) {
+            children[i]->queryRangeNode(range, results, maxResults, found);
+        }
+    }
+}
+
+// find the k regions nearest to a point (nearest first with their distances, returns number found)
+unsigned int Octree::node::queryNearest(glm::vec3 point, unsigned int k, BoundingRegion** results, float* distances) {
+    unsigned int found = 0;
+    if (k == 0) {
+        return found;
+    }
+
+    // objects waiting in the queue (outside of the tree) are tested directly
+    for (unsigned int idx : queue) {
+        BoundingRegion& br = table->regions[idx];
+        insertNearest(&br, br.distanceToPoint(point), k, results, distances, found);
+    }
+
+    queryNearestNode(point, k, results, distances, found);
+
+    return found;
+}
+
+// find regions in this subtree nearer than the current k nearest (results stay sorted)
+void Octree::node::queryNearestNode(glm::vec3 point, unsigned int k, BoundingRegion** results, float* distances, unsigned int& found) {
+    // check objects in the node
+    for (unsigned int idx : objects) {
+        BoundingRegion& br = table->regions[idx];
+        insertNearest(&br, br.distanceToPoint(point), k, results, distances, found);
+    }
+
+    // find children that may hold a nearer region (t is the distance from the point to the cell)
+    RayEntry entries[NO_CHILDREN];
+    int noEntries = 0;
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (States::isIndexActive(&activeOctants, i)) {
+            float dist = children[i]->looseRegion().distanceToPoint(point);
+            if (found < k || dist < distances[k - 1]) {
+                entries[noEntries++] = { i, dist };
+            }
+        }
+    }
+
+    // check nearest children first so the farther ones can be skipped
+    sortRayEntries(entries, noEntries);
+    for (int i = 0; i < noEntries; i++) {
+        if (found == k && entries[i].t >= distances[k - 1]) {
+            // this and all further children are farther than the k nearest
+            break;
+        }
+
+        children[entries[i].idx]->queryNearestNode(point, k, results, distances, found);
+    }
+}
+
+/*
+    statistics
+*/
+
+// add structure of this subtree to the counters (call on the root after the update)
+void Octree::node::collectStats(unsigned int depth) {
+    stats->noNodes++;
+    stats->maxDepth = std::max(stats->maxDepth, depth);
+    stats->noObjects += objects.size();
+    stats->maxObjectsPerNode = std::max(stats->maxObjectsPerNode, (unsigned int)objects.size());
+    stats->noQueued += queue.size();
+
+    for (unsigned char flags = activeOctants, i = 0;
+        flags > 0;
+        flags >>= 1, i++) {
+        if (States::isIndexActive(&flags, 0) && children[i]) {
+            children[i]->collectStats(depth + 1);
+        }
+    }
 }
 
 // destroy object (free memory)
 void Octree::node::destroy() {
-    // clearing out children
-    if (children != nullptr) {
-        for (int flags = activeOctants, i = 0;
-            flags > 0;
-            flags >>= 1, i++) {
-            if (States::isIndexActive(&flags, 0)) {
-                // active
-                if (children[i] != nullptr) {
-                    children[i]->destroy();
-                    children[i] = nullptr;
-                }
+    if (pool && !parent) {
+        /*
+            root with a pool, recycle all nodes at once
+            - child nodes and their lists only hold memory from the pool, so no destructors are needed
+        */
+        pool->reset();
+        for (int i = 0; i < NO_CHILDREN; i++) {
+            children[i] = nullptr;
+        }
+        activeOctants = 0;
+    }
+    else {
+        // release each subtree
+        for (int i = 0; i < NO_CHILDREN; i++) {
+            if (States::isIndexActive(&activeOctants, i)) {
+                releaseChild(i);
             }
         }
     }
 
     // clear this node
-    objects.clear();
-    while (queue.size() != 0) {
-        queue.pop();
+    if (!parent) {
+        // root, all records leave with the tree
+        objects.clear();
+        queue.clear();
+        table->clear();
+        boundsDirty = true;
     }
-}
\ No newline at end of file
+    else {
+        while (objects.size() != 0) {
+            unsigned int idx = objects.back();
+            objects.pop_back();
+            table->remove(idx);
+        }
+        while (queue.size() != 0) {
+            unsigned int idx = queue.back();
+            queue.pop_back();
+            table->remove(idx);
+        }
+    }
+}
@@ -3,15 +3,26 @@
 
 #define NO_CHILDREN 8
 #define MIN_BOUNDS 0.5
+#define MIN_PARALLEL_BUILD 256 // minimum objects in a node to build it with worker threads
+#define PARALLEL_UPDATE_DEPTH 2 // depth of the nodes that are updated as separate tasks
+#define QUERY_BATCH 64 // objects tested at once in a query (results are kept on the stack)
 
 #include <vector>
 #include <queue>
 #include <stack>
+#include <unordered_set>
 
 #include "list.hpp"
 #include "states.hpp"
 #include "bounds.h"
 #include "ray.h"
+#include "frustum.h"
+#include "raypacket.h"
+#include "threadpool.h"
+#include "nodepool.h"
+#include "boundssoa.h"
+#include "treestats.h"
+#include "broadphase.h"
 
 #include "../graphics/objects/model.h"
 
@@ -47,37 +58,153 @@ namespace Octree {
     // calculate bounds of specified quadrant in bounding region
     void calculateBounds(BoundingRegion &out, Octant octant, BoundingRegion parentRegion);
 
+    // fine grain check between two regions that passed the coarse check (contact for obj to respond to br)
+    bool checkCollisionsFine(BoundingRegion &br, BoundingRegion &obj, Contact &contact);
+
+    /*
+        child cell entered by a ray (for front to back traversal)
+        - also orders cells by distance to a point in nearest queries
+    */
+    struct RayEntry {
+        // octant or node index of the child
+        int idx;
+        // distance along the ray where it enters the child (or distance to the point)
+        float t;
+    };
+
+    // sort entries by entry distance (nearest first)
+    void sortRayEntries(RayEntry* entries, int noEntries);
+
+    // list of indices of objects in a node (memory from the node pool)
+    typedef std::vector<unsigned int, PoolAllocator<unsigned int>> objectList;
+
+    // queue of indices of objects in a node (memory from the node pool)
+    typedef std::deque<unsigned int, PoolAllocator<unsigned int>> objectQueue;
+
+    /*
+        thresholds for splitting nodes and merging them back
+        - a leaf splits when it holds more than splitObjects objects,
+            or when queries test its objects more than splitCost times per frame (and it holds at least mergeObjects)
+        - children are merged back into their parent once the subtree has held fewer than mergeObjects objects
+            for mergeDelay frames in a row (empty branches are released the same way)
+        - keep mergeObjects below splitObjects so a node does not split and merge on alternate frames
+    */
+    struct SplitPolicy {
+        unsigned int splitObjects = 4;
+        unsigned int mergeObjects = 2;
+        float splitCost = 64.0f;
+        short mergeDelay = 8;
+    };
+
+    // forward declaration
+    class node;
+
+    /*
+        work of one subtree in a parallel update
+        - the subtree only changes its own nodes and records
+        - changes to the shared table and to nodes above the subtree are merged at the sync point
+    */
+    struct UpdateTask {
+        // root of the subtree
+        node* root = nullptr;
+        // debug boxes of the subtree
+        Box box;
+        // records to remove from the table
+        std::vector<unsigned int> removed;
+        // moved objects that no longer fit in the subtree
+        std::vector<unsigned int> escaped;
+    };
+
+    /*
+        densely packed table of the bounds of every object in a tree
+        - nodes and queues only hold 32-bit indices into the table
+        - the cell of each record is the node holding its index
+        - removing a record moves the last record into its slot (swap-remove)
+    */
+    class BoundsTable {
+    public:
+        // bounds of each object
+        std::vector<BoundingRegion> regions;
+        // if each record is waiting in the queue of its cell instead of the object list
+        std::vector<unsigned char> queued;
+
+        // add record held by cell, returns its index
+        unsigned int add(BoundingRegion br, node* cell, bool inQueue);
+
+        // set node holding record
+        void setCell(unsigned int idx, node* cell, bool inQueue);
+
+        // remove record (the last record takes its index)
+        void remove(unsigned int idx);
+
+        // remove all records
+        void clear();
+    };
+
     /*
         class to represent each node in the octree
     */
     class node {
     public:
         // parent pointer
-        node* parent;
+        node* parent = nullptr;
         // array of children (8)
-        node* children[NO_CHILDREN];
+        node* children[NO_CHILDREN] = { nullptr };
 
         // switch for active octants
-        unsigned char activeOctants;
+        unsigned char activeOctants = 0;
 
         // if tree is ready
         bool treeReady = false;
         // if tree is built
         bool treeBuilt = false;
 
-        // maximum possible lifespan
-        short maxLifespan = 8;
-        // current lifespace
-        short currentLifespan = -1;
+        // thresholds for splitting and merging (inherited from the parent)
+        SplitPolicy policy;
+        // frames left until the children are merged into this node (-1 if the subtree holds enough objects)
+        short mergeCountdown = -1;
+        // objects in this subtree after the last update (including queues)
+        unsigned int subtreeObjects = 0;
+
+        // coarse tests against the objects of this node in queries since the last update
+        unsigned int queryTests = 0;
+        // average coarse tests against the objects of this node per frame
+        float queryCost = 0.0f;
 
         // list of objects in node
-        std::vector<BoundingRegion> objects;
+        objectList objects;
         // queue of objects to be dynamically inserted
-        std::queue<BoundingRegion> queue;
+        objectQueue queue;
+
+        // bounds of all objects in the tree (created by the root, shared with children)
+        BoundsTable* table = nullptr;
+
+        // counters for the current frame (created by the root, shared with children)
+        TreeStats* stats = nullptr;
+
+        // copy of the bounds of the objects in this node for SIMD tests (refreshed at the end of each update)
+        BoundsSoA objectBounds;
+        // if objects changed since the copy was made
+        bool boundsDirty = true;
 
         // region of bounds of cell (AABB)
         BoundingRegion region;
 
+        // worker threads for building (serial build if null)
+        ThreadPool* threadPool = nullptr;
+
+        // memory for child nodes and their objects (global heap if null)
+        NodePool* pool = nullptr;
+
+        // looseness factor (1 = tight octree, k > 1 = each cell's bounds are scaled by k around its center)
+        float looseness = 1.0f;
+
+        // update subtrees with worker threads (root only, needs threadPool)
+        bool parallelUpdate = false;
+
+        // largest dimension the root grows to for objects outside of it (root only, fixed if 0)
+        float worldLimit = 0.0f;
+
         /*
             constructors
         */
@@ -89,7 +216,61 @@ namespace Octree {
         node(BoundingRegion bounds);
 
         // initialize with bounds and list of objects
-        node(BoundingRegion bounds, std::vector<BoundingRegion> objectList);
+        node(BoundingRegion bounds, objectList objectList);
+
+        // free table and counters if root
+        ~node();
+
+        /*
+            placement
+        */
+
+        // get bounds used for containment and culling (region scaled by looseness)
+        BoundingRegion looseRegion();
+
+        // get loose bounds of a cell with region bounds
+        BoundingRegion looseRegion(BoundingRegion& bounds);
+
+        // determine if object can be stored in this node
+        bool fits(BoundingRegion& obj);
+
+        // determine if the objects of this node should be split into children (see SplitPolicy)
+        bool shouldSplit();
+
+        // get index of octant to place object in (-1 if it stays in this node)
+        int getOctant(BoundingRegion& obj, BoundingRegion octants[NO_CHILDREN]);
+
+        /*
+            memory
+        */
+
+        // set up empty lists that take memory from the pool
+        void initLists(objectList lists[NO_CHILDREN]);
+
+        // create child in octant with bounds and list of objects (from the pool if set)
+        node* createChild(int octant, BoundingRegion bounds, objectList& list);
+
+        // release child in octant and its subtree (back to the pool if set, records leave the table or go to the task)
+        void releaseChild(int octant, UpdateTask* task = nullptr);
+
+        // move objects and queued objects of the subtree starting at child into this node
+        void takeObjects(node* child);
+
+        // remove record from the table (deferred to the task if set)
+        void removeRecord(unsigned int idx, UpdateTask* task);
+
+        // replace index of record held in this node (after the record was moved in the table)
+        void replaceObject(unsigned int from, unsigned int to, bool inQueue);
+
+        // copy bounds of the objects into objectBounds if they changed
+        void refreshBounds();
+
+        // refresh bounds of every node in the subtree (subtrees at PARALLEL_UPDATE_DEPTH are added to the counter if set)
+        void refreshBoundsTree(unsigned int depth, TaskCounter* counter);
+
+        // test region against objects [start, end) of this node, results[i - start] is 1 if they overlap
+        // (one at a time if the copy of the bounds is out of date, queries do not change the node)
+        void testObjects(BoundingRegion& br, unsigned int start, unsigned int end, unsigned char* results);
 
         /*
             functionality
@@ -101,24 +282,109 @@ namespace Octree {
         // build tree (called during initialization)
         void build();
 
+        // build tree with worker threads, subtrees are added to the counter (same result as build)
+        void buildParallel(TaskCounter& counter);
+
         // update objects in tree (called during each iteration of main loop)
         void update(Box &box);
 
-        // process pending queue
-        void processPending();
+        // update objects in subtree (removals and moves out of the subtree are deferred to the task if set)
+        void update(Box& box, UpdateTask* task);
+
+        // update objects in tree with worker threads (same tree as the serial update)
+        void updateParallel(Box& box);
+
+        // first phase of the parallel update for the top levels (nodes at PARALLEL_UPDATE_DEPTH are added to roots)
+        void updateTop(Box& box, unsigned int depth, std::vector<node*>& roots);
+
+        // last phase of the parallel update for the top levels (tasks are taken in the order of updateTop)
+        void updateBottom(Box& box, unsigned int depth, std::vector<UpdateTask>& tasks, unsigned int& next, UpdateTask& sync);
+
+        // update counters, remove dead objects and transform moved objects of this node
+        void updateObjects(Box& box, UpdateTask* task);
+
+        // merge children into this node once the subtree stayed small for policy.mergeDelay frames
+        void mergeChildren(UpdateTask* task);
+
+        // split leaf if it got too full or too costly to query, then count the objects of the subtree
+        void finishUpdate();
+
+        // move moved objects of this node into the queue of the nodes that fit them
+        void moveObjects(UpdateTask* task);
+
+        // process pending queue (removals are deferred to the task if set)
+        void processPending(UpdateTask* task = nullptr);
+
+        // double root toward object until it contains the object (false if the root would pass worldLimit)
+        bool grow(BoundingRegion& obj);
 
         // dynamically insert object into node
-        bool insert(BoundingRegion obj);
+        bool insert(unsigned int idx);
 
-        // check collisions with all objects in node
-        void checkCollisionsSelf(BoundingRegion obj);
+        // collect overlapping pairs (at least one moved) in one pass over the tree
+        void collectPairs(std::vector<BroadphasePair>& pairs);
 
-        // check collisions with all objects in child nodes
-        void checkCollisionsChildren(BoundingRegion obj);
+        // collect regions of moved instances (to query other structures with)
+        void collectMoved(std::vector<BoundingRegion*>& moved);
 
-        // check collisions with a ray
+        // collect overlapping pairs in this subtree against itself and the objects of its ancestors
+        void collectPairs(std::vector<BroadphasePair>& pairs, std::vector<node*>& ancestors);
+
+        // collect overlapping pairs of moved objects in this subtree by querying the tree from the root (loose mode)
+        void collectPairsLoose(std::vector<BroadphasePair>& pairs, node* root);
+
+        // collect overlapping pairs between object and every loose cell it touches
+        void queryPairs(BoundingRegion& obj, std::vector<BroadphasePair>& pairs);
+
+        // check collisions with a ray (children are visited front to back)
         BoundingRegion* checkCollisionsRay(Ray r, float& tmin);
 
+        // check collisions with a ray in this node and its children (the ray already entered the region)
+        BoundingRegion* checkCollisionsRayNode(Ray& r, float& tmin);
+
+        // check collisions with a batch of rays (nearest hit and distance for each ray, null if no hit)
+        void checkCollisionsRays(std::vector<Ray>& rays, std::vector<BoundingRegion*>& hits, std::vector<float>& tmin);
+
+        // check collisions with a packet of rays (updates nearest hit and distance of each ray in the packet)
+        void checkCollisionsPacket(RayPacket& packet, Ray* rays, BoundingRegion** hits, float* tmin);
+
+        // collect instances with a region in the view frustum (appended to the list of each model, no duplicates)
+        void frustumCull(Frustum& frustum, VisibleInstances& visible);
+
+        // collect instances with a region in the view frustum in this subtree (skip tests if inside is set)
+        void frustumCull(Frustum& frustum, VisibleInstances& visible, bool inside);
+
+        /*
+            spatial queries
+            - results are written into caller buffers, nothing is allocated
+            - results are regions, an instance with several regions can appear more than once
+        */
+
+        // collect regions overlapping a sphere (the first maxResults are written, returns number found)
+        unsigned int querySphere(glm::vec3 center, float radius, BoundingRegion** results, unsigned int maxResults);
+
+        // collect regions overlapping a box (the first maxResults are written, returns number found)
+        unsigned int queryBox(glm::vec3 min, glm::vec3 max, BoundingRegion** results, unsigned int maxResults);
+
+        // collect regions overlapping a range (the first maxResults are written, returns number found)
+        unsigned int queryRange(BoundingRegion& range, BoundingRegion** results, unsigned int maxResults);
+
+        // collect regions overlapping a range in this subtree (found counts every match)
+        void queryRangeNode(BoundingRegion& range, BoundingRegion** results, unsigned int maxResults, unsigned int& found);
+
+        // find the k regions nearest to a point (nearest first with their distances, returns number found)
+        unsigned int queryNearest(glm::vec3 point, unsigned int k, BoundingRegion** results, float* distances);
+
+        // find regions in this subtree nearer than the current k nearest (results stay sorted)
+        void queryNearestNode(glm::vec3 point, unsigned int k, BoundingRegion** results, float* distances, unsigned int& found);
+
+        /*
+            statistics
+        */
+
+        // add structure of this subtree to the counters (call on the root after the update)
+        void collectStats(unsigned int depth = 0);
+
         // destroy object (free memory)
         void destroy();
     };
@@ -12,19 +12,7 @@ Ray::Ray(glm::vec3 origin, glm::vec3 dir)
 
 bool Ray::intersectsBoundingRegion(BoundingRegion br, float& tmin, float& tmax) {
 	if (br.type == BoundTypes::AABB) {
-		// slab algorithm
-		tmin = std::numeric_limits<float>::lowest(); // maxOfMin
-		tmax = std::numeric_limits<float>::max(); // minOfMax
-
-		for (int i = 0; i < 3; i++) {
-			float t1 = (br.min[i] - origin[i]) * invdir[i];
-			float t2 = (br.max[i] - origin[i]) * invdir[i];
-
-			tmin = std::fmaxf(tmin, std::fminf(t1, t2));
-			tmax = std::fminf(tmax, std::fmaxf(t1, t2));
-		}
-
-		return (tmax >= tmin) && tmax >= 0.0f;
+		return intersectsBox(br.min, br.max, tmin, tmax);
 	}
 	else {
 		// ray-sphere collision
@@ -50,42 +38,96 @@ bool Ray::intersectsBoundingRegion(BoundingRegion br, float& tmin, float& tmax)
 		tmax = (-b + D) / (2.0f * a);
 		tmin = (-b - D) / (2.0f * a);
 
-		return true;
+		// both roots negative if the sphere is behind the origin
+		return tmax >= 0.0f;
+	}
+}
+
+bool Ray::intersectsBox(glm::vec3 min, glm::vec3 max, float& tmin, float& tmax) {
+	// slab algorithm
+	tmin = std::numeric_limits<float>::lowest(); // maxOfMin
+	tmax = std::numeric_limits<float>::max(); // minOfMax
+
+	for (int i = 0; i < 3; i++) {
+		float t1 = (min[i] - origin[i]) * invdir[i];
+		float t2 = (max[i] - origin[i]) * invdir[i];
+
+		tmin = std::fmaxf(tmin, std::fminf(t1, t2));
+		tmax = std::fminf(tmax, std::fmaxf(t1, t2));
 	}
+
+	return (tmax >= tmin) && tmax >= 0.0f;
 }
 
 bool Ray::intersectsMesh(CollisionMesh* mesh, RigidBody* rb, float& t) {
 	bool intersects = false;
 
-	for (Face& f : mesh->faces) {
-		float tmp = -1.0f;
-		glm::vec3 P1 = mat4vec3mult(rb->model, mesh->points[f.i1]);
-		glm::vec3 P2 = mat4vec3mult(rb->model, mesh->points[f.i2]) - P1;
-		glm::vec3 P3 = mat4vec3mult(rb->model, mesh->points[f.i3]) - P1;
-		glm::vec3 norm = rb->normalModel * f.norm;
+	if (mesh->nodes.empty()) {
+		return false;
+	}
 
-		glm::vec3 U1 = origin - P1;
+	// bring ray into model space (direction keeps its scale, so distances match world space)
+	Ray local(mat4vec3mult(rb->invModel, origin), glm::mat3(rb->invModel) * dir);
 
-		LinePlaneIntCase intCase = linePlaneIntersection(glm::vec3(0.0f), norm, U1, dir, tmp);
-	
-		if ((char)intCase > 1) {
-			// intersection with the inifinite plane at one point
-			if (tmp < 0.0f || t < tmp) {
-				// collision happens behind the origin
-				// or have found a closer collision
+	// traverse the face hierarchy, nearer child first (one level adds at most one entry to the stack)
+	unsigned int stack[COLLISIONMESH_MAX_DEPTH];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	float tmin_tmp, tmax_tmp;
+	while (stackSize) {
+		meshBvhNode& n = mesh->nodes[stack[--stackSize]];
+
+		if (!local.intersectsBox(n.min, n.max, tmin_tmp, tmax_tmp) || tmin_tmp > t) {
+			// missed, or starts after the nearest hit
+			continue;
+		}
 
-				continue;
+		if (!n.isLeaf()) {
+			// push the child further along the ray first, so the nearer one is visited first
+			meshBvhNode& left = mesh->nodes[n.first];
+			meshBvhNode& right = mesh->nodes[n.first + 1];
+			if (glm::dot((left.min + left.max) - (right.min + right.max), local.dir) > 0.0f) {
+				stack[stackSize++] = n.first;
+				stack[stackSize++] = n.first + 1;
 			}
+			else {
+				stack[stackSize++] = n.first + 1;
+				stack[stackSize++] = n.first;
+			}
+			continue;
+		}
+
+		// leaf: test the faces in model space
+		for (unsigned int i = n.first, end = n.first + n.count; i < end; i++) {
+			Face& f = mesh->faces[mesh->faceOrder[i]];
+			float tmp = -1.0f;
+			glm::vec3 P1 = mesh->points[f.i1];
+			glm::vec3 P2 = mesh->points[f.i2] - P1;
+			glm::vec3 P3 = mesh->points[f.i3] - P1;
 
-			// get point of intersection
-			glm::vec3 intersection = U1 + tmp * dir;
+			glm::vec3 U1 = local.origin - P1;
 
-			if (faceContainsPoint(P2, P3, norm, intersection)) {
-				intersects = true;
-				t = fminf(t, tmp);
+			LinePlaneIntCase intCase = linePlaneIntersection(glm::vec3(0.0f), f.norm, U1, local.dir, tmp);
+
+			if ((char)intCase > 1) {
+				// intersection with the inifinite plane at one point
+				if (tmp < 0.0f || t < tmp) {
+					// collision happens behind the origin
+					// or have found a closer collision
+
+					continue;
+				}
+
+				// get point of intersection
+				glm::vec3 intersection = U1 + tmp * local.dir;
+
+				if (faceContainsPoint(P2, P3, f.norm, intersection)) {
+					intersects = true;
+					t = fminf(t, tmp);
+				}
 			}
 		}
 	}
 
 	return intersects;
-}
\ No newline at end of file
+}
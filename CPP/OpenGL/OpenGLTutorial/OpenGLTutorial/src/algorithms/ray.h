@@ -16,6 +16,7 @@ public:
 	Ray(glm::vec3 origin, glm::vec3 dir);
 
 	bool intersectsBoundingRegion(BoundingRegion br, float &tmin, float &tmax);
+	bool intersectsBox(glm::vec3 min, glm::vec3 max, float &tmin, float &tmax);
 	bool intersectsMesh(CollisionMesh* mesh, RigidBody* rb, float &t);
 };
 
@@ -0,0 +1,151 @@
+#include "raypacket.h"
+
+#include <limits>
+#include <cmath>
+
+/*
+    constructor
+*/
+
+// initialize with up to RAYPACKET_SIZE rays
+RayPacket::RayPacket(Ray* rays, unsigned int noRays)
+    : noRays(noRays), fullMask((1u << noRays) - 1) {
+    float vals[9][RAYPACKET_SIZE];
+    for (unsigned int i = 0; i < RAYPACKET_SIZE; i++) {
+        // unused lanes repeat the last ray (masked out of results)
+        Ray& r = rays[i < noRays ? i : noRays - 1];
+        for (int j = 0; j < 3; j++) {
+            vals[j][i] = r.origin[j];
+            vals[3 + j][i] = r.dir[j];
+            vals[6 + j][i] = r.invdir[j];
+        }
+    }
+
+#ifdef RAYPACKET_SIMD
+    ox = _mm_loadu_ps(vals[0]); oy = _mm_loadu_ps(vals[1]); oz = _mm_loadu_ps(vals[2]);
+    dx = _mm_loadu_ps(vals[3]); dy = _mm_loadu_ps(vals[4]); dz = _mm_loadu_ps(vals[5]);
+    ix = _mm_loadu_ps(vals[6]); iy = _mm_loadu_ps(vals[7]); iz = _mm_loadu_ps(vals[8]);
+    dirMagSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+#else
+    for (unsigned int i = 0; i < RAYPACKET_SIZE; i++) {
+        ox[i] = vals[0][i]; oy[i] = vals[1][i]; oz[i] = vals[2][i];
+        dx[i] = vals[3][i]; dy[i] = vals[4][i]; dz[i] = vals[5][i];
+        ix[i] = vals[6][i]; iy[i] = vals[7][i]; iz[i] = vals[8][i];
+        dirMagSq[i] = dx[i] * dx[i] + dy[i] * dy[i] + dz[i] * dz[i];
+    }
+#endif
+}
+
+/*
+    testing methods
+*/
+
+// test all rays against a region, fills entry distance of each ray and returns mask of rays that hit
+unsigned int RayPacket::intersectsBoundingRegion(BoundingRegion& br, float tmin[RAYPACKET_SIZE]) {
+    if (br.type == BoundTypes::AABB) {
+        return intersectsAABB(br.min, br.max, tmin);
+    }
+    else {
+        return intersectsSphere(br.center, br.radius, tmin);
+    }
+}
+
+// test all rays against an AABB
+unsigned int RayPacket::intersectsAABB(glm::vec3 min, glm::vec3 max, float tmin[RAYPACKET_SIZE]) {
+#ifdef RAYPACKET_SIMD
+    /*
+        slab algorithm on each axis
+        - an axis the ray is parallel to gives 0 * inf = NaN if the origin is on a slab plane
+        - _mm_min_ps/_mm_max_ps return the second operand if either is NaN, so each is taken in both
+            orders and folded into the running value: a NaN falls through to the other operand or the running value,
+            same as fminf/fmaxf in the scalar path
+    */
+    __m128 tnear = _mm_set1_ps(std::numeric_limits<float>::lowest());
+    __m128 tfar = _mm_set1_ps(std::numeric_limits<float>::max());
+    __m128 mins[3] = { _mm_set1_ps(min.x), _mm_set1_ps(min.y), _mm_set1_ps(min.z) };
+    __m128 maxs[3] = { _mm_set1_ps(max.x), _mm_set1_ps(max.y), _mm_set1_ps(max.z) };
+    __m128 origins[3] = { ox, oy, oz };
+    __m128 invs[3] = { ix, iy, iz };
+    for (int j = 0; j < 3; j++) {
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(mins[j], origins[j]), invs[j]);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(maxs[j], origins[j]), invs[j]);
+        tnear = _mm_max_ps(_mm_min_ps(t2, t1), _mm_max_ps(_mm_min_ps(t1, t2), tnear));
+        tfar = _mm_min_ps(_mm_max_ps(t2, t1), _mm_min_ps(_mm_max_ps(t1, t2), tfar));
+    }
+
+    _mm_storeu_ps(tmin, tnear);
+
+    // hit if tfar >= tnear and tfar >= 0
+    __m128 hit = _mm_and_ps(_mm_cmpge_ps(tfar, tnear), _mm_cmpge_ps(tfar, _mm_setzero_ps()));
+    return (unsigned int)_mm_movemask_ps(hit) & fullMask;
+#else
+    unsigned int ret = 0;
+    for (unsigned int i = 0; i < noRays; i++) {
+        float o[3] = { ox[i], oy[i], oz[i] };
+        float inv[3] = { ix[i], iy[i], iz[i] };
+        float tnear = std::numeric_limits<float>::lowest();
+        float tfar = std::numeric_limits<float>::max();
+        for (int j = 0; j < 3; j++) {
+            float t1 = (min[j] - o[j]) * inv[j];
+            float t2 = (max[j] - o[j]) * inv[j];
+            tnear = std::fmaxf(tnear, std::fminf(t1, t2));
+            tfar = std::fminf(tfar, std::fmaxf(t1, t2));
+        }
+        tmin[i] = tnear;
+        if (tfar >= tnear && tfar >= 0.0f) {
+            ret |= 1u << i;
+        }
+    }
+    return ret;
+#endif
+}
+
+// test all rays against a sphere
+unsigned int RayPacket::intersectsSphere(glm::vec3 center, float radius, float tmin[RAYPACKET_SIZE]) {
+#ifdef RAYPACKET_SIMD
+    // vector from center of sphere to ray origins
+    __m128 cx = _mm_sub_ps(ox, _mm_set1_ps(center.x));
+    __m128 cy = _mm_sub_ps(oy, _mm_set1_ps(center.y));
+    __m128 cz = _mm_sub_ps(oz, _mm_set1_ps(center.z));
+
+    // coefficients of the quadratic
+    __m128 b = _mm_mul_ps(_mm_set1_ps(2.0f),
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, cx), _mm_mul_ps(dy, cy)), _mm_mul_ps(dz, cz)));
+    __m128 c = _mm_sub_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz)),
+        _mm_set1_ps(radius * radius));
+
+    // discriminant (no real root if negative)
+    __m128 D = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(_mm_set1_ps(4.0f), _mm_mul_ps(dirMagSq, c)));
+    __m128 hit = _mm_cmpge_ps(D, _mm_setzero_ps());
+
+    // both roots (clamp D so missed lanes stay finite)
+    D = _mm_sqrt_ps(_mm_max_ps(D, _mm_setzero_ps()));
+    __m128 denom = _mm_mul_ps(_mm_set1_ps(2.0f), dirMagSq);
+    __m128 t = _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(b, D)), denom);
+    __m128 tfar = _mm_div_ps(_mm_sub_ps(D, b), denom);
+    _mm_storeu_ps(tmin, t);
+
+    // both roots negative if the sphere is behind the origin
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(tfar, _mm_setzero_ps()));
+
+    return (unsigned int)_mm_movemask_ps(hit) & fullMask;
+#else
+    unsigned int ret = 0;
+    for (unsigned int i = 0; i < noRays; i++) {
+        float cx = ox[i] - center.x, cy = oy[i] - center.y, cz = oz[i] - center.z;
+        float b = 2.0f * (dx[i] * cx + dy[i] * cy + dz[i] * cz);
+        float c = (cx * cx + cy * cy + cz * cz) - radius * radius;
+        float D = b * b - 4.0f * (dirMagSq[i] * c);
+        if (D >= 0.0f) {
+            D = sqrtf(D);
+            tmin[i] = (-b - D) / (2.0f * dirMagSq[i]);
+            // both roots negative if the sphere is behind the origin
+            if ((-b + D) / (2.0f * dirMagSq[i]) >= 0.0f) {
+                ret |= 1u << i;
+            }
+        }
+    }
+    return ret;
+#endif
+}
@@ -0,0 +1,73 @@
+#ifndef RAYPACKET_H
+#define RAYPACKET_H
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "ray.h"
+
+// use SSE if the target has it (always on x64)
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define RAYPACKET_SIMD
+#include <xmmintrin.h>
+#endif
+
+#define RAYPACKET_SIZE 4
+
+/*
+    packet of rays tested together
+    - origins/directions are stored per component (structure of arrays)
+    - each test handles all rays in one go (SSE) and returns a mask of the rays that hit
+    - same results as Ray::intersectsBoundingRegion for each ray
+*/
+
+class RayPacket {
+public:
+    // number of rays in the packet (unused lanes repeat the last ray)
+    unsigned int noRays;
+
+#ifdef RAYPACKET_SIMD
+    // components of the origins
+    __m128 ox, oy, oz;
+    // components of the directions
+    __m128 dx, dy, dz;
+    // components of the inverse directions
+    __m128 ix, iy, iz;
+    // squared lengths of the directions
+    __m128 dirMagSq;
+#else
+    // components of the origins
+    float ox[RAYPACKET_SIZE], oy[RAYPACKET_SIZE], oz[RAYPACKET_SIZE];
+    // components of the directions
+    float dx[RAYPACKET_SIZE], dy[RAYPACKET_SIZE], dz[RAYPACKET_SIZE];
+    // components of the inverse directions
+    float ix[RAYPACKET_SIZE], iy[RAYPACKET_SIZE], iz[RAYPACKET_SIZE];
+    // squared lengths of the directions
+    float dirMagSq[RAYPACKET_SIZE];
+#endif
+
+    // mask with a bit for each ray in the packet
+    unsigned int fullMask;
+
+    /*
+        constructor
+    */
+
+    // initialize with up to RAYPACKET_SIZE rays
+    RayPacket(Ray* rays, unsigned int noRays);
+
+    /*
+        testing methods
+    */
+
+    // test all rays against a region, fills entry distance of each ray and returns mask of rays that hit
+    unsigned int intersectsBoundingRegion(BoundingRegion& br, float tmin[RAYPACKET_SIZE]);
+
+    // test all rays against an AABB
+    unsigned int intersectsAABB(glm::vec3 min, glm::vec3 max, float tmin[RAYPACKET_SIZE]);
+
+    // test all rays against a sphere
+    unsigned int intersectsSphere(glm::vec3 center, float radius, float tmin[RAYPACKET_SIZE]);
+};
+
+#endif
@@ -0,0 +1,386 @@
+#include "sweepandprune.h"
+#include "../graphics/models/box.hpp"
+
+#include <algorithm>
+#include <limits>
+
+/*
+    constructor
+*/
+
+// initialize empty (bounds are unused, the axes cover all objects)
+SweepAndPrune::SweepAndPrune(BoundingRegion /*bounds*/)
+    : stats(new TreeStats()) {}
+
+// free counters
+SweepAndPrune::~SweepAndPrune() {
+    delete stats;
+}
+
+/*
+    functionality
+*/
+
+// add instance to pending queue
+void SweepAndPrune::addToPending(RigidBody* instance, Model* model) {
+    // get all bounding regions of model and put them in queue
+    for (BoundingRegion br : model->boundingRegions) {
+        br.instance = instance;
+        br.cell = nullptr;
+        br.transform();
+        queue.push_back(br);
+    }
+}
+
+// sort endpoints and fill pair cache from scratch (called during initialization and when objects change)
+void SweepAndPrune::build() {
+    unsigned int noObjects = objects.size();
+
+    objMin.resize(noObjects);
+    objMax.resize(noObjects);
+    for (unsigned int i = 0; i < noObjects; i++) {
+        refreshBounds(i);
+    }
+
+    // endpoints of each object are stored next to each other, then sorted
+    for (int axis = 0; axis < 3; axis++) {
+        std::vector<sapEndpoint>& list = endpoints[axis];
+        list.resize(2 * noObjects);
+        for (unsigned int i = 0; i < noObjects; i++) {
+            list[2 * i] = { objMin[i][axis], i, true };
+            list[2 * i + 1] = { objMax[i][axis], i, false };
+        }
+        std::sort(list.begin(), list.end());
+    }
+
+    // sweep the first axis, each start overlaps the objects started but not ended before it on that axis
+    pairCache.clear();
+    std::vector<unsigned int> active;
+    for (sapEndpoint& e : endpoints[0]) {
+        if (e.isMin) {
+            for (unsigned int other : active) {
+                if (overlaps(other, e.obj)) {
+                    pairCache.insert(pairKey(other, e.obj));
+                }
+            }
+            active.push_back(e.obj);
+        }
+        else {
+            auto it = std::find(active.begin(), active.end(), e.obj);
+            *it = active.back();
+            active.pop_back();
+        }
+    }
+
+    // set state variables
+    treeBuilt = true;
+    treeReady = true;
+}
+
+// update objects (called during each iteration of main loop)
+void SweepAndPrune::update(Box& box) {
+    if (treeBuilt && treeReady) {
+        // remove objects that don't exist anymore (keep relative order)
+        unsigned int noAlive = 0;
+        for (unsigned int i = 0, len = objects.size(); i < len; i++) {
+            if (!States::isActive(&objects[i].instance->state, INSTANCE_DEAD)) {
+                if (noAlive != i) {
+                    objects[noAlive] = objects[i];
+                }
+                noAlive++;
+            }
+        }
+        bool removed = noAlive != objects.size();
+        objects.resize(noAlive);
+
+        // transform moved objects
+        bool moved = false;
+        for (unsigned int i = 0; i < noAlive; i++) {
+            if (States::isActive(&objects[i].instance->state, INSTANCE_MOVED)) {
+                objects[i].transform();
+                if (!removed) {
+                    refreshBounds(i);
+                }
+                moved = true;
+            }
+        }
+
+        /*
+            keep endpoints sorted
+            - indices changed if objects were removed, so rebuild
+            - else objects moved a little, so the order is almost right
+        */
+        if (removed) {
+            build();
+        }
+        else if (moved) {
+            for (int axis = 0; axis < 3; axis++) {
+                sortEndpoints(axis);
+            }
+        }
+
+        for (BoundingRegion& br : objects) {
+            box.positions.push_back(br.calculateCenter());
+            box.sizes.push_back(br.calculateDimensions());
+        }
+    }
+
+    processPending();
+}
+
+// process pending queue
+void SweepAndPrune::processPending() {
+    stats->pendingProcessed += queue.size();
+    if (treeBuilt && queue.size() == 0) {
+        return;
+    }
+
+    // new objects are sorted in with a rebuild
+    objects.insert(objects.end(), queue.begin(), queue.end());
+    queue.clear();
+    build();
+}
+
+// collect overlapping pairs (at least one moved) from the pair cache
+void SweepAndPrune::collectPairs(std::vector<BroadphasePair>& pairs) {
+    for (unsigned long long key : pairCache) {
+        BoundingRegion& a = objects[(unsigned int)(key >> 32)];
+        BoundingRegion& b = objects[(unsigned int)key];
+        if (!Broadphase::needsCheck(a, b)) {
+            continue;
+        }
+
+        // boxes around the regions overlap, test the regions
+        stats->coarseTests++;
+        if (a.intersectsWith(b)) {
+            stats->coarsePassed++;
+            pairs.push_back({ &a, &b });
+        }
+    }
+}
+
+// collect regions of moved instances (to query other structures with)
+void SweepAndPrune::collectMoved(std::vector<BoundingRegion*>& moved) {
+    for (BoundingRegion& br : objects) {
+        if (States::isActive(&br.instance->state, INSTANCE_MOVED)) {
+            moved.push_back(&br);
+        }
+    }
+}
+
+// check collisions with a ray (objects are visited in order along the main axis of the ray until past the nearest hit)
+BoundingRegion* SweepAndPrune::checkCollisionsRay(Ray r, float& tmin) {
+    BoundingRegion* ret = nullptr;
+
+    stats->raysCast++;
+
+    // walk the axis the ray moves along the most, so the nearest hit ends the walk soonest
+    glm::vec3 absDir = glm::abs(r.dir);
+    int axis = absDir.x >= absDir.y
+        ? (absDir.x >= absDir.z ? 0 : 2)
+        : (absDir.y >= absDir.z ? 1 : 2);
+    std::vector<sapEndpoint>& list = endpoints[axis];
+
+    float origin = r.origin[axis];
+    float dir = r.dir[axis];
+    if (dir >= 0.0f) {
+        // forwards through the starts, objects ending behind the origin are missed
+        for (unsigned int i = 0, len = list.size(); i < len; i++) {
+            sapEndpoint& e = list[i];
+            if (!e.isMin) {
+                continue;
+            }
+            if (dir > 0.0f && e.value > origin + tmin * dir) {
+                // starts after the nearest hit
+                break;
+            }
+            if (objMax[e.obj][axis] < origin) {
+                continue;
+            }
+
+            stats->rayNodesVisited++;
+            checkCollisionsRayObject(r, objects[e.obj], tmin, ret);
+        }
+    }
+    else {
+        // backwards through the ends, objects starting behind the origin are missed
+        for (int i = (int)list.size() - 1; i >= 0; i--) {
+            sapEndpoint& e = list[i];
+            if (e.isMin) {
+                continue;
+            }
+            if (e.value < origin + tmin * dir) {
+                // ends before the nearest hit
+                break;
+            }
+            if (objMin[e.obj][axis] > origin) {
+                continue;
+            }
+
+            stats->rayNodesVisited++;
+            checkCollisionsRayObject(r, objects[e.obj], tmin, ret);
+        }
+    }
+
+    return ret;
+}
+
+// check collisions with a batch of rays (nearest hit and distance for each ray, null if no hit)
+void SweepAndPrune::checkCollisionsRays(std::vector<Ray>& rays, std::vector<BoundingRegion*>& hits, std::vector<float>& tmin) {
+    unsigned int noRays = rays.size();
+    hits.assign(noRays, nullptr);
+    tmin.assign(noRays, std::numeric_limits<float>::max());
+
+    // each ray walks its own axis
+    for (unsigned int i = 0; i < noRays; i++) {
+        hits[i] = checkCollisionsRay(rays[i], tmin[i]);
+    }
+}
+
+// collect instances with a region in the view frustum (appended to the list of each model, no duplicates)
+void SweepAndPrune::frustumCull(Frustum& frustum, VisibleInstances& visible) {
+    // flat list, so test every object
+    for (BoundingRegion& br : objects) {
+        if (frustum.intersectsRegion(br)) {
+            visible[br.instance->modelId].push_back(br.instance);
+        }
+    }
+
+    // objects waiting in the queue (not sorted in yet) are tested directly
+    for (BoundingRegion& br : queue) {
+        if (frustum.intersectsRegion(br)) {
+            visible[br.instance->modelId].push_back(br.instance);
+        }
+    }
+
+    // instances with multiple regions may have been added more than once, keep the first
+    std::unordered_set<RigidBody*> found;
+    for (auto& pair : visible) {
+        std::vector<RigidBody*>& list = pair.second;
+        unsigned int noUnique = 0;
+        for (unsigned int i = 0, len = list.size(); i < len; i++) {
+            if (found.insert(list[i]).second) {
+                list[noUnique++] = list[i];
+            }
+        }
+        list.resize(noUnique);
+    }
+}
+
+// add structure to the counters (call after the update)
+void SweepAndPrune::collectStats() {
+    // one set of sorted lists, the cache holds the overlapping pairs
+    stats->noNodes++;
+    stats->noObjects += objects.size();
+    stats->maxObjectsPerNode = std::max(stats->maxObjectsPerNode, (unsigned int)objects.size());
+    stats->noQueued += queue.size();
+    stats->cachedPairs += pairCache.size();
+}
+
+// destroy object (free memory)
+void SweepAndPrune::destroy() {
+    objects.clear();
+    objMin.clear();
+    objMax.clear();
+    for (int axis = 0; axis < 3; axis++) {
+        endpoints[axis].clear();
+    }
+    pairCache.clear();
+    queue.clear();
+}
+
+/*
+    private
+*/
+
+// recalculate corners of object
+void SweepAndPrune::refreshBounds(unsigned int idx) {
+    glm::vec3 center = objects[idx].calculateCenter();
+    glm::vec3 halfDimensions = objects[idx].calculateDimensions() / 2.0f;
+    objMin[idx] = center - halfDimensions;
+    objMax[idx] = center + halfDimensions;
+}
+
+// determine if the bounds of two objects overlap (AABB)
+bool SweepAndPrune::overlaps(unsigned int a, unsigned int b) {
+    // touching counts, same as the order of the endpoints
+    return objMin[a].x <= objMax[b].x && objMin[b].x <= objMax[a].x &&
+        objMin[a].y <= objMax[b].y && objMin[b].y <= objMax[a].y &&
+        objMin[a].z <= objMax[b].z && objMin[b].z <= objMax[a].z;
+}
+
+// get key of pair in the cache
+unsigned long long SweepAndPrune::pairKey(unsigned int a, unsigned int b) {
+    if (a > b) {
+        std::swap(a, b);
+    }
+    return ((unsigned long long)a << 32) | b;
+}
+
+// fix order of endpoints on axis after objects moved, updating the pair cache for each start/end swap
+void SweepAndPrune::sortEndpoints(int axis) {
+    std::vector<sapEndpoint>& list = endpoints[axis];
+    for (sapEndpoint& e : list) {
+        e.value = e.isMin ? objMin[e.obj][axis] : objMax[e.obj][axis];
+    }
+
+    /*
+        insertion sort (few endpoints move far between frames)
+        - each swap fixes one change in order since the last frame
+        - start moving before an end: the objects overlap on this axis, add if they overlap on all
+        - end moving before a start: the objects are apart on this axis, remove
+        - starts passing starts or ends passing ends change nothing
+    */
+    for (unsigned int i = 1, len = list.size(); i < len; i++) {
+        sapEndpoint e = list[i];
+        unsigned int j = i;
+        while (j > 0 && e < list[j - 1]) {
+            sapEndpoint& prev = list[j - 1];
+            if (e.isMin && !prev.isMin) {
+                if (overlaps(e.obj, prev.obj)) {
+                    pairCache.insert(pairKey(e.obj, prev.obj));
+                }
+            }
+            else if (!e.isMin && prev.isMin) {
+                pairCache.erase(pairKey(e.obj, prev.obj));
+            }
+            stats->endpointSwaps++;
+
+            list[j] = prev;
+            j--;
+        }
+        list[j] = e;
+    }
+}
+
+// test ray against region, updates nearest hit
+void SweepAndPrune::checkCollisionsRayObject(Ray& r, BoundingRegion& br, float& tmin, BoundingRegion*& ret) {
+    float tmin_tmp = std::numeric_limits<float>::max();
+    float tmax_tmp = std::numeric_limits<float>::lowest();
+    float t_tmp = std::numeric_limits<float>::max();
+
+    // coarse check - check against BR
+    if (r.intersectsBoundingRegion(br, tmin_tmp, tmax_tmp)) {
+        if (tmin_tmp > tmin) {
+            return;
+        }
+        else if (br.collisionMesh) {
+            // fine grain check with collision mesh
+            t_tmp = std::numeric_limits<float>::max();
+            if (r.intersectsMesh(br.collisionMesh, br.instance, t_tmp)) {
+                if (t_tmp < tmin) {
+                    // found closer collision
+                    tmin = t_tmp;
+                    ret = &br;
+                }
+            }
+        }
+        else {
+            // rely on coarse check
+            if (tmin_tmp < tmin) {
+                tmin = tmin_tmp;
+                ret = &br;
+            }
+        }
+    }
+}
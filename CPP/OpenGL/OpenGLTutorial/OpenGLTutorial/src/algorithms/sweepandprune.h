@@ -0,0 +1,140 @@
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include <vector>
+#include <unordered_set>
+
+#include <glm/glm.hpp>
+
+#include "states.hpp"
+#include "bounds.h"
+#include "ray.h"
+#include "frustum.h"
+#include "treestats.h"
+#include "broadphase.h"
+
+#include "../graphics/objects/model.h"
+
+// forward declaration
+class Model;
+class BoundingRegion;
+class Box;
+
+/*
+    structure to represent the start or end of an object on the sorting axis
+*/
+
+struct sapEndpoint {
+    // position on the axis
+    float value;
+    // index of the object
+    unsigned int obj;
+    // if this is the start of the object
+    bool isMin;
+
+    // sorting order (starts go before ends at the same position, so touching objects overlap)
+    bool operator<(const sapEndpoint& e) const {
+        return value < e.value || (value == e.value && isMin && !e.isMin);
+    }
+};
+
+/*
+    sweep and prune
+    - the start and end of each object on each axis are kept in sorted lists
+    - objects move little between frames, so the lists are fixed with an insertion sort each update
+    - a pair can only begin or stop overlapping when a start and an end swap on some axis,
+        so only those swaps add or remove pairs in the cache of overlapping objects
+    - the lists and cache are rebuilt when objects are added or removed
+    - same build/update/ray/collision entry points as Octree::node, so Scene::octree can switch to it
+*/
+
+class SweepAndPrune {
+public:
+    // bounds of all objects
+    std::vector<BoundingRegion> objects;
+    // corners of the bounds of each object (AABB)
+    std::vector<glm::vec3> objMin;
+    std::vector<glm::vec3> objMax;
+
+    // sorted starts and ends of the objects on each axis
+    std::vector<sapEndpoint> endpoints[3];
+
+    // pairs of objects with overlapping bounds (lower index in the upper 32 bits)
+    std::unordered_set<unsigned long long> pairCache;
+
+    // if tree is ready
+    bool treeReady = false;
+    // if tree is built
+    bool treeBuilt = false;
+
+    // objects to be added at the next rebuild
+    std::vector<BoundingRegion> queue;
+
+    // counters for the current frame
+    TreeStats* stats;
+
+    /*
+        constructor
+    */
+
+    // initialize empty (bounds are unused, the axes cover all objects)
+    SweepAndPrune(BoundingRegion bounds);
+
+    // free counters
+    ~SweepAndPrune();
+
+    /*
+        functionality
+    */
+
+    // add instance to pending queue
+    void addToPending(RigidBody* instance, Model* model);
+
+    // sort endpoints and fill pair cache from scratch (called during initialization and when objects change)
+    void build();
+
+    // update objects (called during each iteration of main loop)
+    void update(Box& box);
+
+    // process pending queue
+    void processPending();
+
+    // collect overlapping pairs (at least one moved) from the pair cache
+    void collectPairs(std::vector<BroadphasePair>& pairs);
+
+    // collect regions of moved instances (to query other structures with)
+    void collectMoved(std::vector<BoundingRegion*>& moved);
+
+    // check collisions with a ray (objects are visited in order along the main axis of the ray until past the nearest hit)
+    BoundingRegion* checkCollisionsRay(Ray r, float& tmin);
+
+    // check collisions with a batch of rays (nearest hit and distance for each ray, null if no hit)
+    void checkCollisionsRays(std::vector<Ray>& rays, std::vector<BoundingRegion*>& hits, std::vector<float>& tmin);
+
+    // collect instances with a region in the view frustum (appended to the list of each model, no duplicates)
+    void frustumCull(Frustum& frustum, VisibleInstances& visible);
+
+    // add structure to the counters (call after the update)
+    void collectStats();
+
+    // destroy object (free memory)
+    void destroy();
+
+private:
+    // recalculate corners of object
+    void refreshBounds(unsigned int idx);
+
+    // determine if the bounds of two objects overlap (AABB)
+    bool overlaps(unsigned int a, unsigned int b);
+
+    // get key of pair in the cache
+    static unsigned long long pairKey(unsigned int a, unsigned int b);
+
+    // fix order of endpoints on axis after objects moved, updating the pair cache for each start/end swap
+    void sortEndpoints(int axis);
+
+    // test ray against region, updates nearest hit
+    void checkCollisionsRayObject(Ray& r, BoundingRegion& br, float& tmin, BoundingRegion*& ret);
+};
+
+#endif
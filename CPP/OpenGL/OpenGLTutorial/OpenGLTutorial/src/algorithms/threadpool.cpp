@@ -0,0 +1,148 @@
+#include "threadpool.h"
+
+thread_local int ThreadPool::currentWorker = -1;
+
+/*
+    constructor
+*/
+
+// start with number of worker threads (0 = number of cores)
+ThreadPool::ThreadPool(unsigned int noThreads)
+    : running(true), pending(0), nextWorker(0) {
+    if (!noThreads) {
+        noThreads = std::thread::hardware_concurrency();
+        if (!noThreads) {
+            noThreads = 1;
+        }
+    }
+
+    for (unsigned int i = 0; i < noThreads; i++) {
+        workers.push_back(std::unique_ptr<worker>(new worker()));
+    }
+    for (unsigned int i = 0; i < noThreads; i++) {
+        threads.push_back(std::thread(&ThreadPool::workerLoop, this, (int)i));
+    }
+}
+
+// stop and join all workers
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    sleepCondition.notify_all();
+
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+/*
+    functionality
+*/
+
+// schedule task, counter is decremented once the task has run
+void ThreadPool::push(std::function<void()> task, TaskCounter* counter) {
+    if (counter) {
+        (*counter)++;
+    }
+
+    // workers push to their own deque, other threads spread tasks out
+    int idx = currentWorker != -1
+        ? currentWorker
+        : (int)(nextWorker++ % workers.size());
+
+    {
+        std::lock_guard<std::mutex> lock(workers[idx]->mutex);
+        workers[idx]->tasks.push_back([task, counter]() -> void {
+            task();
+            if (counter) {
+                (*counter)--;
+            }
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        pending++;
+    }
+    sleepCondition.notify_one();
+}
+
+// run tasks on the calling thread until the counter reaches 0
+void ThreadPool::wait(TaskCounter& counter) {
+    while (counter > 0) {
+        if (!runOne()) {
+            // remaining tasks are running on other threads
+            std::this_thread::yield();
+        }
+    }
+}
+
+/*
+    accessors
+*/
+
+// number of worker threads
+unsigned int ThreadPool::size() {
+    return workers.size();
+}
+
+/*
+    private methods
+*/
+
+// loop for each worker thread
+void ThreadPool::workerLoop(int idx) {
+    currentWorker = idx;
+
+    while (true) {
+        if (runOne()) {
+            continue;
+        }
+
+        // nothing to do, sleep until work is pushed
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [this]() -> bool {
+            return !running || pending > 0;
+        });
+
+        if (!running && pending == 0) {
+            return;
+        }
+    }
+}
+
+// pop own task or steal one, then run it (false if nothing found)
+bool ThreadPool::runOne() {
+    std::function<void()> task;
+    unsigned int noWorkers = workers.size();
+
+    // own deque (newest first)
+    if (currentWorker != -1) {
+        worker* w = workers[currentWorker].get();
+        std::lock_guard<std::mutex> lock(w->mutex);
+        if (w->tasks.size() != 0) {
+            task = std::move(w->tasks.back());
+            w->tasks.pop_back();
+        }
+    }
+
+    // steal from other deques (oldest first)
+    for (unsigned int i = 1; !task && i <= noWorkers; i++) {
+        worker* w = workers[(currentWorker + i) % noWorkers].get();
+        std::lock_guard<std::mutex> lock(w->mutex);
+        if (w->tasks.size() != 0) {
+            task = std::move(w->tasks.front());
+            w->tasks.pop_front();
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+
+    pending--;
+    task();
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/*
+    work stealing thread pool
+    - each worker owns a deque of tasks
+    - a worker pops from the back of its own deque (newest first)
+    - an idle worker steals from the front of another deque (oldest first)
+    - tasks are grouped by a counter, wait() helps to run tasks until the counter reaches 0
+*/
+
+// counter of outstanding tasks in a group
+typedef std::atomic<unsigned int> TaskCounter;
+
+class ThreadPool {
+public:
+    /*
+        constructor
+    */
+
+    // start with number of worker threads (0 = number of cores)
+    ThreadPool(unsigned int noThreads = 0);
+
+    // stop and join all workers
+    ~ThreadPool();
+
+    /*
+        functionality
+    */
+
+    // schedule task, counter is decremented once the task has run
+    void push(std::function<void()> task, TaskCounter* counter);
+
+    // run tasks on the calling thread until the counter reaches 0
+    void wait(TaskCounter& counter);
+
+    /*
+        accessors
+    */
+
+    // number of worker threads
+    unsigned int size();
+
+private:
+    /*
+        structure to represent the deque of each worker
+    */
+    struct worker {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    // deques (one per worker thread)
+    std::vector<std::unique_ptr<worker>> workers;
+    // worker threads
+    std::vector<std::thread> threads;
+
+    // if pool is accepting work
+    std::atomic<bool> running;
+    // number of queued tasks
+    std::atomic<unsigned int> pending;
+    // next deque for tasks pushed from outside the pool
+    std::atomic<unsigned int> nextWorker;
+
+    // to put idle workers to sleep
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+
+    // index of the worker running on this thread (-1 if not a worker)
+    static thread_local int currentWorker;
+
+    // loop for each worker thread
+    void workerLoop(int idx);
+
+    // pop own task or steal one, then run it (false if nothing found)
+    bool runOne();
+};
+
+#endif
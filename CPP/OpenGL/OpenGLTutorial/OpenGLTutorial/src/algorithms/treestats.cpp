@@ -0,0 +1,96 @@
+#include "treestats.h"
+
+/*
+    constructor
+*/
+
+// initialize with zeros
+TreeStats::TreeStats() {
+    reset();
+}
+
+/*
+    modifiers
+*/
+
+// zero all values for a new frame
+void TreeStats::reset() {
+    noNodes = 0;
+    maxDepth = 0;
+    noObjects = 0;
+    maxObjectsPerNode = 0;
+    noQueued = 0;
+    cachedPairs = 0;
+
+    pendingProcessed = 0;
+    branchesPruned = 0;
+    nodesSplit = 0;
+    mergesPending = 0;
+    rootGrowths = 0;
+    coarseTests = 0;
+    coarsePassed = 0;
+    raysCast = 0;
+    rayNodesVisited = 0;
+    endpointSwaps = 0;
+
+    pendingTime = 0.0;
+    updateTime = 0.0;
+    broadphaseTime = 0.0;
+    narrowphaseTime = 0.0;
+    resolveTime = 0.0;
+}
+
+/*
+    output
+*/
+
+// get values as a json object
+jsoncpp::json TreeStats::toJson() {
+    jsoncpp::json ret;
+
+    // structure
+    ret["nodes"] = (int)noNodes;
+    ret["maxDepth"] = (int)maxDepth;
+    ret["objects"] = (int)noObjects;
+    ret["maxObjectsPerNode"] = (int)maxObjectsPerNode;
+    ret["avgObjectsPerNode"] = noNodes ? (double)noObjects / noNodes : 0.0;
+    ret["queued"] = (int)noQueued;
+    ret["cachedPairs"] = (int)cachedPairs;
+
+    // work
+    ret["pendingProcessed"] = (int)pendingProcessed.load();
+    ret["branchesPruned"] = (int)branchesPruned.load();
+    ret["nodesSplit"] = (int)nodesSplit.load();
+    ret["mergesPending"] = (int)mergesPending.load();
+    ret["rootGrowths"] = (int)rootGrowths;
+    ret["coarseTests"] = (int)coarseTests;
+    ret["coarsePassed"] = (int)coarsePassed;
+    ret["coarseFailed"] = (int)(coarseTests - coarsePassed);
+    ret["raysCast"] = (int)raysCast;
+    ret["rayNodesVisited"] = (int)rayNodesVisited;
+    ret["nodesPerRay"] = raysCast ? (double)rayNodesVisited / raysCast : 0.0;
+    ret["endpointSwaps"] = (int)endpointSwaps;
+
+    // timers
+    ret["pendingMs"] = pendingTime;
+    ret["updateMs"] = updateTime;
+    ret["broadphaseMs"] = broadphaseTime;
+    ret["narrowphaseMs"] = narrowphaseTime;
+    ret["resolveMs"] = resolveTime;
+
+    return ret;
+}
+
+/*
+    timing
+*/
+
+// get current time
+StatTime TreeStats::now() {
+    return std::chrono::steady_clock::now();
+}
+
+// get milliseconds since start
+double TreeStats::msSince(StatTime start) {
+    return std::chrono::duration<double, std::milli>(now() - start).count();
+}
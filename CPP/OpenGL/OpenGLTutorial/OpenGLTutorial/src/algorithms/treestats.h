@@ -0,0 +1,105 @@
+#ifndef TREESTATS_H
+#define TREESTATS_H
+
+#include <chrono>
+#include <atomic>
+
+#include <jsoncpp/json.hpp>
+
+/*
+    counters and timers for the work done by a spatial tree in one frame
+    - always compiled, counting is a plain add on the hot paths
+    - structure counts are gathered in one walk after the update
+    - reset after each frame is published (rays cast before the update count towards the frame)
+*/
+
+// point in time for the timers
+typedef std::chrono::steady_clock::time_point StatTime;
+
+class TreeStats {
+public:
+    /*
+        structure (gathered after the update)
+    */
+
+    // number of nodes
+    unsigned int noNodes;
+    // depth of deepest node (root = 0)
+    unsigned int maxDepth;
+    // number of objects in node lists
+    unsigned int noObjects;
+    // largest object list in a node
+    unsigned int maxObjectsPerNode;
+    // number of objects still waiting in queues
+    unsigned int noQueued;
+    // candidate pairs kept between frames (sweep and prune)
+    unsigned int cachedPairs;
+
+    /*
+        work counters
+    */
+
+    // objects taken from pending queues (written by worker threads in a parallel update)
+    std::atomic<unsigned int> pendingProcessed;
+    // branches released or merged into their parent (written by worker threads in a parallel update)
+    std::atomic<unsigned int> branchesPruned;
+    // leaves split into children (written by worker threads in a parallel update or build)
+    std::atomic<unsigned int> nodesSplit;
+    // nodes counting down to merge their children (written by worker threads in a parallel update)
+    std::atomic<unsigned int> mergesPending;
+    // times the root was doubled to fit an object
+    unsigned int rootGrowths;
+    // coarse region tests in the broad phase
+    unsigned int coarseTests;
+    // coarse region tests that overlapped
+    unsigned int coarsePassed;
+    // single rays cast into the tree
+    unsigned int raysCast;
+    // nodes visited by single rays
+    unsigned int rayNodesVisited;
+    // endpoint swaps while re-sorting (sweep and prune)
+    unsigned int endpointSwaps;
+
+    /*
+        timers (milliseconds)
+    */
+
+    double pendingTime;
+    double updateTime;
+    double broadphaseTime;
+    double narrowphaseTime;
+    double resolveTime;
+
+    /*
+        constructor
+    */
+
+    // initialize with zeros
+    TreeStats();
+
+    /*
+        modifiers
+    */
+
+    // zero all values for a new frame
+    void reset();
+
+    /*
+        output
+    */
+
+    // get values as a json object
+    jsoncpp::json toJson();
+
+    /*
+        timing
+    */
+
+    // get current time
+    static StatTime now();
+
+    // get milliseconds since start
+    static double msSince(StatTime start);
+};
+
+#endif
@@ -0,0 +1,356 @@
+#include "trianglepacket.h"
+
+#include "math/linalg.h"
+
+#include <limits>
+#include <cmath>
+
+/*
+    helpers
+*/
+
+// signed area of the parallelogram spanned by b - a and c - a (positive if counterclockwise)
+static float orient2D(glm::vec2 a, glm::vec2 b, glm::vec2 c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// determine if c lies in the box spanned by segment ab (used when the three points are on a line)
+static bool onSegment2D(glm::vec2 a, glm::vec2 b, glm::vec2 c) {
+    return std::fminf(a.x, b.x) <= c.x && c.x <= std::fmaxf(a.x, b.x) &&
+        std::fminf(a.y, b.y) <= c.y && c.y <= std::fmaxf(a.y, b.y);
+}
+
+// determine if segments ab and cd intersect (touching counts)
+static bool segmentsIntersect2D(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec2 d) {
+    float o1 = orient2D(a, b, c);
+    float o2 = orient2D(a, b, d);
+    float o3 = orient2D(c, d, a);
+    float o4 = orient2D(c, d, b);
+
+    if (((o1 > 0.0f && o2 < 0.0f) || (o1 < 0.0f && o2 > 0.0f)) &&
+        ((o3 > 0.0f && o4 < 0.0f) || (o3 < 0.0f && o4 > 0.0f))) {
+        // endpoints of each segment on different sides of the other
+        return true;
+    }
+
+    // an endpoint on the other segment
+    return (o1 == 0.0f && onSegment2D(a, b, c)) ||
+        (o2 == 0.0f && onSegment2D(a, b, d)) ||
+        (o3 == 0.0f && onSegment2D(c, d, a)) ||
+        (o4 == 0.0f && onSegment2D(c, d, b));
+}
+
+// determine if point is inside triangle t (on an edge counts)
+static bool triangleContainsPoint2D(glm::vec2 t[3], glm::vec2 point) {
+    float o1 = orient2D(t[0], t[1], point);
+    float o2 = orient2D(t[1], t[2], point);
+    float o3 = orient2D(t[2], t[0], point);
+
+    return (o1 >= 0.0f && o2 >= 0.0f && o3 >= 0.0f) ||
+        (o1 <= 0.0f && o2 <= 0.0f && o3 <= 0.0f);
+}
+
+// square of the distance to the plane of a triangle below which a point counts as in the plane
+static float planeToleranceSq(glm::vec3 n, glm::vec3 t[3]) {
+    // rounding error of n dot (x - t[0]) grows with the normal and the size of the triangle
+    float maxEdgeSq = std::fmaxf(magsq(t[1] - t[0]), std::fmaxf(magsq(t[2] - t[1]), magsq(t[0] - t[2])));
+    return TRIANGLEPACKET_EPSILON * TRIANGLEPACKET_EPSILON * magsq(n) * maxEdgeSq;
+}
+
+#ifdef TRIANGLEPACKET_SIMD
+// set distances within the tolerance to exactly 0
+static __m128 snapToPlane(__m128 dist, __m128 tolSq) {
+    return _mm_andnot_ps(_mm_cmple_ps(_mm_mul_ps(dist, dist), tolSq), dist);
+}
+#endif
+
+/*
+    segment of the shared line where a triangle crosses the other plane
+    - p: position of each vertex projected onto the line
+    - dist: distance of each vertex to the other plane (not all on one side)
+    - each edge with endpoints on different sides (or touching) adds the point where it crosses,
+        an edge lying in the plane adds both endpoints
+*/
+
+#ifdef TRIANGLEPACKET_SIMD
+static void crossingInterval(__m128 p[3], __m128 dist[3], __m128& lo, __m128& hi) {
+    __m128 zero = _mm_setzero_ps();
+    __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    __m128 negInf = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+    lo = inf;
+    hi = negInf;
+
+    for (int i = 0; i < 3; i++) {
+        __m128 pa = p[i], pb = p[(i + 1) % 3];
+        __m128 da = dist[i], db = dist[(i + 1) % 3];
+
+        // endpoints on different sides or touching
+        __m128 crosses = _mm_or_ps(
+            _mm_and_ps(_mm_cmple_ps(da, zero), _mm_cmpge_ps(db, zero)),
+            _mm_and_ps(_mm_cmpge_ps(da, zero), _mm_cmple_ps(db, zero)));
+
+        // point of crossing (edges in the plane keep their endpoints)
+        __m128 denom = _mm_sub_ps(da, db);
+        __m128 inPlane = _mm_cmpeq_ps(denom, zero);
+        __m128 t = _mm_add_ps(pa, _mm_mul_ps(_mm_sub_ps(pb, pa), _mm_div_ps(da, denom)));
+        __m128 v1 = _mm_or_ps(_mm_and_ps(inPlane, pa), _mm_andnot_ps(inPlane, t));
+        __m128 v2 = _mm_or_ps(_mm_and_ps(inPlane, pb), _mm_andnot_ps(inPlane, t));
+
+        lo = _mm_min_ps(lo, _mm_or_ps(_mm_and_ps(crosses, _mm_min_ps(v1, v2)), _mm_andnot_ps(crosses, inf)));
+        hi = _mm_max_ps(hi, _mm_or_ps(_mm_and_ps(crosses, _mm_max_ps(v1, v2)), _mm_andnot_ps(crosses, negInf)));
+    }
+}
+#else
+static void crossingInterval(float p[3], float dist[3], float& lo, float& hi) {
+    lo = std::numeric_limits<float>::infinity();
+    hi = -std::numeric_limits<float>::infinity();
+
+    for (int i = 0; i < 3; i++) {
+        float pa = p[i], pb = p[(i + 1) % 3];
+        float da = dist[i], db = dist[(i + 1) % 3];
+
+        if (!((da <= 0.0f && db >= 0.0f) || (da >= 0.0f && db <= 0.0f))) {
+            // both on one side
+            continue;
+        }
+
+        if (da == db) {
+            // edge in the plane
+            lo = std::fminf(lo, std::fminf(pa, pb));
+            hi = std::fmaxf(hi, std::fmaxf(pa, pb));
+        }
+        else {
+            float t = pa + (pb - pa) * (da / (da - db));
+            lo = std::fminf(lo, t);
+            hi = std::fmaxf(hi, t);
+        }
+    }
+}
+#endif
+
+/*
+    constructor
+*/
+
+// initialize with up to TRIANGLEPACKET_SIZE triangles (3 vertices each)
+TrianglePacket::TrianglePacket(glm::vec3* triangles, unsigned int noTriangles)
+    : noTriangles(noTriangles), fullMask((1u << noTriangles) - 1) {
+    float vals[13][TRIANGLEPACKET_SIZE];
+    for (unsigned int i = 0; i < TRIANGLEPACKET_SIZE; i++) {
+        // unused lanes repeat the last triangle (masked out of results)
+        glm::vec3* t = triangles + 3 * (i < noTriangles ? i : noTriangles - 1);
+        glm::vec3 n = glm::cross(t[1] - t[0], t[2] - t[0]);
+        for (int j = 0; j < 3; j++) {
+            vertices[i][j] = t[j];
+            vals[j][i] = t[0][j];
+            vals[3 + j][i] = t[1][j];
+            vals[6 + j][i] = t[2][j];
+            vals[9 + j][i] = n[j];
+        }
+        vals[12][i] = planeToleranceSq(n, t);
+    }
+
+#ifdef TRIANGLEPACKET_SIMD
+    ax = _mm_loadu_ps(vals[0]); ay = _mm_loadu_ps(vals[1]); az = _mm_loadu_ps(vals[2]);
+    bx = _mm_loadu_ps(vals[3]); by = _mm_loadu_ps(vals[4]); bz = _mm_loadu_ps(vals[5]);
+    cx = _mm_loadu_ps(vals[6]); cy = _mm_loadu_ps(vals[7]); cz = _mm_loadu_ps(vals[8]);
+    nx = _mm_loadu_ps(vals[9]); ny = _mm_loadu_ps(vals[10]); nz = _mm_loadu_ps(vals[11]);
+    tolSq = _mm_loadu_ps(vals[12]);
+#else
+    for (unsigned int i = 0; i < TRIANGLEPACKET_SIZE; i++) {
+        ax[i] = vals[0][i]; ay[i] = vals[1][i]; az[i] = vals[2][i];
+        bx[i] = vals[3][i]; by[i] = vals[4][i]; bz[i] = vals[5][i];
+        cx[i] = vals[6][i]; cy[i] = vals[7][i]; cz[i] = vals[8][i];
+        nx[i] = vals[9][i]; ny[i] = vals[10][i]; nz[i] = vals[11][i];
+        tolSq[i] = vals[12][i];
+    }
+#endif
+}
+
+/*
+    testing methods
+*/
+
+// test all triangles against a triangle, returns mask of the triangles that intersect it
+unsigned int TrianglePacket::intersectsTriangle(glm::vec3 P1, glm::vec3 P2, glm::vec3 P3) {
+    // plane of the triangle
+    glm::vec3 N = glm::cross(P2 - P1, P3 - P1);
+    if (N.x == 0.0f && N.y == 0.0f && N.z == 0.0f) {
+        // degenerate
+        return 0;
+    }
+
+    glm::vec3 P[3] = { P1, P2, P3 };
+    float tolSqP = planeToleranceSq(N, P);
+    unsigned int ret = 0;
+    unsigned int coplanar = 0;
+
+#ifdef TRIANGLEPACKET_SIMD
+    __m128 zero = _mm_setzero_ps();
+
+    // distances of the vertices of the triangle to each plane of the packet (measured from the first vertex of each plane)
+    __m128 distP[3];
+    for (int i = 0; i < 3; i++) {
+        distP[i] = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(nx, _mm_sub_ps(_mm_set1_ps(P[i].x), ax)),
+            _mm_mul_ps(ny, _mm_sub_ps(_mm_set1_ps(P[i].y), ay))),
+            _mm_mul_ps(nz, _mm_sub_ps(_mm_set1_ps(P[i].z), az)));
+        distP[i] = snapToPlane(distP[i], tolSq);
+    }
+
+    // distances of the vertices of the packet to the plane of the triangle
+    __m128 Nx = _mm_set1_ps(N.x), Ny = _mm_set1_ps(N.y), Nz = _mm_set1_ps(N.z);
+    __m128 Px = _mm_set1_ps(P1.x), Py = _mm_set1_ps(P1.y), Pz = _mm_set1_ps(P1.z);
+    __m128 distU[3] = {
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(Nx, _mm_sub_ps(ax, Px)), _mm_mul_ps(Ny, _mm_sub_ps(ay, Py))), _mm_mul_ps(Nz, _mm_sub_ps(az, Pz))),
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(Nx, _mm_sub_ps(bx, Px)), _mm_mul_ps(Ny, _mm_sub_ps(by, Py))), _mm_mul_ps(Nz, _mm_sub_ps(bz, Pz))),
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(Nx, _mm_sub_ps(cx, Px)), _mm_mul_ps(Ny, _mm_sub_ps(cy, Py))), _mm_mul_ps(Nz, _mm_sub_ps(cz, Pz)))
+    };
+    __m128 tolSqU = _mm_set1_ps(tolSqP);
+    for (int i = 0; i < 3; i++) {
+        distU[i] = snapToPlane(distU[i], tolSqU);
+    }
+
+    // lanes with one triangle strictly on one side of the other plane
+    __m128 separated = _mm_or_ps(
+        _mm_or_ps(
+            _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(distP[0], zero), _mm_cmpgt_ps(distP[1], zero)), _mm_cmpgt_ps(distP[2], zero)),
+            _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(distP[0], zero), _mm_cmplt_ps(distP[1], zero)), _mm_cmplt_ps(distP[2], zero))),
+        _mm_or_ps(
+            _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(distU[0], zero), _mm_cmpgt_ps(distU[1], zero)), _mm_cmpgt_ps(distU[2], zero)),
+            _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(distU[0], zero), _mm_cmplt_ps(distU[1], zero)), _mm_cmplt_ps(distU[2], zero))));
+
+    // degenerate lanes
+    __m128 degenerate = _mm_and_ps(_mm_and_ps(_mm_cmpeq_ps(nx, zero), _mm_cmpeq_ps(ny, zero)), _mm_cmpeq_ps(nz, zero));
+
+    // lanes in the plane of the triangle (separated lanes are rejected first, as in the scalar test)
+    __m128 inPlane = _mm_and_ps(_mm_and_ps(_mm_cmpeq_ps(distU[0], zero), _mm_cmpeq_ps(distU[1], zero)), _mm_cmpeq_ps(distU[2], zero));
+    coplanar = (unsigned int)_mm_movemask_ps(_mm_andnot_ps(_mm_or_ps(separated, degenerate), inPlane)) & fullMask;
+
+    unsigned int candidates = ~(unsigned int)_mm_movemask_ps(_mm_or_ps(_mm_or_ps(separated, degenerate), inPlane)) & fullMask;
+    if (candidates) {
+        // direction of the line shared by both planes
+        __m128 Lx = _mm_sub_ps(_mm_mul_ps(Ny, nz), _mm_mul_ps(Nz, ny));
+        __m128 Ly = _mm_sub_ps(_mm_mul_ps(Nz, nx), _mm_mul_ps(Nx, nz));
+        __m128 Lz = _mm_sub_ps(_mm_mul_ps(Nx, ny), _mm_mul_ps(Ny, nx));
+
+        // project vertices onto the line
+        __m128 projP[3];
+        for (int i = 0; i < 3; i++) {
+            projP[i] = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(Lx, _mm_set1_ps(P[i].x)),
+                _mm_mul_ps(Ly, _mm_set1_ps(P[i].y))),
+                _mm_mul_ps(Lz, _mm_set1_ps(P[i].z)));
+        }
+        __m128 projU[3] = {
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(Lx, ax), _mm_mul_ps(Ly, ay)), _mm_mul_ps(Lz, az)),
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(Lx, bx), _mm_mul_ps(Ly, by)), _mm_mul_ps(Lz, bz)),
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(Lx, cx), _mm_mul_ps(Ly, cy)), _mm_mul_ps(Lz, cz))
+        };
+
+        // segments where each triangle crosses the other plane must overlap
+        __m128 loP, hiP, loU, hiU;
+        crossingInterval(projP, distP, loP, hiP);
+        crossingInterval(projU, distU, loU, hiU);
+        __m128 overlap = _mm_and_ps(_mm_cmpge_ps(hiP, loU), _mm_cmpge_ps(hiU, loP));
+
+        ret = (unsigned int)_mm_movemask_ps(overlap) & candidates;
+    }
+#else
+    for (unsigned int i = 0; i < noTriangles; i++) {
+        glm::vec3 n(nx[i], ny[i], nz[i]);
+        if (n.x == 0.0f && n.y == 0.0f && n.z == 0.0f) {
+            // degenerate
+            continue;
+        }
+
+        // distances of each triangle to the plane of the other (measured from the first vertex of the plane)
+        float distP[3], distU[3];
+        for (int j = 0; j < 3; j++) {
+            distP[j] = glm::dot(n, P[j] - vertices[i][0]);
+            distU[j] = glm::dot(N, vertices[i][j] - P1);
+
+            // points within the tolerance count as in the plane
+            if (distP[j] * distP[j] <= tolSq[i]) {
+                distP[j] = 0.0f;
+            }
+            if (distU[j] * distU[j] <= tolSqP) {
+                distU[j] = 0.0f;
+            }
+        }
+
+        if ((distP[0] > 0.0f && distP[1] > 0.0f && distP[2] > 0.0f) ||
+            (distP[0] < 0.0f && distP[1] < 0.0f && distP[2] < 0.0f) ||
+            (distU[0] > 0.0f && distU[1] > 0.0f && distU[2] > 0.0f) ||
+            (distU[0] < 0.0f && distU[1] < 0.0f && distU[2] < 0.0f)) {
+            // one triangle strictly on one side of the other plane
+            continue;
+        }
+
+        if (distU[0] == 0.0f && distU[1] == 0.0f && distU[2] == 0.0f) {
+            // in the plane of the triangle
+            coplanar |= 1u << i;
+            continue;
+        }
+
+        // project vertices onto the line shared by both planes
+        glm::vec3 L = glm::cross(N, n);
+        float projP[3], projU[3];
+        for (int j = 0; j < 3; j++) {
+            projP[j] = glm::dot(L, P[j]);
+            projU[j] = glm::dot(L, vertices[i][j]);
+        }
+
+        // segments where each triangle crosses the other plane must overlap
+        float loP, hiP, loU, hiU;
+        crossingInterval(projP, distP, loP, hiP);
+        crossingInterval(projU, distU, loU, hiU);
+        if (hiP >= loU && hiU >= loP) {
+            ret |= 1u << i;
+        }
+    }
+#endif
+
+    // coplanar lanes are tested in 2D one at a time (rare)
+    for (unsigned int i = 0; coplanar; i++, coplanar >>= 1) {
+        if ((coplanar & 1) && coplanarTrianglesIntersect(N, P, vertices[i])) {
+            ret |= 1u << i;
+        }
+    }
+
+    return ret;
+}
+
+// test two triangles that lie in the same plane with normal N (edges cross or one contains the other)
+bool TrianglePacket::coplanarTrianglesIntersect(glm::vec3 N, glm::vec3 P[3], glm::vec3 U[3]) {
+    // drop the axis the normal points along the most (largest projected area)
+    glm::vec3 absN = glm::abs(N);
+    int i0, i1;
+    if (absN.x >= absN.y && absN.x >= absN.z) {
+        i0 = 1; i1 = 2;
+    }
+    else if (absN.y >= absN.z) {
+        i0 = 0; i1 = 2;
+    }
+    else {
+        i0 = 0; i1 = 1;
+    }
+
+    glm::vec2 p[3], u[3];
+    for (int i = 0; i < 3; i++) {
+        p[i] = { P[i][i0], P[i][i1] };
+        u[i] = { U[i][i0], U[i][i1] };
+    }
+
+    // any pair of edges crossing
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (segmentsIntersect2D(p[i], p[(i + 1) % 3], u[j], u[(j + 1) % 3])) {
+                return true;
+            }
+        }
+    }
+
+    // no edges cross, so the triangles are apart or one is inside the other
+    return triangleContainsPoint2D(u, p[0]) || triangleContainsPoint2D(p, u[0]);
+}
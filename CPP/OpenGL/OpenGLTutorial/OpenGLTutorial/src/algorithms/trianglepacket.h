@@ -0,0 +1,74 @@
+#ifndef TRIANGLEPACKET_H
+#define TRIANGLEPACKET_H
+
+#include <glm/glm.hpp>
+
+// use SSE if the target has it (always on x64), define TRIANGLEPACKET_NO_SIMD to force the scalar lanes
+#if !defined(TRIANGLEPACKET_NO_SIMD) && \
+    (defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define TRIANGLEPACKET_SIMD
+#include <xmmintrin.h>
+#endif
+
+#define TRIANGLEPACKET_SIZE 4
+#define TRIANGLEPACKET_EPSILON 1e-6f // points closer to a plane than this (relative to the triangle size) are in it
+
+/*
+    packet of triangles tested together against one other triangle
+    - vertices and planes are stored per component (structure of arrays)
+    - interval overlap test (Moller): each triangle must cross or touch the plane of the other,
+        then the segments where they cross the line shared by both planes must overlap
+    - non-coplanar triangles are tested for all lanes in one go (SSE), coplanar lanes fall back to a 2D test
+    - degenerate triangles (no area) never intersect
+*/
+
+class TrianglePacket {
+public:
+    // number of triangles in the packet (unused lanes repeat the last triangle)
+    unsigned int noTriangles;
+
+#ifdef TRIANGLEPACKET_SIMD
+    // components of the vertices
+    __m128 ax, ay, az;
+    __m128 bx, by, bz;
+    __m128 cx, cy, cz;
+    // normals of the triangles (not normalized)
+    __m128 nx, ny, nz;
+    // square of the distance below which a point is in the plane of each triangle
+    __m128 tolSq;
+#else
+    // components of the vertices
+    float ax[TRIANGLEPACKET_SIZE], ay[TRIANGLEPACKET_SIZE], az[TRIANGLEPACKET_SIZE];
+    float bx[TRIANGLEPACKET_SIZE], by[TRIANGLEPACKET_SIZE], bz[TRIANGLEPACKET_SIZE];
+    float cx[TRIANGLEPACKET_SIZE], cy[TRIANGLEPACKET_SIZE], cz[TRIANGLEPACKET_SIZE];
+    // normals of the triangles (not normalized)
+    float nx[TRIANGLEPACKET_SIZE], ny[TRIANGLEPACKET_SIZE], nz[TRIANGLEPACKET_SIZE];
+    // square of the distance below which a point is in the plane of each triangle
+    float tolSq[TRIANGLEPACKET_SIZE];
+#endif
+
+    // vertices of each triangle (for the coplanar test)
+    glm::vec3 vertices[TRIANGLEPACKET_SIZE][3];
+
+    // mask with a bit for each triangle in the packet
+    unsigned int fullMask;
+
+    /*
+        constructor
+    */
+
+    // initialize with up to TRIANGLEPACKET_SIZE triangles (3 vertices each)
+    TrianglePacket(glm::vec3* vertices, unsigned int noTriangles);
+
+    /*
+        testing methods
+    */
+
+    // test all triangles against a triangle, returns mask of the triangles that intersect it
+    unsigned int intersectsTriangle(glm::vec3 P1, glm::vec3 P2, glm::vec3 P3);
+
+    // test two triangles that lie in the same plane with normal N (edges cross or one contains the other)
+    static bool coplanarTrianglesIntersect(glm::vec3 N, glm::vec3 P[3], glm::vec3 U[3]);
+};
+
+#endif
@@ -182,6 +182,11 @@ void Mesh::setupMaterial(Material mat) {
 
 // render number of instances using shader
 void Mesh::render(Shader shader, unsigned int noInstances) {
+    if (!noInstances) {
+        // nothing in view
+        return;
+    }
+
     shader.setBool("noNormalMap", true);
 
     if (noTex) {
@@ -60,13 +60,13 @@ void Model::addMesh(Mesh* mesh) {
 
 // render instance(s)
 void Model::render(Shader shader, float dt, Scene* scene) {
+    // instances in view (null if the scene did not cull, then draw all)
+    std::vector<RigidBody*>* visible = scene ? scene->getVisibleInstances(id) : nullptr;
+    unsigned int noVisible = visible ? visible->size() : currentNoInstances;
+
     if (!States::isActive(&switches, CONST_INSTANCES)) {
         // dynamic instances - update VBO data
 
-        // create list of each
-        std::vector<glm::mat4> models(currentNoInstances);
-        std::vector<glm::mat3> normalModels(currentNoInstances);
-
         // determine if instances are moving
         bool doUpdate = States::isActive(&switches, DYNAMIC);
 
@@ -82,19 +82,14 @@ void Model::render(Shader shader, float dt, Scene* scene) {
                 // deactivate moved switch
                 States::deactivate(&instances[i]->state, INSTANCE_MOVED);
             }
-
-            // add updated matrices
-            models[i] = instances[i]->model;
-            normalModels[i] = instances[i]->normalModel;
         }
 
-        if (currentNoInstances) {
-            // set transformation data
-            modelVBO.bind();
-            modelVBO.updateData<glm::mat4>(0, currentNoInstances, &models[0]);
-            normalModelVBO.bind();
-            normalModelVBO.updateData<glm::mat3>(0, currentNoInstances, &normalModels[0]);
-        }
+        // set transformation data of instances in view
+        uploadInstances(visible);
+    }
+    else if (noVisible != currentNoInstances || uploadedCulled) {
+        // const instances - buffers only change when the set in view differs from all instances
+        uploadInstances(visible);
     }
 
     // set shininess
@@ -102,7 +97,7 @@ void Model::render(Shader shader, float dt, Scene* scene) {
 
     // render each mesh
     for (unsigned int i = 0, noMeshes = meshes.size(); i < noMeshes; i++) {
-        meshes[i].render(shader, currentNoInstances);
+        meshes[i].render(shader, noVisible);
     }
 }
 
@@ -199,6 +194,31 @@ void Model::initInstances() {
     }
 }
 
+// upload matrices of instances to draw to the front of the buffers (all if list is null)
+void Model::uploadInstances(std::vector<RigidBody*>* visible) {
+    unsigned int noInstances = visible ? visible->size() : currentNoInstances;
+
+    // create list of each
+    std::vector<glm::mat4> models(noInstances);
+    std::vector<glm::mat3> normalModels(noInstances);
+
+    for (unsigned int i = 0; i < noInstances; i++) {
+        RigidBody* rb = visible ? (*visible)[i] : instances[i];
+        models[i] = rb->model;
+        normalModels[i] = rb->normalModel;
+    }
+
+    if (noInstances) {
+        // set transformation data
+        modelVBO.bind();
+        modelVBO.updateData<glm::mat4>(0, noInstances, &models[0]);
+        normalModelVBO.bind();
+        normalModelVBO.updateData<glm::mat3>(0, noInstances, &normalModels[0]);
+    }
+
+    uploadedCulled = noInstances != currentNoInstances;
+}
+
 // remove instance at idx
 void Model::removeInstance(unsigned int idx) {
     if (idx < maxNoInstances) {
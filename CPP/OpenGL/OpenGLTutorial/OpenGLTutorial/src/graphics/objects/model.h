@@ -96,6 +96,9 @@ public:
     // initialize memory for instances
     void initInstances();
 
+    // upload matrices of instances to draw to the front of the buffers (all if list is null)
+    void uploadInstances(std::vector<RigidBody*>* visible);
+
     // remove instance at idx
     void removeInstance(unsigned int idx);
 
@@ -140,6 +143,9 @@ protected:
     // VBOs for model matrices
     BufferObject modelVBO;
     BufferObject normalModelVBO;
+
+    // if the VBOs hold a culled subset of the instances instead of all of them
+    bool uploadedCulled = false;
 };
 
 #endif
\ No newline at end of file
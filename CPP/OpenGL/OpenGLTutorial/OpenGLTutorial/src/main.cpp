@@ -197,6 +197,11 @@ int main() {
     // instantiate instances
     scene.initInstances();
 
+#ifdef STATIC_SNAPSHOT_FILE
+    // load the static tree instead of building it (rewritten if the static instances changed)
+    scene.setStaticSnapshot(STATIC_SNAPSHOT_FILE);
+#endif
+
     // finish preparations (octree, etc)
     scene.prepare(box, { shader });
 
@@ -208,6 +213,11 @@ int main() {
 
     scene.variableLog["time"] = (double)0.0;
 
+#ifdef STATS_FILE
+    // write logged variables and octree counters of each frame (one json object per line)
+    scene.openStatsFile(STATS_FILE);
+#endif
+
     scene.defaultFBO.bind(); // bind default framebuffer
 
     while (!scene.shouldClose()) {
@@ -303,7 +313,7 @@ void emitRay() {
     Ray r(cam.cameraPos, cam.cameraFront);
 
     float tmin = std::numeric_limits<float>::max();
-    BoundingRegion* intersected = scene.octree->checkCollisionsRay(r, tmin);
+    BoundingRegion* intersected = scene.checkCollisionsRay(r, tmin);
     if (intersected) {
         std::cout << "Hits " << intersected->instance->instanceId << " at t = " << tmin << std::endl;
         scene.markForDeletion(intersected->instance->instanceId);
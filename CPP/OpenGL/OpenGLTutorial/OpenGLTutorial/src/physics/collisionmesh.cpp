@@ -1,100 +1,31 @@
 #include "collisionmesh.h"
 #include "collisionmodel.h"
 #include "rigidbody.h"
+#include "gjk.h"
 
 #include "../algorithms/math/linalg.h"
+#include "../algorithms/trianglepacket.h"
 
-bool Face::collidesWithFace(RigidBody* thisRB, Face& face, RigidBody* faceRB, glm::vec3& retNorm) {
-	// transform coordinates so that P1 is the origin
-	glm::vec3 P1 = mat4vec3mult(thisRB->model, this->mesh->points[this->i1]);
-	glm::vec3 P2 = mat4vec3mult(thisRB->model, this->mesh->points[this->i2]) - P1;
-	glm::vec3 P3 = mat4vec3mult(thisRB->model, this->mesh->points[this->i3]) - P1;
-	glm::vec3 lines[3] = {
-		P2,
-		P3,
-		P3 - P2
-	};
-
-	glm::vec3 thisNorm = thisRB->normalModel * this->norm;
-
-	glm::vec3 U1 = mat4vec3mult(faceRB->model, face.mesh->points[face.i1]) - P1;
-	glm::vec3 U2 = mat4vec3mult(faceRB->model, face.mesh->points[face.i2]) - P1;
-	glm::vec3 U3 = mat4vec3mult(faceRB->model, face.mesh->points[face.i3]) - P1;
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-	retNorm = faceRB->normalModel * face.norm;
-
-	// set P1 as the origin
-	P1[0] = 0.0f; P1[1] = 0.0f; P1[2] = 0.0f;
+bool Face::collidesWithFace(RigidBody* thisRB, Face& face, RigidBody* faceRB, glm::vec3& retNorm) {
+	// get world space data (transformed once per movement)
+	WorldMesh& thisWorld = thisRB->getWorldMesh(this->mesh);
+	WorldMesh& faceWorld = faceRB->getWorldMesh(face.mesh);
 
-	// placeholders
-	float c1, c2, c3;
+	retNorm = faceWorld.norms[face.index()];
 
-	/*
-		iterate through each bounding line of the face
-	*/
-	glm::vec3 sideOrigins[3] = {
-		U1,
-		U1,
-		U2
+	// packet with the single face
+	glm::vec3 U[3] = {
+		faceWorld.points[face.i1],
+		faceWorld.points[face.i2],
+		faceWorld.points[face.i3]
 	};
-	glm::vec3 sides[3] = {
-		U2 - U1,
-		U3 - U1,
-		U3 - U2
-	};
-	for (unsigned int i = 0; i < 3; i++) {
-		// get intersection with the plane
-		float t = 0.0f;
-
-		LinePlaneIntCase currentCase = linePlaneIntersection(P1, thisNorm,
-			sideOrigins[i], sides[i],
-			t);
-
-		switch (currentCase) {
-		case LinePlaneIntCase::CASE0:
-			// determine intersection with the lines of this face
-
-			for (int j = 0; j < 3; j++) {
-				glm::mat3 m(lines[j], -1.0f * sides[i], sideOrigins[i]);
-
-				rref(m);
-
-				if (m[2][2] != 0.0f) {
-					// no intersection
-					continue;
-				}
-
-				c1 = m[2][0];
-				c2 = m[2][1];
-
-				if (0.0f <= c1 && c1 <= 1.0f &&
-					0.0f <= c2 && c2 <= 1.0f) {
-					return true;
-				}
-			}
-
-			return false;
-		case LinePlaneIntCase::CASE1:
-			// no intersection, no collision
-			continue;
-		case LinePlaneIntCase::CASE2:
-			// intersection in the plane in range, determine if inside the triangle of this face
-
-			// get point of intersection
-			glm::vec3 intersection = sideOrigins[i] + t * sides[i];
-
-			if (faceContainsPoint(P2, P3, thisNorm, intersection)) {
-				return true;
-			}
-
-			continue;
-		case LinePlaneIntCase::CASE3:
-			// intersection in the plane out of range, no collision
-			continue;
-		};
-	}
+	TrianglePacket packet(U, 1);
 
-	return false;
+	return packet.intersectsTriangle(thisWorld.points[i1], thisWorld.points[i2], thisWorld.points[i3]) != 0;
 }
 
 bool Face::collidesWithSphere(RigidBody* thisRB, BoundingRegion& br, glm::vec3& retNorm) {
@@ -102,12 +33,13 @@ bool Face::collidesWithSphere(RigidBody* thisRB, BoundingRegion& br, glm::vec3&
 		return false;
 	}
 
-	// apply model transformations
-	glm::vec3 P1 = mat4vec3mult(thisRB->model, this->mesh->points[i1]);
-	glm::vec3 P2 = mat4vec3mult(thisRB->model, this->mesh->points[i2]);
-	glm::vec3 P3 = mat4vec3mult(thisRB->model, this->mesh->points[i3]);
+	// get world space data (transformed once per movement)
+	WorldMesh& thisWorld = thisRB->getWorldMesh(this->mesh);
+	glm::vec3 P1 = thisWorld.points[i1];
+	glm::vec3 P2 = thisWorld.points[i2];
+	glm::vec3 P3 = thisWorld.points[i3];
 
-	glm::vec3 norm = thisRB->normalModel * this->norm;
+	glm::vec3 norm = thisWorld.norms[index()];
 	glm::vec3 unitN = norm / glm::length(norm);
 
 	glm::vec3 distanceVec = br.center - P1;
@@ -124,6 +56,11 @@ bool Face::collidesWithSphere(RigidBody* thisRB, BoundingRegion& br, glm::vec3&
 	return false;
 }
 
+unsigned int Face::index() {
+	// faces are stored in the list of the mesh
+	return (unsigned int)(this - mesh->faces.data());
+}
+
 CollisionMesh::CollisionMesh(unsigned int noPoints, float* coordinates,
 	unsigned int noFaces, unsigned int* indices)
 	: points(noPoints), faces(noFaces) {
@@ -179,4 +116,255 @@ CollisionMesh::CollisionMesh(unsigned int noPoints, float* coordinates,
 			N			// normal placeholder
 		};
 	}
+
+	// build face hierarchy
+	faceOrder.resize(noFaces);
+	for (unsigned int i = 0; i < noFaces; i++) {
+		faceOrder[i] = i;
+	}
+	if (noFaces) {
+		nodes.reserve(2 * (noFaces / COLLISIONMESH_MAX_LEAF + 1));
+		nodes.push_back({ glm::vec3(0.0f), glm::vec3(0.0f), 0, 0 });
+		buildNode(0, 0, noFaces);
+	}
+
+	convex = checkConvex();
+}
+
+bool CollisionMesh::collidesWithMesh(RigidBody* thisRB, CollisionMesh* mesh, RigidBody* meshRB,
+	glm::vec3& retNorm, float& retDepth, glm::vec3& retPoint) {
+	if (nodes.empty() || mesh->nodes.empty()) {
+		return false;
+	}
+
+	if (convex && mesh->convex) {
+		// hulls of the world space points
+		WorldMesh& thisWorld = thisRB->getWorldMesh(this);
+		WorldMesh& meshWorld = meshRB->getWorldMesh(mesh);
+		ConvexShape a = { thisWorld.points.data(), (unsigned int)thisWorld.points.size(), glm::vec3(0.0f), 0.0f };
+		ConvexShape b = { meshWorld.points.data(), (unsigned int)meshWorld.points.size(), glm::vec3(0.0f), 0.0f };
+
+		std::vector<SupportPoint> simplex;
+		if (!GJK::intersects(a, b, simplex)) {
+			return false;
+		}
+
+		GJK::penetration(a, b, simplex, retNorm, retDepth, retPoint);
+		return true;
+	}
+
+	// nodes of the other mesh are compared in the model space of this mesh
+	glm::mat4 toThis = thisRB->invModel * meshRB->model;
+
+	retDepth = 0.0f;
+	return collidesWithMeshNode(0, thisRB, mesh, 0, meshRB, toThis, retNorm, retPoint);
+}
+
+bool CollisionMesh::collidesWithSphere(RigidBody* thisRB, BoundingRegion& br,
+	glm::vec3& retNorm, float& retDepth, glm::vec3& retPoint) {
+	if (br.type != BoundTypes::SPHERE || nodes.empty()) {
+		return false;
+	}
+
+	if (convex) {
+		// hull of the world space points against the sphere
+		WorldMesh& thisWorld = thisRB->getWorldMesh(this);
+		ConvexShape a = { thisWorld.points.data(), (unsigned int)thisWorld.points.size(), glm::vec3(0.0f), 0.0f };
+		ConvexShape b = { nullptr, 0, br.center, br.radius };
+
+		std::vector<SupportPoint> simplex;
+		if (!GJK::intersects(a, b, simplex)) {
+			return false;
+		}
+
+		GJK::penetration(a, b, simplex, retNorm, retDepth, retPoint);
+		return true;
+	}
+
+	// box around the sphere in model space
+	glm::mat4& toThis = thisRB->invModel;
+	glm::vec3 min = br.center - glm::vec3(br.radius);
+	glm::vec3 max = br.center + glm::vec3(br.radius);
+	transformBounds(toThis, min, max);
+
+	return collidesWithSphereNode(0, thisRB, br, min, max, retNorm, retDepth, retPoint);
+}
+
+bool CollisionMesh::checkConvex() {
+	if (faces.empty() || points.size() > COLLISIONMESH_MAX_CONVEX_POINTS) {
+		return false;
+	}
+
+	float tolerance = COLLISIONMESH_CONVEX_TOLERANCE * br.radius;
+	for (Face& f : faces) {
+		float len = glm::length(f.baseNormal);
+		if (len <= tolerance * br.radius) {
+			// (almost) no area, normal is not reliable and does not bound anything
+			continue;
+		}
+		glm::vec3 N = f.baseNormal / len;
+		glm::vec3& P1 = points[f.i1];
+
+		// points must not be on both sides of the plane
+		bool front = false, back = false;
+		for (glm::vec3& p : points) {
+			float dist = glm::dot(N, p - P1);
+			if (dist > tolerance) {
+				front = true;
+			}
+			else if (dist < -tolerance) {
+				back = true;
+			}
+
+			if (front && back) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void CollisionMesh::buildNode(unsigned int idx, unsigned int first, unsigned int count) {
+	// bounds of the faces and of their centers (sum of the vertices, 3 times the center)
+	glm::vec3 min(std::numeric_limits<float>::max()), max(std::numeric_limits<float>::lowest());
+	glm::vec3 centerMin = min, centerMax = max;
+	for (unsigned int i = first, end = first + count; i < end; i++) {
+		Face& f = faces[faceOrder[i]];
+		glm::vec3& P1 = points[f.i1];
+		glm::vec3& P2 = points[f.i2];
+		glm::vec3& P3 = points[f.i3];
+		min = glm::min(min, glm::min(P1, glm::min(P2, P3)));
+		max = glm::max(max, glm::max(P1, glm::max(P2, P3)));
+
+		glm::vec3 center = P1 + P2 + P3;
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+
+	nodes[idx].min = min;
+	nodes[idx].max = max;
+	nodes[idx].first = first;
+	nodes[idx].count = count;
+
+	if (count <= COLLISIONMESH_MAX_LEAF) {
+		return;
+	}
+
+	// split along the longest axis of the centers
+	glm::vec3 extent = centerMax - centerMin;
+	int axis = extent.x >= extent.y
+		? (extent.x >= extent.z ? 0 : 2)
+		: (extent.y >= extent.z ? 1 : 2);
+	if (extent[axis] <= 0.0f) {
+		// all centers in one point, cannot split
+		return;
+	}
+
+	// half of the faces on each side
+	unsigned int noLeft = count / 2;
+	std::nth_element(&faceOrder[first], &faceOrder[first] + noLeft, &faceOrder[first] + count, [&](unsigned int a, unsigned int b) -> bool {
+		return points[faces[a].i1][axis] + points[faces[a].i2][axis] + points[faces[a].i3][axis]
+			< points[faces[b].i1][axis] + points[faces[b].i2][axis] + points[faces[b].i3][axis];
+	});
+
+	// create children (list may grow, so only refer to nodes by index)
+	unsigned int left = nodes.size();
+	nodes.push_back({ glm::vec3(0.0f), glm::vec3(0.0f), 0, 0 });
+	nodes.push_back({ glm::vec3(0.0f), glm::vec3(0.0f), 0, 0 });
+	nodes[idx].first = left;
+	nodes[idx].count = 0;
+
+	buildNode(left, first, noLeft);
+	buildNode(left + 1, first + noLeft, count - noLeft);
+}
+
+bool CollisionMesh::collidesWithMeshNode(unsigned int idx, RigidBody* thisRB,
+	CollisionMesh* mesh, unsigned int meshIdx, RigidBody* meshRB,
+	glm::mat4& toThis, glm::vec3& retNorm, glm::vec3& retPoint) {
+	meshBvhNode& n = nodes[idx];
+	meshBvhNode& m = mesh->nodes[meshIdx];
+
+	// bounds of the other node in this model space
+	glm::vec3 min = m.min, max = m.max;
+	transformBounds(toThis, min, max);
+	if (glm::any(glm::greaterThan(min, n.max)) || glm::any(glm::greaterThan(n.min, max))) {
+		return false;
+	}
+
+	if (n.isLeaf() && m.isLeaf()) {
+		// both leaves: test each face of this leaf against packets of faces of the other leaf
+		WorldMesh& thisWorld = thisRB->getWorldMesh(this);
+		WorldMesh& meshWorld = meshRB->getWorldMesh(mesh);
+		for (unsigned int j = m.first, jEnd = m.first + m.count; j < jEnd; j += TRIANGLEPACKET_SIZE) {
+			unsigned int noTriangles = std::min(jEnd - j, (unsigned int)TRIANGLEPACKET_SIZE);
+			glm::vec3 U[3 * TRIANGLEPACKET_SIZE];
+			for (unsigned int k = 0; k < noTriangles; k++) {
+				Face& f = mesh->faces[mesh->faceOrder[j + k]];
+				U[3 * k + 0] = meshWorld.points[f.i1];
+				U[3 * k + 1] = meshWorld.points[f.i2];
+				U[3 * k + 2] = meshWorld.points[f.i3];
+			}
+			TrianglePacket packet(U, noTriangles);
+
+			for (unsigned int i = n.first, iEnd = n.first + n.count; i < iEnd; i++) {
+				Face& f = faces[faceOrder[i]];
+				unsigned int hits = packet.intersectsTriangle(thisWorld.points[f.i1], thisWorld.points[f.i2], thisWorld.points[f.i3]);
+				if (hits) {
+					// normal of the first face hit in the other mesh
+					unsigned int k = 0;
+					while (!(hits & (1u << k))) {
+						k++;
+					}
+					retNorm = meshWorld.norms[mesh->faceOrder[j + k]];
+					// center of the face of this mesh
+					retPoint = (thisWorld.points[f.i1] + thisWorld.points[f.i2] + thisWorld.points[f.i3]) / 3.0f;
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	// go down the larger node, so both sides shrink together
+	glm::vec3 thisDimensions = n.max - n.min;
+	glm::vec3 meshDimensions = max - min;
+	if (!n.isLeaf() && (m.isLeaf() ||
+		thisDimensions.x * thisDimensions.y * thisDimensions.z >= meshDimensions.x * meshDimensions.y * meshDimensions.z)) {
+		return collidesWithMeshNode(n.first, thisRB, mesh, meshIdx, meshRB, toThis, retNorm, retPoint)
+			|| collidesWithMeshNode(n.first + 1, thisRB, mesh, meshIdx, meshRB, toThis, retNorm, retPoint);
+	}
+	else {
+		return collidesWithMeshNode(idx, thisRB, mesh, m.first, meshRB, toThis, retNorm, retPoint)
+			|| collidesWithMeshNode(idx, thisRB, mesh, m.first + 1, meshRB, toThis, retNorm, retPoint);
+	}
+}
+
+bool CollisionMesh::collidesWithSphereNode(unsigned int idx, RigidBody* thisRB, BoundingRegion& br,
+	glm::vec3& min, glm::vec3& max, glm::vec3& retNorm, float& retDepth, glm::vec3& retPoint) {
+	meshBvhNode& n = nodes[idx];
+
+	if (glm::any(glm::greaterThan(min, n.max)) || glm::any(glm::greaterThan(n.min, max))) {
+		return false;
+	}
+
+	if (n.isLeaf()) {
+		// leaf: test the faces
+		for (unsigned int i = n.first, end = n.first + n.count; i < end; i++) {
+			Face& f = faces[faceOrder[i]];
+			if (f.collidesWithSphere(thisRB, br, retNorm)) {
+				// closest point in the plane of the face (retNorm is the unit normal)
+				float distance = glm::dot(br.center - thisRB->getWorldMesh(this).points[f.i1], retNorm);
+				retPoint = br.center - distance * retNorm;
+				retDepth = br.radius - std::fabs(distance);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	return collidesWithSphereNode(n.first, thisRB, br, min, max, retNorm, retDepth, retPoint)
+		|| collidesWithSphereNode(n.first + 1, thisRB, br, min, max, retNorm, retDepth, retPoint);
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #ifndef COLLISIONMESH_H
 #define COLLISIONMESH_H
 
+#define COLLISIONMESH_MAX_LEAF 4 // most faces in a leaf of the face hierarchy
+#define COLLISIONMESH_MAX_DEPTH 64 // size of the traversal stacks (median splits halve the faces, so the hierarchy is at most 32 levels deep)
+#define COLLISIONMESH_MAX_CONVEX_POINTS 512 // meshes with more points are not checked for convexity (treated as concave, face hierarchy is faster)
+#define COLLISIONMESH_CONVEX_TOLERANCE 1e-4f // distance (relative to the radius) a point may be in front of a face of a convex mesh
+
 #include <vector>
 
 #include "../algorithms/bounds.h"
@@ -19,8 +24,38 @@ typedef struct Face {
 
 	bool collidesWithFace(RigidBody* thisRB, struct Face& face, RigidBody* faceRB, glm::vec3& retNorm);
 	bool collidesWithSphere(RigidBody* thisRB, BoundingRegion& br, glm::vec3& retNorm);
+
+	// position in the face list of the mesh (same as in the world space normals)
+	unsigned int index();
 } Face;
 
+/*
+	node of the face hierarchy (model space)
+*/
+
+struct meshBvhNode {
+	// bounds of the faces below the node
+	glm::vec3 min;
+	glm::vec3 max;
+
+	// leaf: index of the first face in the order list, interior: index of the left child (right child follows it)
+	unsigned int first;
+	// number of faces (0 if interior)
+	unsigned int count;
+
+	bool isLeaf() {
+		return count > 0;
+	}
+};
+
+/*
+	collision mesh
+	- faces are split into a bounding volume hierarchy in model space when constructed
+	- other meshes, spheres and rays are brought into model space to traverse it,
+		so only the faces in overlapping leaves are tested
+	- convex meshes (every point behind or on each face) are tested with GJK/EPA on their points instead
+*/
+
 class CollisionMesh {
 public:
 	CollisionModel* model;
@@ -29,7 +64,39 @@ public:
 	std::vector<glm::vec3> points;
 	std::vector<Face> faces;
 
+	// face hierarchy (root is at index 0, empty if there are no faces)
+	std::vector<meshBvhNode> nodes;
+	// indices of the faces in leaf order
+	std::vector<unsigned int> faceOrder;
+
+	// all points on one side of every face (determined when constructed)
+	bool convex;
+
 	CollisionMesh(unsigned int noPoints, float* coordinates, unsigned int noFaces, unsigned int* indices);
+
+	// test against another mesh (GJK if both are convex, otherwise both hierarchies traversed together, stops at the first hit)
+	// - depth is 0 from the face test (only known for convex meshes), point is on the face of this mesh that was hit
+	bool collidesWithMesh(RigidBody* thisRB, CollisionMesh* mesh, RigidBody* meshRB,
+		glm::vec3& retNorm, float& retDepth, glm::vec3& retPoint);
+	// test against a sphere (GJK if convex, otherwise faces, stops at the first hit)
+	bool collidesWithSphere(RigidBody* thisRB, BoundingRegion& br,
+		glm::vec3& retNorm, float& retDepth, glm::vec3& retPoint);
+
+private:
+	// determine if all points are on one side of every face
+	bool checkConvex();
+
+	// split faces [first, first + count) of the order list under node at the median of the longest axis
+	void buildNode(unsigned int idx, unsigned int first, unsigned int count);
+
+	// test subtree of this mesh against subtree of the other mesh (toThis takes the other mesh into this model space)
+	bool collidesWithMeshNode(unsigned int idx, RigidBody* thisRB,
+		CollisionMesh* mesh, unsigned int meshIdx, RigidBody* meshRB,
+		glm::mat4& toThis, glm::vec3& retNorm, glm::vec3& retPoint);
+
+	// test subtree against a sphere with bounds min and max in model space
+	bool collidesWithSphereNode(unsigned int idx, RigidBody* thisRB, BoundingRegion& br,
+		glm::vec3& min, glm::vec3& max, glm::vec3& retNorm, float& retDepth, glm::vec3& retPoint);
 };
 
 #endif
\ No newline at end of file
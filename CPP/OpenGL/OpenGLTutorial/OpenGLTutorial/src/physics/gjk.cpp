@@ -0,0 +1,343 @@
+#include "gjk.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+/*
+    ConvexShape
+*/
+
+// farthest point of the shape in a direction
+glm::vec3 ConvexShape::support(glm::vec3 dir) {
+    glm::vec3 ret = center;
+
+    if (noPoints) {
+        // vertex with the largest projection
+        float best = std::numeric_limits<float>::lowest();
+        for (unsigned int i = 0; i < noPoints; i++) {
+            float proj = glm::dot(points[i], dir);
+            if (proj > best) {
+                best = proj;
+                ret = points[i];
+            }
+        }
+    }
+
+    if (radius > 0.0f) {
+        // grow along the direction
+        float len = glm::length(dir);
+        if (len > 0.0f) {
+            ret += dir * (radius / len);
+        }
+    }
+
+    return ret;
+}
+
+/*
+    helpers
+*/
+
+// farthest point of the Minkowski difference A - B in a direction
+static SupportPoint support(ConvexShape& a, ConvexShape& b, glm::vec3 dir) {
+    glm::vec3 pa = a.support(dir);
+    return { pa - b.support(-dir), pa };
+}
+
+// determine if two vectors point into the same half space
+static bool sameDirection(glm::vec3 a, glm::vec3 b) {
+    return glm::dot(a, b) > 0.0f;
+}
+
+/*
+    simplex cases
+    - the newest point is first, the origin can only be in the regions the newest point opened up
+    - each case drops points not needed and sets the next search direction towards the origin
+    - returns true if the simplex contains the origin
+*/
+
+static bool lineCase(std::vector<SupportPoint>& simplex, glm::vec3& dir) {
+    glm::vec3 a = simplex[0].v, b = simplex[1].v;
+    glm::vec3 ab = b - a, ao = -a;
+
+    if (sameDirection(ab, ao)) {
+        // origin beside the segment, search perpendicular to it
+        dir = glm::cross(glm::cross(ab, ao), ab);
+    }
+    else {
+        // origin beyond the newest point
+        simplex = { simplex[0] };
+        dir = ao;
+    }
+
+    return false;
+}
+
+static bool triangleCase(std::vector<SupportPoint>& simplex, glm::vec3& dir) {
+    glm::vec3 a = simplex[0].v, b = simplex[1].v, c = simplex[2].v;
+    glm::vec3 ab = b - a, ac = c - a, ao = -a;
+    glm::vec3 abc = glm::cross(ab, ac);
+
+    if (sameDirection(glm::cross(abc, ac), ao)) {
+        if (sameDirection(ac, ao)) {
+            // origin beside edge ac
+            simplex = { simplex[0], simplex[2] };
+            dir = glm::cross(glm::cross(ac, ao), ac);
+            return false;
+        }
+
+        simplex = { simplex[0], simplex[1] };
+        return lineCase(simplex, dir);
+    }
+
+    if (sameDirection(glm::cross(ab, abc), ao)) {
+        simplex = { simplex[0], simplex[1] };
+        return lineCase(simplex, dir);
+    }
+
+    // origin above or below the triangle, keep the winding so the normal faces the origin
+    if (sameDirection(abc, ao)) {
+        dir = abc;
+    }
+    else {
+        simplex = { simplex[0], simplex[2], simplex[1] };
+        dir = -abc;
+    }
+
+    return false;
+}
+
+static bool tetrahedronCase(std::vector<SupportPoint>& simplex, glm::vec3& dir) {
+    glm::vec3 a = simplex[0].v, b = simplex[1].v, c = simplex[2].v, d = simplex[3].v;
+    glm::vec3 ab = b - a, ac = c - a, ad = d - a, ao = -a;
+
+    // origin outside one of the faces with the newest point
+    if (sameDirection(glm::cross(ab, ac), ao)) {
+        simplex = { simplex[0], simplex[1], simplex[2] };
+        return triangleCase(simplex, dir);
+    }
+    if (sameDirection(glm::cross(ac, ad), ao)) {
+        simplex = { simplex[0], simplex[2], simplex[3] };
+        return triangleCase(simplex, dir);
+    }
+    if (sameDirection(glm::cross(ad, ab), ao)) {
+        simplex = { simplex[0], simplex[3], simplex[1] };
+        return triangleCase(simplex, dir);
+    }
+
+    return true;
+}
+
+// set normal (unit, facing away from the origin) and distance of the polytope face i
+static void faceNormal(std::vector<SupportPoint>& polytope, std::vector<unsigned int>& faces, unsigned int i,
+    glm::vec3& normal, float& distance) {
+    glm::vec3 a = polytope[faces[3 * i]].v;
+    glm::vec3 b = polytope[faces[3 * i + 1]].v;
+    glm::vec3 c = polytope[faces[3 * i + 2]].v;
+
+    normal = glm::cross(b - a, c - a);
+    float len = glm::length(normal);
+    if (len == 0.0f) {
+        // no area, never the closest
+        distance = std::numeric_limits<float>::max();
+        return;
+    }
+    normal /= len;
+    distance = glm::dot(normal, a);
+
+    if (distance < 0.0f) {
+        // wound the other way
+        normal = -normal;
+        distance = -distance;
+        std::swap(faces[3 * i + 1], faces[3 * i + 2]);
+    }
+}
+
+// add edge to the horizon, or remove it if the face on its other side was removed too
+static void addUniqueEdge(std::vector<unsigned int>& edges, unsigned int a, unsigned int b) {
+    for (unsigned int i = 0, len = edges.size(); i < len; i += 2) {
+        if (edges[i] == b && edges[i + 1] == a) {
+            edges.erase(edges.begin() + i, edges.begin() + i + 2);
+            return;
+        }
+    }
+
+    edges.push_back(a);
+    edges.push_back(b);
+}
+
+/*
+    GJK
+*/
+
+// determine if two convex shapes intersect (simplex holds up to 4 points around the origin if they do)
+bool GJK::intersects(ConvexShape& a, ConvexShape& b, std::vector<SupportPoint>& simplex) {
+    simplex = { support(a, b, glm::vec3(1.0f, 0.0f, 0.0f)) };
+    glm::vec3 dir = -simplex[0].v;
+
+    for (int i = 0; i < GJK_MAX_ITERATIONS; i++) {
+        if (dir.x == 0.0f && dir.y == 0.0f && dir.z == 0.0f) {
+            // origin on the simplex, touching
+            return true;
+        }
+
+        SupportPoint s = support(a, b, dir);
+        if (glm::dot(s.v, dir) < 0.0f) {
+            // cannot get past the origin in the direction of it
+            return false;
+        }
+
+        simplex.insert(simplex.begin(), s);
+
+        bool contains = false;
+        switch (simplex.size()) {
+        case 2: contains = lineCase(simplex, dir); break;
+        case 3: contains = triangleCase(simplex, dir); break;
+        case 4: contains = tetrahedronCase(simplex, dir); break;
+        }
+        if (contains) {
+            return true;
+        }
+    }
+
+    // no progress (origin on the boundary within rounding)
+    return false;
+}
+
+// get direction (unit, from A into B) and depth of the penetration and the contact point on A from an intersecting simplex
+void GJK::penetration(ConvexShape& a, ConvexShape& b, std::vector<SupportPoint>& simplex,
+    glm::vec3& normal, float& depth, glm::vec3& point) {
+    std::vector<SupportPoint> polytope = simplex;
+
+    // a touching simplex may be flat, add points along the axes until it has volume
+    glm::vec3 axes[6] = {
+        { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f },
+        { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }
+    };
+    for (int i = 0; i < 6 && polytope.size() < 4; i++) {
+        SupportPoint s = support(a, b, axes[i]);
+        glm::vec3 p0 = polytope[0].v;
+        float size = 0.0f;
+        switch (polytope.size()) {
+        case 1: size = glm::length(s.v - p0); break;
+        case 2: size = glm::length(glm::cross(polytope[1].v - p0, s.v - p0)); break;
+        case 3: size = std::fabs(glm::dot(glm::cross(polytope[1].v - p0, polytope[2].v - p0), s.v - p0)); break;
+        }
+        if (size > EPA_TOLERANCE) {
+            polytope.push_back(s);
+        }
+    }
+    if (polytope.size() < 4) {
+        // difference is flat, the shapes only touch
+        normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        depth = 0.0f;
+        point = polytope[0].a;
+        return;
+    }
+
+    // faces of the tetrahedron
+    std::vector<unsigned int> faces = {
+        0, 1, 2,
+        0, 3, 1,
+        0, 2, 3,
+        1, 3, 2
+    };
+    std::vector<glm::vec3> normals(4);
+    std::vector<float> distances(4);
+    for (unsigned int i = 0; i < 4; i++) {
+        faceNormal(polytope, faces, i, normals[i], distances[i]);
+    }
+
+    unsigned int minFace = 0;
+    std::vector<unsigned int> edges;
+    for (int iteration = 0; iteration < EPA_MAX_ITERATIONS; iteration++) {
+        // face closest to the origin
+        minFace = 0;
+        for (unsigned int i = 1, len = distances.size(); i < len; i++) {
+            if (distances[i] < distances[minFace]) {
+                minFace = i;
+            }
+        }
+
+        // expand towards it, done if the difference does not reach further
+        SupportPoint s = support(a, b, normals[minFace]);
+        if (glm::dot(normals[minFace], s.v) - distances[minFace] <= EPA_TOLERANCE) {
+            break;
+        }
+
+        // remove faces the new point can see, their outline is the horizon
+        edges.clear();
+        for (unsigned int i = 0; i < normals.size(); i++) {
+            if (sameDirection(normals[i], s.v - polytope[faces[3 * i]].v)) {
+                addUniqueEdge(edges, faces[3 * i], faces[3 * i + 1]);
+                addUniqueEdge(edges, faces[3 * i + 1], faces[3 * i + 2]);
+                addUniqueEdge(edges, faces[3 * i + 2], faces[3 * i]);
+
+                // move last face into the slot
+                unsigned int last = normals.size() - 1;
+                faces[3 * i] = faces[3 * last];
+                faces[3 * i + 1] = faces[3 * last + 1];
+                faces[3 * i + 2] = faces[3 * last + 2];
+                faces.resize(3 * last);
+                normals[i] = normals[last];
+                normals.pop_back();
+                distances[i] = distances[last];
+                distances.pop_back();
+                i--;
+            }
+        }
+
+        // connect the horizon to the new point
+        unsigned int newIdx = polytope.size();
+        polytope.push_back(s);
+        for (unsigned int i = 0, len = edges.size(); i < len; i += 2) {
+            faces.push_back(edges[i]);
+            faces.push_back(edges[i + 1]);
+            faces.push_back(newIdx);
+
+            normals.push_back(glm::vec3(0.0f));
+            distances.push_back(0.0f);
+            faceNormal(polytope, faces, normals.size() - 1, normals.back(), distances.back());
+        }
+
+        if (normals.empty()) {
+            // rounding removed every face
+            break;
+        }
+    }
+
+    if (normals.empty()) {
+        normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        depth = 0.0f;
+        point = polytope[0].a;
+        return;
+    }
+
+    // closest face after the last expansion
+    minFace = 0;
+    for (unsigned int i = 1, len = distances.size(); i < len; i++) {
+        if (distances[i] < distances[minFace]) {
+            minFace = i;
+        }
+    }
+    normal = normals[minFace];
+    depth = distances[minFace];
+
+    // contact point: where the origin projects onto the face, mapped back onto A (barycentric coordinates)
+    SupportPoint& p1 = polytope[faces[3 * minFace]];
+    SupportPoint& p2 = polytope[faces[3 * minFace + 1]];
+    SupportPoint& p3 = polytope[faces[3 * minFace + 2]];
+    glm::vec3 v0 = p2.v - p1.v, v1 = p3.v - p1.v, v2 = normal * depth - p1.v;
+    float d00 = glm::dot(v0, v0), d01 = glm::dot(v0, v1), d11 = glm::dot(v1, v1);
+    float d20 = glm::dot(v2, v0), d21 = glm::dot(v2, v1);
+    float denom = d00 * d11 - d01 * d01;
+    if (denom == 0.0f) {
+        point = p1.a;
+        return;
+    }
+    float v = (d11 * d20 - d01 * d21) / denom;
+    float w = (d00 * d21 - d01 * d20) / denom;
+    point = (1.0f - v - w) * p1.a + v * p2.a + w * p3.a;
+}
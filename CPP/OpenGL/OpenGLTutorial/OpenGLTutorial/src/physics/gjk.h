@@ -0,0 +1,61 @@
+#ifndef GJK_H
+#define GJK_H
+
+#define GJK_MAX_ITERATIONS 64 // most support queries before giving up on finding the origin
+#define EPA_MAX_ITERATIONS 64 // most expansions of the polytope
+#define EPA_TOLERANCE 1e-4f // stop expanding when the closest face moves less than this
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/*
+    convex shape described by its support function
+    - hull of a list of points (world space), grown by a radius
+    - no points is a sphere around center
+*/
+
+struct ConvexShape {
+    // points of the hull (null for a sphere)
+    glm::vec3* points;
+    unsigned int noPoints;
+
+    // center of the sphere (unused with points)
+    glm::vec3 center;
+    // radius added around the hull
+    float radius;
+
+    // farthest point of the shape in a direction
+    glm::vec3 support(glm::vec3 dir);
+};
+
+/*
+    point on the Minkowski difference A - B
+    - keeps the point of A it came from to find the contact point
+*/
+
+struct SupportPoint {
+    // point of A - point of B
+    glm::vec3 v;
+    // point of A
+    glm::vec3 a;
+};
+
+/*
+    Gilbert-Johnson-Keerthi distance algorithm and expanding polytope algorithm
+    - two convex shapes intersect if their Minkowski difference contains the origin
+    - GJK grows a simplex of support points towards the origin until it contains it or cannot reach it
+    - EPA expands that simplex to the face of the difference nearest the origin,
+        which gives the direction and depth of the penetration
+*/
+
+namespace GJK {
+    // determine if two convex shapes intersect (simplex holds up to 4 points around the origin if they do)
+    bool intersects(ConvexShape& a, ConvexShape& b, std::vector<SupportPoint>& simplex);
+
+    // get direction (unit, from A into B) and depth of the penetration and the contact point on A from an intersecting simplex
+    void penetration(ConvexShape& a, ConvexShape& b, std::vector<SupportPoint>& simplex,
+        glm::vec3& normal, float& depth, glm::vec3& point);
+}
+
+#endif
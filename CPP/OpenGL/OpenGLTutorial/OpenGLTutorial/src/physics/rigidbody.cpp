@@ -1,4 +1,7 @@
 #include "rigidbody.h"
+#include "collisionmesh.h"
+
+#include "../algorithms/math/linalg.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -44,6 +47,12 @@ void RigidBody::update(float dt) {
     model = glm::scale(model, size); // M = M * S = T * R * S
 
     normalModel = glm::transpose(glm::inverse(glm::mat3(model)));
+    invModel = glm::inverse(model);
+
+    // world space meshes are transformed again on next use
+    for (WorldMesh& wm : worldMeshes) {
+        wm.valid = false;
+    }
 
     lastCollision += dt;
 }
@@ -100,4 +109,34 @@ void RigidBody::handleCollision(RigidBody* inst, glm::vec3 norm) {
     }
 
     lastCollisionID = inst->instanceId;
+}
+
+// get collision mesh in world space (transformed if stale)
+WorldMesh& RigidBody::getWorldMesh(CollisionMesh* mesh) {
+    // instances have few meshes, so search the list
+    WorldMesh* ret = nullptr;
+    for (WorldMesh& wm : worldMeshes) {
+        if (wm.mesh == mesh) {
+            ret = &wm;
+            break;
+        }
+    }
+
+    if (!ret) {
+        worldMeshes.push_back({ mesh, std::vector<glm::vec3>(mesh->points.size()), std::vector<glm::vec3>(mesh->faces.size()), false });
+        ret = &worldMeshes.back();
+    }
+
+    if (!ret->valid) {
+        // apply model transformations to each vertex and normal once
+        for (unsigned int i = 0, len = mesh->points.size(); i < len; i++) {
+            ret->points[i] = mat4vec3mult(model, mesh->points[i]);
+        }
+        for (unsigned int i = 0, len = mesh->faces.size(); i < len; i++) {
+            ret->norms[i] = normalModel * mesh->faces[i].norm;
+        }
+        ret->valid = true;
+    }
+
+    return *ret;
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <glm/glm.hpp>
 
 #include <string>
+#include <vector>
+#include <deque>
 
 // switches for instance states
 #define INSTANCE_DEAD		(unsigned char)0b00000001
@@ -11,6 +13,26 @@
 
 #define COLLISION_THRESHOLD 0.05f
 
+// forward declaration
+class CollisionMesh;
+
+/*
+    world space copy of a collision mesh for one instance
+    - vertices and face normals with the model matrix applied
+    - filled on first use after the matrix changes, so still instances transform once
+*/
+
+struct WorldMesh {
+    // mesh in model space
+    CollisionMesh* mesh;
+    // transformed vertices (same order as the mesh)
+    std::vector<glm::vec3> points;
+    // transformed face normals (same order as the faces, not normalized)
+    std::vector<glm::vec3> norms;
+    // if the transformed data matches the model matrix
+    bool valid;
+};
+
 /*
     Rigid Body class
     - represents physical body and holds all parameters
@@ -40,6 +62,12 @@ public:
     // model matrix
     glm::mat4 model;
     glm::mat3 normalModel;
+    // inverse of the model matrix (world space to model space)
+    glm::mat4 invModel;
+
+    // world space collision meshes (marked stale each update, the frames INSTANCE_MOVED is set)
+    // - deque, so references returned by getWorldMesh stay valid when another mesh is added
+    std::deque<WorldMesh> worldMeshes;
 
     // ids for quick access to instance/model
     std::string modelId;
@@ -90,6 +118,9 @@ public:
         collisions
     */
     void handleCollision(RigidBody* inst, glm::vec3 norm);
+
+    // get collision mesh in world space (transformed if stale, the reference stays valid for the life of the instance)
+    WorldMesh& getWorldMesh(CollisionMesh* mesh);
 };
 
 #endif
\ No newline at end of file
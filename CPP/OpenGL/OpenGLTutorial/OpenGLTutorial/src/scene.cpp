@@ -3,6 +3,33 @@
 #define MAX_POINT_LIGHTS 10
 #define MAX_SPOT_LIGHTS 2
 
+#define OCTREE_LOOSENESS 1.0f // > 1 to use a loose octree (Octree::node only, linear octree cells are tight)
+#define OCTREE_PARALLEL_UPDATE true // update octree subtrees with worker threads (Octree::node only)
+#define OCTREE_WORLD_LIMIT 8192.0f // largest size the octree root grows to for far objects
+#define OCTREE_SPLIT_POLICY true // split/merge leaves by the policy below (Octree::node only, the linear octree keeps the lifespan countdown)
+#define OCTREE_SPLIT_OBJECTS 4 // leaves split when they hold more objects
+#define OCTREE_MERGE_OBJECTS 2 // children merge into their parent when the subtree holds fewer objects
+#define OCTREE_SPLIT_COST 64.0f // leaves split when their objects take more coarse tests per frame
+#define OCTREE_MERGE_DELAY 8 // frames a subtree has to stay small before it is merged
+#define HASHGRID_CELL_SIZE 2.0f // cell size of the hash grid (about the diameter of a typical object)
+
+/*
+    the linear octree is kept as the plain reference tree (tight cells, lifespan countdown, serial update,
+    own object table instead of the bounds table, no range or k-nearest queries),
+    so node options are rejected with it instead of being ignored
+*/
+#if defined(LINEAR_OCTREE)
+#if OCTREE_PARALLEL_UPDATE
+#error "LINEAR_OCTREE has no parallel update, set OCTREE_PARALLEL_UPDATE to false"
+#endif
+#if OCTREE_SPLIT_POLICY
+#error "LINEAR_OCTREE has no split/merge policy, set OCTREE_SPLIT_POLICY to false"
+#endif
+static_assert(OCTREE_LOOSENESS == 1.0f, "LINEAR_OCTREE has no loose mode, set OCTREE_LOOSENESS to 1");
+#elif !defined(BVH_BROADPHASE) && !defined(HASHGRID_BROADPHASE) && !defined(SAP_BROADPHASE) && !OCTREE_SPLIT_POLICY
+#error "Octree::node always splits and merges by the policy, set OCTREE_SPLIT_POLICY to true"
+#endif
+
 unsigned int Scene::scrWidth = 0;
 unsigned int Scene::scrHeight = 0;
 
@@ -24,17 +51,18 @@ void Scene::framebufferSizeCallback(GLFWwindow* window, int width, int height) {
 
 // default
 Scene::Scene() 
-    : currentId("aaaaaaaa"), lightUBO(0) {}
+    : threadPool(nullptr), nodePool(nullptr), lightUBO(0), currentId("aaaaaaaa"), instancesCulled(false), maxSpeed(0.0f), maxAcceleration(0.0f) {}
 
 // set with values
 Scene::Scene(int glfwVersionMajor, int glfwVersionMinor,
     const char* title, unsigned int scrWidth, unsigned int scrHeight)
-    : glfwVersionMajor(glfwVersionMajor), glfwVersionMinor(glfwVersionMinor), // GLFW version
-    title(title), // window title
+    : threadPool(nullptr), nodePool(nullptr), lightUBO(0), currentId("aaaaaaaa"),
     // default indices/vals
-    activeCamera(-1), 
     activePointLights(0), activeSpotLights(0),
-    currentId("aaaaaaaa"), lightUBO(0) {
+    activeCamera(-1),
+    instancesCulled(false), maxSpeed(0.0f), maxAcceleration(0.0f),
+    title(title), // window title
+    glfwVersionMajor(glfwVersionMajor), glfwVersionMinor(glfwVersionMinor) { // GLFW version
     
     // window dimensions
     Scene::scrWidth = scrWidth;
@@ -124,7 +152,26 @@ bool Scene::init() {
     /*
         init octree
     */
-    octree = new Octree::node(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    octree = new OctreeRoot(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    staticTree = new BVH(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    staticChanged = false;
+
+    /*
+        init worker threads
+    */
+    threadPool = new ThreadPool();
+#if defined(HASHGRID_BROADPHASE)
+    octree->cellSize = HASHGRID_CELL_SIZE;
+#elif !defined(LINEAR_OCTREE) && !defined(BVH_BROADPHASE) && !defined(SAP_BROADPHASE)
+    // octree nodes take memory from the pool
+    nodePool = new NodePool();
+    octree->pool = nodePool;
+    octree->threadPool = threadPool;
+    octree->looseness = OCTREE_LOOSENESS;
+    octree->parallelUpdate = OCTREE_PARALLEL_UPDATE;
+    octree->worldLimit = OCTREE_WORLD_LIMIT;
+    octree->policy = { OCTREE_SPLIT_OBJECTS, OCTREE_MERGE_OBJECTS, OCTREE_SPLIT_COST, OCTREE_MERGE_DELAY };
+#endif
 
     /*
         initialize freetype library
@@ -149,6 +196,17 @@ bool Scene::registerFont(TextRenderer* tr, std::string name, std::string path) {
     }
 }
 
+// start writing the logged variables of each frame to a file
+bool Scene::openStatsFile(std::string path) {
+    statsFile.open(path, std::ios::out | std::ios::trunc);
+    return statsFile.is_open();
+}
+
+// take the static tree from a snapshot file in prepare (built and written there if missing or stale)
+void Scene::setStaticSnapshot(std::string path) {
+    staticSnapshotPath = path;
+}
+
 // to be called after instances have been generated/registered
 void Scene::prepare(Box& box, std::vector<Shader> shaders) {
     // close FT library
@@ -156,6 +214,19 @@ void Scene::prepare(Box& box, std::vector<Shader> shaders) {
     // process current instances
     octree->update(box);
 
+    // static tree from the snapshot if it was taken of the same instances
+    bool snapshotLoaded = false;
+    unsigned long long staticHash = 0;
+    if (!staticSnapshotPath.empty()) {
+        staticHash = staticTree->hashPending();
+        snapshotLoaded = staticTree->loadSnapshot(staticSnapshotPath, staticHash);
+    }
+    staticTree->update(box);
+    if (!staticSnapshotPath.empty() && !snapshotLoaded) {
+        staticTree->saveSnapshot(staticSnapshotPath, staticHash);
+    }
+    staticChanged = false;
+
     // setup lighting UBO
     lightUBO = UBO::UBO(0, {
         UBO::newStruct({ // dir light
@@ -320,6 +391,9 @@ void Scene::processInput(float dt) {
 
         // set pos
         cameraPos = cameras[activeCamera]->cameraPos;
+
+        // determine visible instances for this frame
+        cullInstances(dt);
     }
 }
 
@@ -336,9 +410,70 @@ void Scene::newFrame(Box &box) {
     box.positions.clear();
     box.sizes.clear();
 
+    TreeStats* stats = octree->stats;
+
+    // rebuild static tree if its instances changed (not drawn, only the octree is updated each frame)
+    if (staticChanged) {
+        Box staticBoxes;
+        staticTree->update(staticBoxes);
+        staticTree->collectStats();
+        staticChanged = false;
+    }
+
     // process pending objects
+    StatTime start = TreeStats::now();
     octree->processPending();
+    stats->pendingTime = TreeStats::msSince(start);
+
+    start = TreeStats::now();
     octree->update(box);
+    stats->updateTime = TreeStats::msSince(start);
+
+    // collision detection (broad phase, then fine grain check on the candidate pairs)
+    start = TreeStats::now();
+    broadphasePairs.clear();
+    octree->collectPairs(broadphasePairs);
+    movedRegions.clear();
+    octree->collectMoved(movedRegions);
+    staticTree->collectPairs(movedRegions, broadphasePairs);
+    stats->broadphaseTime = TreeStats::msSince(start);
+
+    start = TreeStats::now();
+    Broadphase::processPairs(broadphasePairs, contacts, threadPool);
+    stats->narrowphaseTime = TreeStats::msSince(start);
+
+    // respond to the contacts in a fixed order
+    start = TreeStats::now();
+    Broadphase::sortContacts(contacts);
+    Broadphase::resolveContacts(contacts);
+    stats->resolveTime = TreeStats::msSince(start);
+
+    // bound the motion of the next frame for culling (after the contacts changed the velocities)
+    maxSpeed = 0.0f;
+    maxAcceleration = 0.0f;
+    for (BoundingRegion* br : movedRegions) {
+        maxSpeed = std::max(maxSpeed, glm::length(br->instance->velocity));
+        maxAcceleration = std::max(maxAcceleration, glm::length(br->instance->acceleration));
+    }
+
+    // publish counters
+    octree->collectStats();
+    variableLog["octree"] = stats->toJson();
+    variableLog["staticTree"] = staticTree->stats->toJson();
+    variableLog["broadphasePairs"] = (int)broadphasePairs.size();
+    variableLog["contacts"] = (int)contacts.size();
+    if (statsFile.is_open()) {
+        statsFile << variableLog.dump() << '\n';
+    }
+
+    // reset counters for the next frame
+    stats->reset();
+    staticTree->stats->reset();
+
+    // pairs and contacts point to regions in the trees, do not keep them past the frame (lists keep their memory)
+    broadphasePairs.clear();
+    movedRegions.clear();
+    contacts.clear();
 
     // send new frame to window
     glfwSwapBuffers(window);
@@ -423,6 +558,44 @@ void Scene::renderSpotLightShader(Shader shader, unsigned int idx) {
     shader.setFloat("farPlane", spotLights[idx]->farPlane);
 }
 
+// collect instances in the view frustum of the active camera (regions are padded by the motion of the coming frame)
+void Scene::cullInstances(float dt) {
+    /*
+        the regions in the trees are from the last update, but models move their instances by dt
+        before drawing them (Model::render), so an instance entering the view would pop in a frame late
+        - pad the frustum by the furthest any moved instance travels in one step of dt
+            (RigidBody::update moves by velocity * dt + acceleration * dt^2 / 2)
+        - instances that did not move in the last update do not move while drawing either
+    */
+    frustum = Frustum(view, projection);
+    frustum.expand(maxSpeed * dt + 0.5f * maxAcceleration * dt * dt);
+
+    // keep lists to reuse memory
+    for (auto& pair : visibleInstances) {
+        pair.second.clear();
+    }
+    octree->frustumCull(frustum, visibleInstances);
+    staticTree->frustumCull(frustum, visibleInstances);
+
+    instancesCulled = true;
+}
+
+// check collisions with a ray against static and moving instances (nearest hit, null if none)
+BoundingRegion* Scene::checkCollisionsRay(Ray r, float& tmin) {
+    // a hit in the static tree shortens the ray for the octree
+    BoundingRegion* staticHit = staticTree->checkCollisionsRay(r, tmin);
+    BoundingRegion* hit = octree->checkCollisionsRay(r, tmin);
+    return hit ? hit : staticHit;
+}
+
+// get list of instances in view for model (null if not culled)
+std::vector<RigidBody*>* Scene::getVisibleInstances(std::string modelId) {
+    if (!instancesCulled) {
+        return nullptr;
+    }
+    return &visibleInstances[modelId];
+}
+
 // render specified model's instances
 void Scene::renderInstances(std::string modelId, Shader shader, float dt) {
     void* val = avl_get(models, (void*)modelId.c_str());
@@ -467,6 +640,18 @@ void Scene::cleanup() {
 
     // destroy octree
     octree->destroy();
+    staticTree->destroy();
+
+    // finish stats file
+    if (statsFile.is_open()) {
+        statsFile.close();
+    }
+
+    // join worker threads
+    delete threadPool;
+
+    // free memory of octree nodes
+    delete nodePool;
 
     // terminate glfw
     glfwTerminate();
@@ -527,8 +712,14 @@ RigidBody* Scene::generateInstance(std::string modelId, glm::vec3 size, float ma
             rb->instanceId = id;
             // insert into trie
             instances.insert(rb->instanceId, rb);
-            // insert into pending queue
-            octree->addToPending(rb, model);
+            // insert into pending queue (instances that never move go into the static tree)
+            if (States::isActive(&model->switches, CONST_INSTANCES)) {
+                staticTree->addToPending(rb, model);
+                staticChanged = true;
+            }
+            else {
+                octree->addToPending(rb, model);
+            }
             return rb;
         }
     }
@@ -573,6 +764,11 @@ void Scene::markForDeletion(std::string instanceId) {
 
     // activate kill switch
     States::activate(&instance->state, INSTANCE_DEAD);
+    // static tree is rebuilt without it
+    Model* model = (Model*)avl_get(models, (void*)instance->modelId.c_str());
+    if (States::isActive(&model->switches, CONST_INSTANCES)) {
+        staticChanged = true;
+    }
     // push to list
     instancesToDelete.push_back(instance);
 }
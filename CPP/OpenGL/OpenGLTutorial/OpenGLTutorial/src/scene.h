@@ -6,6 +6,7 @@
 
 #include <vector>
 #include <map>
+#include <fstream>
 
 #include <glm/glm.hpp>
 
@@ -32,12 +33,39 @@
 #include "algorithms/states.hpp"
 #include "algorithms/avl.h"
 #include "algorithms/octree.h"
+#include "algorithms/frustum.h"
+#include "algorithms/linearoctree.h"
+#include "algorithms/bvh.h"
+#include "algorithms/hashgrid.h"
+#include "algorithms/sweepandprune.h"
 #include "algorithms/trie.hpp"
+#include "algorithms/threadpool.h"
+#include "algorithms/nodepool.h"
+#include "algorithms/broadphase.h"
+#include "algorithms/treestats.h"
 
 // forward declarations
 namespace Octree {
     class node;
+    class LinearTree;
 }
+class BVH;
+class HashGrid;
+class SweepAndPrune;
+
+// spatial structure (define LINEAR_OCTREE to use the contiguous, Morton-coded tree, BVH_BROADPHASE to use the bounding volume hierarchy,
+// HASHGRID_BROADPHASE to use the spatial hash grid, SAP_BROADPHASE to use sweep and prune)
+#if defined(LINEAR_OCTREE)
+typedef Octree::LinearTree OctreeRoot;
+#elif defined(BVH_BROADPHASE)
+typedef BVH OctreeRoot;
+#elif defined(HASHGRID_BROADPHASE)
+typedef HashGrid OctreeRoot;
+#elif defined(SAP_BROADPHASE)
+typedef SweepAndPrune OctreeRoot;
+#else
+typedef Octree::node OctreeRoot;
+#endif
 
 class Model;
 
@@ -55,12 +83,38 @@ public:
     // list of instances that should be deleted
     std::vector<RigidBody*> instancesToDelete;
 
-    // pointer to root node in octree
-    Octree::node* octree;
+    // pointer to root of octree (instances that can move)
+    OctreeRoot* octree;
+
+    // tree of the instances of CONST_INSTANCES models (only rebuilt when they are added or removed)
+    BVH* staticTree;
+    // if static instances were added or removed since the static tree was built
+    bool staticChanged;
+
+    // regions of moved instances in the octree (queried against the static tree each frame, cleared at the end of newFrame)
+    std::vector<BoundingRegion*> movedRegions;
+
+    // snapshot file of the static tree (empty if not used)
+    std::string staticSnapshotPath;
+
+    // worker threads for spatial structures
+    ThreadPool* threadPool;
+
+    // memory for octree nodes
+    NodePool* nodePool;
+
+    // pairs that passed the coarse check this frame (cleared at the end of newFrame)
+    std::vector<BroadphasePair> broadphasePairs;
+
+    // contacts found by the fine grain check this frame (resolved after the narrow phase, cleared at the end of newFrame)
+    std::vector<Contact> contacts;
 
     // map for logged variables
     jsoncpp::json variableLog;
 
+    // file the logged variables are written to each frame (one json object per line, not open by default)
+    std::ofstream statsFile;
+
     // freetype library
     FT_Library ft;
     avl* fonts;
@@ -97,6 +151,12 @@ public:
     // register a font family
     bool registerFont(TextRenderer* tr, std::string name, std::string path);
 
+    // start writing the logged variables of each frame to a file
+    bool openStatsFile(std::string path);
+
+    // take the static tree from a snapshot file in prepare (built and written there if missing or stale)
+    void setStaticSnapshot(std::string path);
+
     // to be called after instances have been generated/registered
     void prepare(Box &box, std::vector<Shader> shaders);
 
@@ -125,6 +185,15 @@ public:
     // set uniform shader variables for spot light render
     void renderSpotLightShader(Shader shader, unsigned int idx);
 
+    // collect instances in the view frustum of the active camera (regions are padded by the motion of the coming frame)
+    void cullInstances(float dt);
+
+    // check collisions with a ray against static and moving instances (nearest hit, null if none)
+    BoundingRegion* checkCollisionsRay(Ray r, float& tmin);
+
+    // get list of instances in view for model (null if not culled)
+    std::vector<RigidBody*>* getVisibleInstances(std::string modelId);
+
     // render specified model's instances
     void renderInstances(std::string modelId, Shader shader, float dt);
 
@@ -229,6 +298,16 @@ public:
     glm::mat4 textProjection;
     glm::vec3 cameraPos;
 
+    // view frustum of the active camera
+    Frustum frustum;
+    // instances in view for each model (filled each frame by cullInstances)
+    VisibleInstances visibleInstances;
+    // if the visible lists are valid
+    bool instancesCulled;
+    // fastest speed and acceleration of the instances that moved in the last update (bound their motion until the next update)
+    float maxSpeed;
+    float maxAcceleration;
+
 protected:
     // window object
     GLFWwindow* window;
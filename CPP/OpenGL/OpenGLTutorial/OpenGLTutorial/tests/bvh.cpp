@@ -0,0 +1,194 @@
+/*
+    benchmark of the bvh against the octree (not part of the project build, see harness.h to build it)
+    - static walls and lamps of uneven sizes between small dynamic objects, and the uniform scene
+    - build time, refit/update time with a tenth and with all of the dynamic objects moving,
+        single ray throughput and pair collection throughput of each structure
+    - pairs (with at least one dynamic object) and nearest ray hits compared with brute force
+    - returns 1 if any result differs
+*/
+
+#include "harness.h"
+
+#include "algorithms/bvh.h"
+
+#define NO_OBJECTS 8000
+#define NO_FRAMES 10
+#define NO_RAYS 4000
+
+// results of one structure
+struct Throughput {
+    double buildMs = 0.0;
+    // update with a tenth / all dynamic objects moving (average per frame)
+    double fewMovedMs = 0.0;
+    double allMovedMs = 0.0;
+    double raysPerMs = 0.0;
+    // pair collection with all dynamic objects moving (average per frame)
+    double pairsMs = 0.0;
+    unsigned int noPairs = 0;
+};
+
+// make walls (i % 10 == 0) and lamps (i % 10 == 5) out of bodies, they do not move
+static void addStatic(HarnessScene& scene) {
+    for (unsigned int i = 0, len = scene.bodies.size(); i < len; i++) {
+        RigidBody* rb = scene.bodies[i];
+        if (i % 10 == 0) {
+            rb->size = (i % 20 == 0) ? glm::vec3(20.0f, 4.0f, 0.3f) : glm::vec3(0.3f, 4.0f, 20.0f);
+        }
+        else if (i % 10 == 5) {
+            rb->size = glm::vec3(0.3f, 6.0f, 0.3f);
+        }
+    }
+    transformRegions(scene.regions);
+}
+
+// determine if body is a wall or a lamp
+static bool isStatic(unsigned int i, bool withStatic) {
+    return withStatic && i % 5 == 0;
+}
+
+// move every step-th of the dynamic bodies by up to 0.5 on each axis (others are marked as not moved)
+static void moveDynamic(HarnessScene& scene, std::mt19937& rng, bool withStatic, unsigned int step, unsigned int offset) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (unsigned int i = 0, len = scene.bodies.size(); i < len; i++) {
+        RigidBody* rb = scene.bodies[i];
+        if (!isStatic(i, withStatic) && i % step == offset % step) {
+            rb->pos += glm::vec3(unit(rng), unit(rng), unit(rng)) * 0.5f;
+            States::activate(&rb->state, INSTANCE_MOVED);
+        }
+        else {
+            States::deactivate(&rb->state, INSTANCE_MOVED);
+        }
+    }
+}
+
+// get pairs with at least one dynamic body by brute force (pairs of static bodies are not collected by the trees)
+static std::set<InstancePair> dynamicPairs(HarnessScene& scene, bool withStatic) {
+    std::set<RigidBody*> staticBodies;
+    for (unsigned int i = 0, len = scene.bodies.size(); i < len; i++) {
+        if (isStatic(i, withStatic)) {
+            staticBodies.insert(scene.bodies[i]);
+        }
+    }
+
+    std::set<InstancePair> ret;
+    for (const InstancePair& pair : bruteForcePairs(scene.regions)) {
+        if (!staticBodies.count(pair.first) || !staticBodies.count(pair.second)) {
+            ret.insert(pair);
+        }
+    }
+    return ret;
+}
+
+// run frames, rays and pairs on a structure with the regions queued (pairs and rays compared with brute force)
+template <typename T>
+Throughput runStructure(const char* name, T& tree, HarnessScene& scene, bool withStatic, std::vector<Ray>& rays) {
+    Throughput ret;
+    ret.buildMs = timeMs([&tree]() { tree.processPending(); });
+
+    std::mt19937 rng(5);
+    Box box;
+    for (int frame = 0; frame < NO_FRAMES; frame++) {
+        moveDynamic(scene, rng, withStatic, 10, frame);
+        ret.fewMovedMs += timeMs([&tree, &box]() { box.positions.clear(); box.sizes.clear(); tree.update(box); });
+    }
+    ret.fewMovedMs /= NO_FRAMES;
+
+    std::vector<BroadphasePair> pairs;
+    pairs.reserve(1 << 16);
+    for (int frame = 0; frame < NO_FRAMES; frame++) {
+        moveDynamic(scene, rng, withStatic, 1, 0);
+        ret.allMovedMs += timeMs([&tree, &box]() { box.positions.clear(); box.sizes.clear(); tree.update(box); });
+        pairs.clear();
+        ret.pairsMs += timeMs([&tree, &pairs]() { tree.collectPairs(pairs); });
+    }
+    ret.allMovedMs /= NO_FRAMES;
+    ret.pairsMs /= NO_FRAMES;
+    ret.noPairs = pairs.size();
+
+    // pairs of the last frame
+    transformRegions(scene.regions);
+    unsigned int duplicates = 0;
+    char checkName[128];
+    snprintf(checkName, 128, "%s: pairs match brute force", name);
+    check(pairSet(pairs, &duplicates) == dynamicPairs(scene, withStatic) && !duplicates, checkName);
+
+    // rays
+    std::vector<float> tmin(rays.size());
+    double rayMs = timeMs([&]() {
+        for (unsigned int i = 0, len = rays.size(); i < len; i++) {
+            tmin[i] = std::numeric_limits<float>::max();
+            tree.checkCollisionsRay(rays[i], tmin[i]);
+        }
+    });
+    ret.raysPerMs = rays.size() / rayMs;
+
+    unsigned int mismatches = 0;
+    for (unsigned int i = 0, len = rays.size(); i < len; i++) {
+        float bruteTmin;
+        bruteForceRay(scene.regions, rays[i], bruteTmin);
+        if (tmin[i] != bruteTmin) {
+            mismatches++;
+        }
+    }
+    snprintf(checkName, 128, "%s: nearest ray hits match brute force (%u differ)", name, mismatches);
+    check(mismatches == 0, checkName);
+
+    return ret;
+}
+
+// compare the structures on a scene
+static void runScene(const char* name, SceneSettings settings, bool withStatic) {
+    HarnessScene scene;
+    makeScene(scene, settings);
+    if (withStatic) {
+        addStatic(scene);
+    }
+    std::vector<Ray> rays = randomRays(NO_RAYS, settings.spread, 7);
+    printf("%s (%u objects)\n", name, settings.noObjects);
+
+    // octree with the settings of the scene
+    NodePool pool;
+    Octree::node* root = new Octree::node(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    root->pool = &pool;
+    root->worldLimit = 8192.0f;
+    queueRegions(root, scene.regions);
+    Throughput octree = runStructure("octree", *root, scene, withStatic, rays);
+    root->stats->reset();
+    root->collectStats();
+    unsigned int octreeNodes = root->stats->noNodes, octreeDepth = root->stats->maxDepth;
+    root->destroy();
+    delete root;
+
+    // bodies back to where they started, so both structures see the same frames
+    HarnessScene again;
+    makeScene(again, settings);
+    if (withStatic) {
+        addStatic(again);
+    }
+    BVH bvh(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    queueRegions(bvh, again.regions);
+    Throughput hierarchy = runStructure("bvh", bvh, again, withStatic, rays);
+    bvh.stats->reset();
+    bvh.collectStats();
+    unsigned int bvhNodes = bvh.stats->noNodes, bvhDepth = bvh.stats->maxDepth;
+    bvh.destroy();
+
+    printf("    %-8s %6s %6s %9s %12s %12s %10s %9s %7s\n", "", "nodes", "depth", "build ms", "update 10%", "update all", "rays/ms", "pairs ms", "pairs");
+    printf("    %-8s %6u %6u %9.2f %12.3f %12.3f %10.1f %9.3f %7u\n", "octree", octreeNodes, octreeDepth,
+        octree.buildMs, octree.fewMovedMs, octree.allMovedMs, octree.raysPerMs, octree.pairsMs, octree.noPairs);
+    printf("    %-8s %6u %6u %9.2f %12.3f %12.3f %10.1f %9.3f %7u\n", "bvh", bvhNodes, bvhDepth,
+        hierarchy.buildMs, hierarchy.fewMovedMs, hierarchy.allMovedMs, hierarchy.raysPerMs, hierarchy.pairsMs, hierarchy.noPairs);
+}
+
+int main() {
+    SceneSettings settings;
+    settings.noObjects = NO_OBJECTS;
+    settings.spread = 60.0f;
+    runScene("walls and lamps between small dynamic objects", settings, true);
+
+    settings.spread = 100.0f;
+    settings.seed = 2;
+    runScene("uniform", settings, false);
+
+    return noFailed ? 1 : 0;
+}
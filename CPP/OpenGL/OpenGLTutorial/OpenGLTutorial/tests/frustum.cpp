@@ -0,0 +1,282 @@
+/*
+    standalone check of frustum culling (not part of the project build, see harness.h to build it)
+    - frustum from a fixed camera at the origin looking down -z (90 degree fov, aspect 1, near 0.1, far 100)
+    - known regions in an octree (tight and loose) and a bvh, the visible instances must match exactly:
+        inside, outside (behind, beside, beyond the far plane), straddling a plane, instances with
+        several regions (listed once), objects waiting in the queue, and a cluster in cells that are
+        completely inside (their objects are taken without tests)
+    - expanded frustum lets regions just outside the planes pass
+    - random scenes against testing every region
+    - returns 1 if any check fails
+*/
+
+#include "harness.h"
+
+#include "algorithms/frustum.h"
+#include "algorithms/bvh.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <map>
+
+#define NO_CLUSTER 64
+#define NO_RANDOM 3000
+
+// instance ids in view, with the number of times each was listed
+typedef std::map<std::string, unsigned int> VisibleIds;
+
+// add body at pos with a region around each offset (boxes of half size 0.5 or spheres of radius 0.5)
+static void addBody(HarnessScene& scene, std::string id, glm::vec3 pos, std::vector<glm::vec3> offsets, bool sphere = false) {
+    RigidBody* rb = new RigidBody("harness", glm::vec3(1.0f), 1.0f, pos);
+    rb->instanceId = id;
+    scene.bodies.push_back(rb);
+
+    for (glm::vec3 offset : offsets) {
+        BoundingRegion br = sphere
+            ? BoundingRegion(offset, 0.5f)
+            : BoundingRegion(offset - glm::vec3(0.5f), offset + glm::vec3(0.5f));
+        br.instance = rb;
+        br.collisionMesh = nullptr;
+        br.cell = nullptr;
+        br.transform();
+        scene.regions.push_back(br);
+    }
+}
+
+// get ids in visible lists
+static VisibleIds visibleIds(VisibleInstances& visible) {
+    VisibleIds ret;
+    for (auto& pair : visible) {
+        for (RigidBody* rb : pair.second) {
+            ret[rb->instanceId]++;
+        }
+    }
+    return ret;
+}
+
+// get ids of instances with a region in the frustum by testing each region
+static VisibleIds bruteForceIds(Frustum& frustum, std::vector<BoundingRegion>& regions) {
+    VisibleIds ret;
+    for (BoundingRegion& br : regions) {
+        if (frustum.intersectsRegion(br)) {
+            ret[br.instance->instanceId] = 1;
+        }
+    }
+    return ret;
+}
+
+// determine if each instance is listed once
+static bool listedOnce(VisibleIds& ids) {
+    for (auto& pair : ids) {
+        if (pair.second != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// compare ids with expected ids, prints differences
+static bool sameIds(VisibleIds& ids, VisibleIds& expected) {
+    bool ret = true;
+    for (auto& pair : expected) {
+        if (!ids.count(pair.first)) {
+            printf("    %s missing\n", pair.first.c_str());
+            ret = false;
+        }
+    }
+    for (auto& pair : ids) {
+        if (!expected.count(pair.first)) {
+            printf("    %s should be culled\n", pair.first.c_str());
+            ret = false;
+        }
+    }
+    return ret;
+}
+
+// count nodes with objects below them that are completely in view (octree)
+static unsigned int countInside(Octree::node* node, Frustum& frustum) {
+    BoundingRegion bounds = node->looseRegion();
+    if (frustum.testRegion(bounds) == FrustumTest::INSIDE) {
+        return node->objects.size() || node->activeOctants ? 1 : 0;
+    }
+    unsigned int ret = 0;
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (node->activeOctants & (1 << i)) {
+            ret += countInside(node->children[i], frustum);
+        }
+    }
+    return ret;
+}
+
+// count nodes with objects below them that are completely in view (bvh)
+static unsigned int countInside(BVH& bvh, unsigned int idx, Frustum& frustum) {
+    bvhNode& n = bvh.nodes[idx];
+    if (frustum.testRegion(n.region) == FrustumTest::INSIDE) {
+        return 1;
+    }
+    return n.isLeaf() ? 0 : countInside(bvh, n.first, frustum) + countInside(bvh, n.first + 1, frustum);
+}
+
+// cull with an octree holding all regions (root is fixed to [-64, 64], regions outside of it stay queued)
+static VisibleIds cullOctree(std::vector<BoundingRegion>& regions, Frustum& frustum, float looseness, unsigned int* noInside = nullptr) {
+    Octree::node* root = new Octree::node(BoundingRegion(glm::vec3(-64.0f), glm::vec3(64.0f)));
+    root->looseness = looseness;
+    queueRegions(root, regions);
+    root->processPending();
+
+    VisibleInstances visible;
+    root->frustumCull(frustum, visible);
+    if (noInside) {
+        *noInside = countInside(root, frustum);
+    }
+
+    root->destroy();
+    delete root;
+    return visibleIds(visible);
+}
+
+// cull with a bvh built from the regions, regions from noBuilt on are only queued
+static VisibleIds cullBVH(std::vector<BoundingRegion>& regions, unsigned int noBuilt, Frustum& frustum, unsigned int* noInside = nullptr) {
+    BVH bvh(BoundingRegion(glm::vec3(-64.0f), glm::vec3(64.0f)));
+    std::vector<BoundingRegion> built(regions.begin(), regions.begin() + noBuilt);
+    queueRegions(bvh, built);
+    bvh.processPending();
+    for (unsigned int i = noBuilt, len = regions.size(); i < len; i++) {
+        bvh.queue.push_back(regions[i]);
+    }
+
+    VisibleInstances visible;
+    bvh.frustumCull(frustum, visible);
+    if (noInside) {
+        *noInside = countInside(bvh, 0, frustum);
+    }
+
+    VisibleIds ret = visibleIds(visible);
+    bvh.destroy();
+    return ret;
+}
+
+int main() {
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+    Frustum frustum(view, projection);
+
+    /*
+        known regions (at depth d, the frustum spans [-d, d] on x and y)
+    */
+
+    HarnessScene scene;
+    VisibleIds expected;
+
+    addBody(scene, "inside", glm::vec3(0.0f, 0.0f, -10.0f), { glm::vec3(0.0f) });
+    expected["inside"] = 1;
+    addBody(scene, "behind", glm::vec3(0.0f, 0.0f, 10.0f), { glm::vec3(0.0f) });
+    addBody(scene, "beside", glm::vec3(50.0f, 0.0f, -10.0f), { glm::vec3(0.0f) });
+    addBody(scene, "beyond far", glm::vec3(0.0f, 0.0f, -103.0f), { glm::vec3(0.0f) });
+
+    // centers on the right and far planes
+    addBody(scene, "straddles right", glm::vec3(10.0f, 0.0f, -10.0f), { glm::vec3(0.0f) }, true);
+    expected["straddles right"] = 1;
+    addBody(scene, "straddles far", glm::vec3(0.0f, 0.0f, -100.0f), { glm::vec3(0.0f) });
+    expected["straddles far"] = 1;
+
+    // several regions
+    addBody(scene, "one region in view", glm::vec3(0.0f, 0.0f, -20.0f), { glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 30.0f) });
+    expected["one region in view"] = 1;
+    addBody(scene, "both regions in view", glm::vec3(0.0f, 0.0f, -30.0f), { glm::vec3(-2.0f, 0.0f, 0.0f), glm::vec3(2.0f, 0.0f, 0.0f) });
+    expected["both regions in view"] = 1;
+
+    // cluster in the cells around (8, 8, -40), the frustum spans [-32, 32] from z = -32 on
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (int i = 0; i < NO_CLUSTER; i++) {
+        std::string id = "cluster " + std::to_string(i);
+        addBody(scene, id, glm::vec3(8.0f, 8.0f, -40.0f) + glm::vec3(unit(rng), unit(rng), unit(rng)) * 6.0f, { glm::vec3(0.0f) }, i % 2);
+        expected[id] = 1;
+    }
+
+    // outside of the octree root (stay queued), queued after the build in the bvh
+    unsigned int noBuilt = scene.regions.size();
+    addBody(scene, "queued in view", glm::vec3(0.0f, 0.0f, -80.0f), { glm::vec3(0.0f) });
+    expected["queued in view"] = 1;
+    addBody(scene, "queued behind", glm::vec3(0.0f, 0.0f, 80.0f), { glm::vec3(0.0f) });
+
+    VisibleIds reference = bruteForceIds(frustum, scene.regions);
+    check(sameIds(reference, expected), "known regions: testing each region gives the expected instances");
+
+    const char* names[3] = { "octree", "loose octree", "bvh" };
+    for (int i = 0; i < 3; i++) {
+        unsigned int noInside = 0;
+        VisibleIds ids = i < 2
+            ? cullOctree(scene.regions, frustum, i == 0 ? 1.0f : 1.5f, &noInside)
+            : cullBVH(scene.regions, noBuilt, frustum, &noInside);
+
+        printf("%s (%u nodes completely in view)\n", names[i], noInside);
+        check(sameIds(ids, expected), "known regions: exact visible instances");
+        check(listedOnce(ids), "known regions: each instance listed once");
+        check(noInside > 0, "known regions: cluster has nodes completely in view");
+
+        // default frustum contains everything, the root is completely in view
+        Frustum all;
+        ids = i < 2
+            ? cullOctree(scene.regions, all, i == 0 ? 1.0f : 1.5f)
+            : cullBVH(scene.regions, noBuilt, all);
+        check(ids.size() == scene.bodies.size() && listedOnce(ids), "everything in view: each instance listed once");
+    }
+
+    /*
+        expanded frustum
+        - sphere of radius 0.5 centered 1 outside of the right plane
+    */
+
+    HarnessScene padded;
+    addBody(padded, "outside by 0.5", glm::vec3(10.0f + sqrtf(2.0f), 0.0f, -10.0f), { glm::vec3(0.0f) }, true);
+
+    Frustum expanded = frustum;
+    expanded.expand(0.25f);
+    check(!expanded.intersectsRegion(padded.regions[0]), "expanded by 0.25: sphere outside by 0.5 is culled");
+    expanded = frustum;
+    expanded.expand(0.75f);
+    check(expanded.intersectsRegion(padded.regions[0]), "expanded by 0.75: sphere outside by 0.5 is in view");
+    check(cullOctree(padded.regions, expanded, 1.0f).size() == 1 && cullBVH(padded.regions, 1, expanded).size() == 1,
+        "expanded by 0.75: trees keep the sphere");
+
+    /*
+        random scenes against testing every region
+    */
+
+    glm::mat4 views[2] = {
+        view,
+        glm::lookAt(glm::vec3(30.0f, 20.0f, 30.0f), glm::vec3(-10.0f, 0.0f, -20.0f), glm::vec3(0.0f, 1.0f, 0.0f))
+    };
+    for (unsigned int seed = 1; seed <= 3; seed++) {
+        HarnessScene random;
+        SceneSettings settings;
+        settings.noObjects = NO_RANDOM;
+        settings.spread = 70.0f;
+        settings.clustered = 0.3f;
+        settings.seed = seed;
+        makeScene(random, settings);
+
+        for (int v = 0; v < 2; v++) {
+            Frustum randomFrustum(views[v], projection);
+            reference = bruteForceIds(randomFrustum, random.regions);
+
+            VisibleIds ids[3] = {
+                cullOctree(random.regions, randomFrustum, 1.0f),
+                cullOctree(random.regions, randomFrustum, 1.5f),
+                cullBVH(random.regions, NO_RANDOM * 9 / 10, randomFrustum)
+            };
+            bool same = true;
+            for (int i = 0; i < 3; i++) {
+                same = sameIds(ids[i], reference) && listedOnce(ids[i]) && same;
+            }
+
+            char name[128];
+            snprintf(name, 128, "random scene %u, view %d: trees match testing each region (%u in view)", seed, v, (unsigned int)reference.size());
+            check(same, name);
+        }
+    }
+
+    return noFailed ? 1 : 0;
+}
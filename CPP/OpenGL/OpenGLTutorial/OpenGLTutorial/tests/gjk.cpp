@@ -0,0 +1,239 @@
+/*
+    benchmark of the GJK/EPA narrow phase against the face hierarchy per mesh complexity (not part of the project build, see harness.h to build it)
+    - uv spheres of 4 to 32 rings (32 to 2048 faces), the largest is over COLLISIONMESH_MAX_CONVEX_POINTS
+        and is forced convex to show where the face hierarchy gets faster
+    - each test runs both paths on the same pair by switching the convex flag of the meshes
+        (world space points are cached before timing, as the rest of the narrow phase of the frame does)
+    - mesh against mesh: bodies of random scale and rotation up to 2.2 apart, both paths must agree apart from
+        grazing pairs, and moving the other mesh along the normal by the depth must separate the pair
+    - mesh against sphere: spheres of radius 0.3 around the mesh, GJK must agree with the exact distance
+        to the solid mesh (the face path only tests the surface, so its misses inside the mesh are counted)
+    - convexity flag: uv spheres up to the point limit are convex, a bumpy sphere is not
+    - returns 1 if any check fails
+*/
+
+#include "harness.h"
+
+#include "physics/collisionmesh.h"
+
+#include <cmath>
+
+#define NO_TESTS 2000
+#define NO_SIZES 4
+
+// pairs within this distance of touching may differ between the paths
+#define GRAZING 1e-4f
+// share of mesh pairs the paths may disagree on (all grazing)
+#define MAX_DISAGREE 0.005f
+
+// uv sphere of radius 1 with noRings rings and segments, every point moved out by up to bump (relative)
+static CollisionMesh* makeSphere(unsigned int noRings, float bump = 0.0f, unsigned int seed = 1) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<float> coordinates;
+    std::vector<unsigned int> indices;
+    for (unsigned int i = 0; i <= noRings; i++) {
+        float theta = glm::pi<float>() * i / noRings;
+        for (unsigned int j = 0; j <= noRings; j++) {
+            float phi = 2.0f * glm::pi<float>() * j / noRings;
+            float r = 1.0f + bump * unit(rng);
+            coordinates.push_back(r * sinf(theta) * cosf(phi));
+            coordinates.push_back(r * cosf(theta));
+            coordinates.push_back(r * sinf(theta) * sinf(phi));
+        }
+    }
+    for (unsigned int i = 0; i < noRings; i++) {
+        for (unsigned int j = 0; j < noRings; j++) {
+            unsigned int a = i * (noRings + 1) + j, b = a + 1, c = a + noRings + 1, d = c + 1;
+            indices.insert(indices.end(), { a, c, d, a, d, b });
+        }
+    }
+
+    return new CollisionMesh(coordinates.size() / 3, coordinates.data(), indices.size() / 3, indices.data());
+}
+
+// closest point to p on triangle abc
+static glm::vec3 closestOnTriangle(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        return a;
+    }
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) {
+        return b;
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        return a + ab * (d1 / (d1 - d3));
+    }
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) {
+        return c;
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        return a + ac * (d2 / (d2 - d6));
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+    float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// distance from p to a closed convex mesh in world space (0 inside), surface is the distance to the nearest face
+static float distanceToSolid(WorldMesh& wm, glm::vec3 p, float& surface) {
+    glm::vec3 center(0.0f);
+    for (glm::vec3& q : wm.points) {
+        center += q;
+    }
+    center /= (float)wm.points.size();
+
+    bool inside = true;
+    surface = std::numeric_limits<float>::max();
+    for (Face& f : wm.mesh->faces) {
+        glm::vec3 a = wm.points[f.i1], b = wm.points[f.i2], c = wm.points[f.i3];
+        glm::vec3 n = glm::cross(b - a, c - a);
+        if (glm::length(n) < 1e-5f) {
+            // pole faces have no area
+            continue;
+        }
+        if (glm::dot(n, center - a) > 0.0f) {
+            n = -n;
+        }
+        if (glm::dot(n, p - a) > 0.0f) {
+            inside = false;
+        }
+        surface = std::min(surface, glm::length(p - closestOnTriangle(p, a, b, c)));
+    }
+    return inside ? 0.0f : surface;
+}
+
+// results of one mesh size
+struct SizeResults {
+    double faceMs = 0.0;
+    double gjkMs = 0.0;
+    unsigned int noHits = 0;
+    unsigned int disagree = 0;
+    // sphere: wrong against the solid mesh (face path) / mesh: not separated along the normal (gjk only)
+    unsigned int faceWrong = 0;
+    unsigned int gjkWrong = 0;
+};
+
+// test meshes a and b (copies of the same size) against each other
+static SizeResults runMeshes(CollisionMesh* a, CollisionMesh* b, std::mt19937& rng) {
+    SizeResults ret;
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    glm::vec3 norm, point;
+    float depth;
+    for (int i = 0; i < NO_TESTS; i++) {
+        RigidBody rbA("a", glm::vec3(1.0f + 0.3f * unit(rng)), 1.0f, glm::vec3(0.0f), glm::vec3(unit(rng), unit(rng), unit(rng)));
+        RigidBody rbB("b", glm::vec3(1.0f + 0.3f * unit(rng)), 1.0f, glm::vec3(unit(rng), unit(rng), unit(rng)) * 2.2f,
+            glm::vec3(unit(rng), unit(rng), unit(rng)));
+        rbA.getWorldMesh(a);
+        rbB.getWorldMesh(b);
+
+        bool faceHit, gjkHit;
+        a->convex = b->convex = false;
+        ret.faceMs += timeMs([&]() { faceHit = a->collidesWithMesh(&rbA, b, &rbB, norm, depth, point); });
+        a->convex = b->convex = true;
+        ret.gjkMs += timeMs([&]() { gjkHit = a->collidesWithMesh(&rbA, b, &rbB, norm, depth, point); });
+
+        ret.noHits += gjkHit;
+        ret.disagree += faceHit != gjkHit;
+        if (gjkHit) {
+            // moved out of the penetration, the pair must be apart
+            rbB.pos += norm * (depth + 1e-3f);
+            rbB.update(0.0f);
+            ret.gjkWrong += a->collidesWithMesh(&rbA, b, &rbB, norm, depth, point);
+        }
+    }
+    return ret;
+}
+
+// test mesh against spheres around it
+static SizeResults runSpheres(CollisionMesh* mesh, std::mt19937& rng) {
+    SizeResults ret;
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    glm::vec3 norm, point;
+    float depth;
+    for (int i = 0; i < NO_TESTS; i++) {
+        RigidBody rb("mesh", glm::vec3(1.0f), 1.0f, glm::vec3(0.0f), glm::vec3(unit(rng), unit(rng), unit(rng)));
+        BoundingRegion br(glm::vec3(unit(rng), unit(rng), unit(rng)) * 1.3f, 0.3f);
+        WorldMesh& wm = rb.getWorldMesh(mesh);
+
+        bool faceHit, gjkHit;
+        mesh->convex = false;
+        ret.faceMs += timeMs([&]() { faceHit = mesh->collidesWithSphere(&rb, br, norm, depth, point); });
+        mesh->convex = true;
+        ret.gjkMs += timeMs([&]() { gjkHit = mesh->collidesWithSphere(&rb, br, norm, depth, point); });
+
+        ret.noHits += gjkHit;
+        ret.disagree += faceHit != gjkHit;
+
+        // exact reference, spheres touching within GRAZING are skipped
+        float surface;
+        float solid = distanceToSolid(wm, br.center, surface);
+        if (fabsf(solid - br.radius) > GRAZING) {
+            ret.gjkWrong += gjkHit != (solid <= br.radius);
+        }
+        if (fabsf(surface - br.radius) > GRAZING) {
+            ret.faceWrong += faceHit != (surface <= br.radius);
+        }
+    }
+    return ret;
+}
+
+int main() {
+    /*
+        convexity flag
+    */
+
+    unsigned int rings[NO_SIZES] = { 4, 8, 16, 32 };
+    CollisionMesh* meshes[NO_SIZES];
+    CollisionMesh* others[NO_SIZES];
+    bool flagsCorrect = true;
+    for (int i = 0; i < NO_SIZES; i++) {
+        meshes[i] = makeSphere(rings[i]);
+        others[i] = makeSphere(rings[i]);
+        flagsCorrect &= meshes[i]->convex == (meshes[i]->points.size() <= COLLISIONMESH_MAX_CONVEX_POINTS);
+    }
+    check(flagsCorrect, "uv spheres up to the point limit are convex, larger ones are not checked");
+    CollisionMesh* bumpy = makeSphere(8, 0.2f);
+    check(!bumpy->convex, "bumpy sphere is not convex");
+    delete bumpy;
+
+    /*
+        each size (flags switched for each test)
+    */
+
+    printf("    %6s %6s %-8s %10s %10s %6s %9s %11s %10s\n", "faces", "points", "against", "face ms", "gjk ms", "hits", "disagree", "face wrong", "gjk wrong");
+    for (int i = 0; i < NO_SIZES; i++) {
+        std::mt19937 rng(7);
+        SizeResults mesh = runMeshes(meshes[i], others[i], rng);
+        SizeResults sphere = runSpheres(meshes[i], rng);
+        unsigned int noFaces = meshes[i]->faces.size(), noPoints = meshes[i]->points.size();
+
+        printf("    %6u %6u %-8s %10.4f %10.4f %6u %9u %11s %10u\n", noFaces, noPoints, "mesh",
+            mesh.faceMs / NO_TESTS, mesh.gjkMs / NO_TESTS, mesh.noHits, mesh.disagree, "-", mesh.gjkWrong);
+        printf("    %6u %6u %-8s %10.4f %10.4f %6u %9u %11u %10u\n", noFaces, noPoints, "sphere",
+            sphere.faceMs / NO_TESTS, sphere.gjkMs / NO_TESTS, sphere.noHits, sphere.disagree, sphere.faceWrong, sphere.gjkWrong);
+
+        char checkName[128];
+        snprintf(checkName, 128, "%u faces, mesh: paths agree apart from grazing pairs", noFaces);
+        check(mesh.noHits > 0 && mesh.disagree <= MAX_DISAGREE * NO_TESTS, checkName);
+        snprintf(checkName, 128, "%u faces, mesh: moving along the normal by the depth separates the pair", noFaces);
+        check(mesh.gjkWrong == 0, checkName);
+        snprintf(checkName, 128, "%u faces, sphere: gjk matches the distance to the solid mesh", noFaces);
+        check(sphere.noHits > 0 && sphere.gjkWrong == 0, checkName);
+
+        delete meshes[i];
+        delete others[i];
+    }
+
+    return noFailed ? 1 : 0;
+}
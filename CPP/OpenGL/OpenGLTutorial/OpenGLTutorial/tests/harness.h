@@ -0,0 +1,235 @@
+#ifndef HARNESS_H
+#define HARNESS_H
+
+/*
+    helpers shared by the standalone checks and benchmarks in this folder (not part of the project build)
+    - random scenes of rigid bodies with one box or sphere region each
+    - queueing the regions into any of the spatial structures
+    - pairs and rays by brute force as the reference
+    - timing
+
+    each harness is one file built together with the sources below, from the project directory
+    (OpenGLTutorial/OpenGLTutorial) with the compiler and include directories of the project
+    (the vendored jsoncpp header used by the tree counters only compiles with msvc):
+    cl /std:c++17 /O2 /EHsc /Isrc /Isrc/physics /I../Linking/include tests/<harness>.cpp ^
+        src/algorithms/bounds.cpp src/algorithms/boundssoa.cpp src/algorithms/broadphase.cpp ^
+        src/algorithms/bvh.cpp src/algorithms/frustum.cpp src/algorithms/hashgrid.cpp ^
+        src/algorithms/linearoctree.cpp src/algorithms/nodepool.cpp src/algorithms/octree.cpp ^
+        src/algorithms/ray.cpp src/algorithms/raypacket.cpp src/algorithms/sweepandprune.cpp ^
+        src/algorithms/threadpool.cpp src/algorithms/treestats.cpp src/algorithms/trianglepacket.cpp ^
+        src/algorithms/math/linalg.cpp src/physics/collisionmesh.cpp src/physics/gjk.cpp src/physics/rigidbody.cpp
+*/
+
+#include <vector>
+#include <set>
+#include <utility>
+#include <random>
+#include <string>
+#include <limits>
+#include <cstdio>
+
+#include "algorithms/bounds.h"
+#include "algorithms/ray.h"
+#include "algorithms/broadphase.h"
+#include "algorithms/octree.h"
+#include "algorithms/linearoctree.h"
+#include "algorithms/treestats.h"
+#include "physics/rigidbody.h"
+
+/*
+    scenes
+*/
+
+// settings for a random scene
+struct SceneSettings {
+    unsigned int noObjects = 4000;
+    // objects are placed in [-spread, spread] on each axis
+    float spread = 100.0f;
+    // scale of each object
+    float minSize = 0.1f;
+    float maxSize = 3.0f;
+    // share of objects placed in a cluster of radius spread / 10 around the origin
+    float clustered = 0.0f;
+    unsigned int seed = 1;
+};
+
+// bodies and their regions (region i belongs to body i, even regions are boxes and odd regions are spheres)
+struct HarnessScene {
+    std::vector<RigidBody*> bodies;
+    std::vector<BoundingRegion> regions;
+
+    ~HarnessScene() {
+        for (RigidBody* rb : bodies) {
+            delete rb;
+        }
+    }
+};
+
+// create random scene
+inline void makeScene(HarnessScene& scene, SceneSettings settings) {
+    std::mt19937 rng(settings.seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> size(settings.minSize, settings.maxSize);
+
+    for (unsigned int i = 0; i < settings.noObjects; i++) {
+        float spread = (float)i < settings.clustered * settings.noObjects
+            ? settings.spread * 0.1f
+            : settings.spread;
+        glm::vec3 pos(unit(rng) * spread, unit(rng) * spread, unit(rng) * spread);
+
+        RigidBody* rb = new RigidBody("harness", glm::vec3(size(rng)), 1.0f, pos);
+        rb->instanceId = std::to_string(i);
+        scene.bodies.push_back(rb);
+
+        BoundingRegion br = (i % 2 == 0)
+            ? BoundingRegion(glm::vec3(-0.5f), glm::vec3(0.5f))
+            : BoundingRegion(glm::vec3(0.0f), 0.5f);
+        br.instance = rb;
+        br.collisionMesh = nullptr;
+        br.cell = nullptr;
+        br.transform();
+        scene.regions.push_back(br);
+    }
+}
+
+// move every step-th body by up to distance on each axis (others are marked as not moved)
+inline void moveBodies(HarnessScene& scene, std::mt19937& rng, float distance, unsigned int step = 1, unsigned int offset = 0) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (unsigned int i = 0, len = scene.bodies.size(); i < len; i++) {
+        RigidBody* rb = scene.bodies[i];
+        if (i % step == offset % step) {
+            rb->pos += glm::vec3(unit(rng), unit(rng), unit(rng)) * distance;
+            States::activate(&rb->state, INSTANCE_MOVED);
+        }
+        else {
+            States::deactivate(&rb->state, INSTANCE_MOVED);
+        }
+    }
+}
+
+/*
+    queueing regions (same as addToPending without a model)
+*/
+
+// any structure with a list of pending regions
+template <typename T>
+void queueRegions(T& tree, std::vector<BoundingRegion>& regions) {
+    for (BoundingRegion& br : regions) {
+        tree.queue.push_back(br);
+    }
+}
+
+// octree, the queue holds indices into the bounds table
+inline void queueRegions(Octree::node* root, std::vector<BoundingRegion>& regions) {
+    for (BoundingRegion& br : regions) {
+        root->queue.push_back(root->table->add(br, root, true));
+    }
+}
+
+// linear octree, the queue is a std::queue
+inline void queueRegions(Octree::LinearTree& tree, std::vector<BoundingRegion>& regions) {
+    for (BoundingRegion& br : regions) {
+        tree.queue.push(br);
+    }
+}
+
+/*
+    reference results
+*/
+
+// pair of instances (lower address first) to compare pair lists independent of order
+typedef std::pair<RigidBody*, RigidBody*> InstancePair;
+
+// get set of instance pairs in list (count of duplicates is added to duplicates)
+inline std::set<InstancePair> pairSet(std::vector<BroadphasePair>& pairs, unsigned int* duplicates = nullptr) {
+    std::set<InstancePair> ret;
+    for (BroadphasePair& pair : pairs) {
+        RigidBody* a = pair.a->instance;
+        RigidBody* b = pair.b->instance;
+        if (!ret.insert(a < b ? InstancePair(a, b) : InstancePair(b, a)).second && duplicates) {
+            (*duplicates)++;
+        }
+    }
+    return ret;
+}
+
+// get pairs by testing every region against every other region
+inline std::set<InstancePair> bruteForcePairs(std::vector<BoundingRegion>& regions) {
+    std::set<InstancePair> ret;
+    for (unsigned int i = 0, len = regions.size(); i < len; i++) {
+        for (unsigned int j = i + 1; j < len; j++) {
+            if (Broadphase::needsCheck(regions[i], regions[j]) && regions[i].intersectsWith(regions[j])) {
+                RigidBody* a = regions[i].instance;
+                RigidBody* b = regions[j].instance;
+                ret.insert(a < b ? InstancePair(a, b) : InstancePair(b, a));
+            }
+        }
+    }
+    return ret;
+}
+
+// refresh regions after bodies moved
+inline void transformRegions(std::vector<BoundingRegion>& regions) {
+    for (BoundingRegion& br : regions) {
+        br.transform();
+    }
+}
+
+// get nearest region hit by ray (nullptr if none)
+inline BoundingRegion* bruteForceRay(std::vector<BoundingRegion>& regions, Ray r, float& tmin) {
+    BoundingRegion* ret = nullptr;
+    tmin = std::numeric_limits<float>::max();
+    for (BoundingRegion& br : regions) {
+        float tnear, tfar;
+        if (r.intersectsBoundingRegion(br, tnear, tfar) && tnear < tmin) {
+            tmin = tnear;
+            ret = &br;
+        }
+    }
+    return ret;
+}
+
+// random rays from outside of the scene through points inside it
+inline std::vector<Ray> randomRays(unsigned int noRays, float spread, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> ret;
+    for (unsigned int i = 0; i < noRays; i++) {
+        glm::vec3 origin(unit(rng) * spread * 3.0f, spread * 4.0f, unit(rng) * spread * 3.0f);
+        glm::vec3 target(unit(rng) * spread, unit(rng) * spread, unit(rng) * spread);
+        ret.push_back(Ray(origin, glm::normalize(target - origin)));
+    }
+    return ret;
+}
+
+/*
+    timing
+*/
+
+// run function count times, returns average milliseconds per run
+template <typename F>
+double timeMs(F f, unsigned int count = 1) {
+    StatTime start = TreeStats::now();
+    for (unsigned int i = 0; i < count; i++) {
+        f();
+    }
+    return TreeStats::msSince(start) / count;
+}
+
+/*
+    checks
+*/
+
+// number of failed checks
+static unsigned int noFailed = 0;
+
+// print result of check
+inline bool check(bool passed, const char* name) {
+    if (!passed) {
+        noFailed++;
+    }
+    printf("%s: %s\n", passed ? "ok  " : "FAIL", name);
+    return passed;
+}
+
+#endif
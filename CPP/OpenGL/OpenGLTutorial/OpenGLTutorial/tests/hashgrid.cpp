@@ -0,0 +1,161 @@
+/*
+    crossover benchmark of the hash grid against the octree (not part of the project build, see harness.h to build it)
+    - identical spheres of radius 0.1 (as launched from the camera) moving in a room of [-16, 16],
+        from 250 to 32000 of them, the grid with cells of the sphere diameter and of the scene setting
+    - time per frame of the update and the pair collection for each structure, and the first count
+        at which the grid is faster than the octree
+    - objects of uneven sizes with the same cells, where the grid stores large objects in many cells
+    - pairs compared with brute force up to 4000 objects
+    - returns 1 if any pair list differs
+*/
+
+#include "harness.h"
+
+#include "algorithms/hashgrid.h"
+
+#define NO_FRAMES 10
+#define MAX_CHECKED 4000
+
+// room the spheres are launched into
+#define ROOM 16.0f
+// scale of a launched sphere (radius 0.1 with the regions of the harness)
+#define SPHERE_SIZE 0.2f
+// cell size of the scene (scene.cpp)
+#define SCENE_CELL_SIZE 2.0f
+
+// add noObjects spheres of one size in the room
+static void makeSpheres(HarnessScene& scene, unsigned int noObjects, float size, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (unsigned int i = 0; i < noObjects; i++) {
+        RigidBody* rb = new RigidBody("harness", glm::vec3(size), 1.0f, glm::vec3(unit(rng), unit(rng), unit(rng)) * ROOM);
+        rb->instanceId = std::to_string(i);
+        scene.bodies.push_back(rb);
+
+        BoundingRegion br(glm::vec3(0.0f), 0.5f);
+        br.instance = rb;
+        br.collisionMesh = nullptr;
+        br.cell = nullptr;
+        br.transform();
+        scene.regions.push_back(br);
+    }
+}
+
+// run frames with every body moving, returns average milliseconds per frame (update and pairs)
+template <typename T>
+double runFrames(const char* name, T& tree, HarnessScene& scene, bool checkPairs) {
+    tree.processPending();
+
+    // same motion for each structure
+    std::mt19937 rng(9);
+    std::vector<BroadphasePair> pairs;
+    Box box;
+    double ret = 0.0;
+    for (int frame = 0; frame < NO_FRAMES; frame++) {
+        moveBodies(scene, rng, 0.05f);
+        ret += timeMs([&]() {
+            box.positions.clear();
+            box.sizes.clear();
+            tree.update(box);
+            pairs.clear();
+            tree.collectPairs(pairs);
+        });
+    }
+
+    if (checkPairs) {
+        transformRegions(scene.regions);
+        unsigned int duplicates = 0;
+        char checkName[128];
+        snprintf(checkName, 128, "%s, %u objects: pairs match brute force", name, (unsigned int)scene.regions.size());
+        check(pairSet(pairs, &duplicates) == bruteForcePairs(scene.regions) && !duplicates, checkName);
+    }
+
+    return ret / NO_FRAMES;
+}
+
+// run the octree with the settings of the scene
+static double runOctree(HarnessScene& scene, bool checkPairs) {
+    NodePool pool;
+    Octree::node* root = new Octree::node(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    root->pool = &pool;
+    root->worldLimit = 8192.0f;
+    queueRegions(root, scene.regions);
+    double ret = runFrames("octree", *root, scene, checkPairs);
+    root->destroy();
+    delete root;
+    return ret;
+}
+
+// run the grid with cells of cellSize
+static double runGrid(HarnessScene& scene, float cellSize, bool checkPairs) {
+    HashGrid grid(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    grid.cellSize = cellSize;
+    queueRegions(grid, scene.regions);
+    char name[64];
+    snprintf(name, 64, "grid (cells of %.1f)", cellSize);
+    double ret = runFrames(name, grid, scene, checkPairs);
+    grid.destroy();
+    return ret;
+}
+
+int main() {
+    /*
+        identical spheres
+        - each structure starts from the same positions
+    */
+
+    printf("identical spheres of radius %.1f in [-%.0f, %.0f], ms per frame (update and pairs)\n", SPHERE_SIZE * 0.5f, ROOM, ROOM);
+    printf("    %7s %10s %14s %14s\n", "objects", "octree", "grid (0.2)", "grid (2.0)");
+    unsigned int crossover = 0, crossoverScene = 0;
+    for (unsigned int noObjects = 250; noObjects <= 32000; noObjects *= 2) {
+        bool checkPairs = noObjects <= MAX_CHECKED;
+        double times[3];
+        for (int i = 0; i < 3; i++) {
+            HarnessScene scene;
+            makeSpheres(scene, noObjects, SPHERE_SIZE, noObjects);
+            times[i] = i == 0
+                ? runOctree(scene, checkPairs)
+                : runGrid(scene, i == 1 ? SPHERE_SIZE : SCENE_CELL_SIZE, checkPairs);
+        }
+        printf("    %7u %10.3f %14.3f %14.3f\n", noObjects, times[0], times[1], times[2]);
+
+        if (!crossover && times[1] < times[0]) {
+            crossover = noObjects;
+        }
+        if (!crossoverScene && times[2] < times[0]) {
+            crossoverScene = noObjects;
+        }
+    }
+    if (crossover) {
+        printf("grid with cells of the diameter is faster from %u objects on\n", crossover);
+    }
+    else {
+        printf("grid with cells of the diameter is not faster up to 32000 objects\n");
+    }
+    if (crossoverScene) {
+        printf("grid with cells of the scene setting is faster from %u objects on\n", crossoverScene);
+    }
+    else {
+        printf("grid with cells of the scene setting is not faster up to 32000 objects\n");
+    }
+
+    /*
+        uneven sizes (0.1 to 3) with the same cells
+    */
+
+    printf("uneven sizes, %u objects, ms per frame\n", MAX_CHECKED);
+    SceneSettings settings;
+    settings.noObjects = MAX_CHECKED;
+    settings.spread = ROOM;
+    double times[3];
+    for (int i = 0; i < 3; i++) {
+        HarnessScene scene;
+        makeScene(scene, settings);
+        times[i] = i == 0
+            ? runOctree(scene, true)
+            : runGrid(scene, i == 1 ? SPHERE_SIZE : SCENE_CELL_SIZE, true);
+    }
+    printf("    octree %.3f, grid (0.2) %.3f, grid (2.0) %.3f\n", times[0], times[1], times[2]);
+
+    return noFailed ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+/*
+    benchmark of the loose octree against the tight octree (not part of the project build, see harness.h to build it)
+    - small spheres and boxes launched around the origin of the scene root (many straddle the split planes
+        of the upper nodes), and a uniform scene with the default settings
+    - the same frames (bodies moved, tree updated, pairs collected) with looseness 1 (tight), 1.25, 1.5 and 2
+    - prints per node counts after the last frame (nodes, depth, objects kept in the root, objects per node)
+        and the coarse tests and time of the pair collection per frame
+    - pairs are compared with brute force on some of the frames
+    - returns 1 if any pair list differs, or if the loose trees keep as many objects in the root or run
+        as many coarse tests as the tight tree in the launched scene
+*/
+
+#include "harness.h"
+
+#define NO_OBJECTS 4000
+#define NO_FRAMES 20
+// frames whose pairs are compared with brute force
+#define CHECK_EVERY 5
+
+#define NO_LOOSENESS 4
+static const float LOOSENESS[NO_LOOSENESS] = { 1.0f, 1.25f, 1.5f, 2.0f };
+
+// counts of one tree after the last frame
+struct TreeCounts {
+    unsigned int noNodes = 0;
+    // nodes holding objects
+    unsigned int noOccupied = 0;
+    unsigned int maxDepth = 0;
+    unsigned int rootObjects = 0;
+    unsigned int maxObjectsPerNode = 0;
+    // sum of the depths of the objects
+    unsigned long depthSum = 0;
+    unsigned int noObjects = 0;
+
+    // per frame
+    double coarseTests = 0.0;
+    double coarsePassed = 0.0;
+    double pairsMs = 0.0;
+    double updateMs = 0.0;
+};
+
+// walk tree for the per node counts
+static void countNodes(Octree::node* node, unsigned int depth, TreeCounts& counts) {
+    unsigned int noObjects = node->objects.size();
+    counts.noNodes++;
+    counts.noOccupied += noObjects ? 1 : 0;
+    counts.maxDepth = std::max(counts.maxDepth, depth);
+    counts.maxObjectsPerNode = std::max(counts.maxObjectsPerNode, noObjects);
+    counts.depthSum += (unsigned long)depth * noObjects;
+    counts.noObjects += noObjects;
+
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (node->activeOctants & (1 << i)) {
+            countNodes(node->children[i], depth + 1, counts);
+        }
+    }
+}
+
+// run frames with a tree of the given looseness, returns counts (pairs checked against brute force)
+static TreeCounts runTree(SceneSettings settings, float distance, float looseness) {
+    HarnessScene scene;
+    makeScene(scene, settings);
+
+    NodePool pool;
+    Octree::node* root = new Octree::node(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    root->pool = &pool;
+    root->worldLimit = 8192.0f;
+    root->looseness = looseness;
+    queueRegions(root, scene.regions);
+    root->processPending();
+
+    TreeCounts ret;
+    std::mt19937 rng(settings.seed + 100);
+    std::vector<BroadphasePair> pairs;
+    unsigned int mismatches = 0;
+    Box box;
+    for (int frame = 0; frame < NO_FRAMES; frame++) {
+        moveBodies(scene, rng, distance);
+        ret.updateMs += timeMs([root, &box]() { root->update(box); });
+
+        root->stats->reset();
+        pairs.clear();
+        ret.pairsMs += timeMs([root, &pairs]() { root->collectPairs(pairs); });
+        ret.coarseTests += root->stats->coarseTests;
+        ret.coarsePassed += root->stats->coarsePassed;
+
+        if (frame % CHECK_EVERY == CHECK_EVERY - 1) {
+            transformRegions(scene.regions);
+            unsigned int duplicates = 0;
+            if (pairSet(pairs, &duplicates) != bruteForcePairs(scene.regions) || duplicates) {
+                mismatches++;
+            }
+        }
+    }
+    ret.coarseTests /= NO_FRAMES;
+    ret.coarsePassed /= NO_FRAMES;
+    ret.pairsMs /= NO_FRAMES;
+    ret.updateMs /= NO_FRAMES;
+
+    countNodes(root, 0, ret);
+    ret.rootObjects = root->objects.size();
+
+    char name[128];
+    snprintf(name, 128, "looseness %.2f: pairs match brute force", looseness);
+    check(mismatches == 0, name);
+
+    root->destroy();
+    delete root;
+    return ret;
+}
+
+// run scene with each looseness and print the counts, returns counts of each tree
+static std::vector<TreeCounts> runScene(const char* name, SceneSettings settings, float distance) {
+    printf("%s (%u objects, moved by up to %.2f per axis each frame)\n", name, settings.noObjects, distance);
+
+    std::vector<TreeCounts> ret;
+    for (int i = 0; i < NO_LOOSENESS; i++) {
+        ret.push_back(runTree(settings, distance, LOOSENESS[i]));
+    }
+
+    printf("    looseness  nodes  occupied  depth  in root  max/node  avg/node  avg depth  coarse tests  passed  pairs ms  update ms\n");
+    for (int i = 0; i < NO_LOOSENESS; i++) {
+        TreeCounts& c = ret[i];
+        printf("    %9.2f  %5u  %8u  %5u  %7u  %8u  %8.2f  %9.2f  %12.0f  %6.0f  %8.3f  %9.3f\n",
+            LOOSENESS[i], c.noNodes, c.noOccupied, c.maxDepth, c.rootObjects, c.maxObjectsPerNode,
+            c.noOccupied ? (double)c.noObjects / c.noOccupied : 0.0,
+            c.noObjects ? (double)c.depthSum / c.noObjects : 0.0,
+            c.coarseTests, c.coarsePassed, c.pairsMs, c.updateMs);
+    }
+
+    return ret;
+}
+
+int main() {
+    // small objects around the origin of the root, as launched from the camera
+    SceneSettings launched;
+    launched.noObjects = NO_OBJECTS;
+    launched.spread = 16.0f;
+    launched.minSize = 0.1f;
+    launched.maxSize = 0.5f;
+    launched.seed = 4;
+    std::vector<TreeCounts> launchedCounts = runScene("launched spheres around the origin", launched, 0.2f);
+
+    SceneSettings uniform;
+    uniform.noObjects = NO_OBJECTS;
+    runScene("uniform", uniform, 0.5f);
+
+    // objects straddling the split planes of the tight tree go down in the loose trees
+    bool fewerInRoot = true, fewerTests = true;
+    for (int i = 1; i < NO_LOOSENESS; i++) {
+        fewerInRoot = fewerInRoot && launchedCounts[i].rootObjects < launchedCounts[0].rootObjects;
+        fewerTests = fewerTests && launchedCounts[i].coarseTests < launchedCounts[0].coarseTests;
+    }
+    check(fewerInRoot, "launched scene: loose trees keep fewer objects in the root");
+    check(fewerTests, "launched scene: loose trees run fewer coarse tests");
+
+    return noFailed ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+/*
+    standalone check of the parallel octree build (not part of the project build, see harness.h to build it)
+    - the same scene is built serially and with 1..N worker threads
+    - every tree is compared node by node with the serial one: bounds, children, object lists (in order),
+        queues, state and the cell of each object
+    - prints the average build time for each number of workers
+    - returns 1 if any tree differs from the serial one
+*/
+
+#include "harness.h"
+
+#include <thread>
+#include <algorithm>
+
+#define NO_OBJECTS 20000
+#define NO_REPEATS 5
+#define MAX_PRINTED 5
+
+// settings of the trees (as in the scene)
+#define WORLD_LIMIT 8192.0f
+
+// create root with the settings of the scene (serial build if threadPool is null)
+static Octree::node* createTree(NodePool* pool, ThreadPool* threadPool) {
+    Octree::node* root = new Octree::node(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    root->pool = pool;
+    root->threadPool = threadPool;
+    root->worldLimit = WORLD_LIMIT;
+    return root;
+}
+
+// free tree
+static void destroyTree(Octree::node* root) {
+    root->destroy();
+    delete root;
+}
+
+// compare node with the node at the same place in the serial tree, returns number of differing nodes
+// (the first MAX_PRINTED are printed with their path of octants from the root)
+static unsigned int compareNodes(Octree::node* serial, Octree::node* parallel, std::string path, unsigned int& printed) {
+    unsigned int ret = 0;
+    bool print = printed < MAX_PRINTED;
+    auto differs = [&](const char* what) -> void {
+        if (print) {
+            if (ret == 0) {
+                printf("    node %s:", path.empty() ? "root" : path.c_str());
+            }
+            printf(" %s", what);
+        }
+        ret = 1;
+    };
+
+    if (serial->region.min != parallel->region.min || serial->region.max != parallel->region.max) {
+        differs("bounds");
+    }
+    if (serial->activeOctants != parallel->activeOctants) {
+        differs("children");
+    }
+    if (serial->treeBuilt != parallel->treeBuilt || serial->treeReady != parallel->treeReady) {
+        differs("state");
+    }
+
+    // objects in the same order (records are added in the same order, so the table indices match)
+    if (serial->objects.size() != parallel->objects.size()
+        || !std::equal(serial->objects.begin(), serial->objects.end(), parallel->objects.begin())) {
+        differs("objects");
+    }
+    if (serial->queue.size() != parallel->queue.size()
+        || !std::equal(serial->queue.begin(), serial->queue.end(), parallel->queue.begin())) {
+        differs("queue");
+    }
+
+    // each object points to the node holding it
+    for (unsigned int idx : parallel->objects) {
+        if (parallel->table->regions[idx].cell != parallel) {
+            differs("cells");
+            break;
+        }
+    }
+
+    if (ret) {
+        // children cannot be matched up anymore
+        if (print) {
+            printf(" differ\n");
+            printed++;
+        }
+        return ret;
+    }
+
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (serial->activeOctants & (1 << i)) {
+            ret += compareNodes(serial->children[i], parallel->children[i], path + (char)('0' + i), printed);
+        }
+    }
+    return ret;
+}
+
+// count nodes of subtree
+static unsigned int countNodes(Octree::node* node) {
+    unsigned int ret = 1;
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (node->activeOctants & (1 << i)) {
+            ret += countNodes(node->children[i]);
+        }
+    }
+    return ret;
+}
+
+// build scene serially and with 1..maxWorkers workers, returns number of trees that differ
+static unsigned int runScene(const char* name, SceneSettings settings, unsigned int maxWorkers) {
+    HarnessScene scene;
+    makeScene(scene, settings);
+    printf("%s (%u objects)\n", name, settings.noObjects);
+
+    // serial reference
+    NodePool serialPool;
+    Octree::node* serial = createTree(&serialPool, nullptr);
+    queueRegions(serial, scene.regions);
+    serial->processPending();
+    printf("    %u nodes\n", countNodes(serial));
+
+    double serialMs = 0.0;
+    for (int i = 0; i < NO_REPEATS; i++) {
+        NodePool pool;
+        Octree::node* tree = createTree(&pool, nullptr);
+        queueRegions(tree, scene.regions);
+        serialMs += timeMs([tree]() { tree->processPending(); });
+        destroyTree(tree);
+    }
+    serialMs /= NO_REPEATS;
+    printf("    serial:    %8.3f ms\n", serialMs);
+
+    unsigned int ret = 0;
+    for (unsigned int noWorkers = 1; noWorkers <= maxWorkers; noWorkers++) {
+        ThreadPool threadPool(noWorkers);
+
+        double parallelMs = 0.0;
+        unsigned int differences = 0;
+        for (int i = 0; i < NO_REPEATS; i++) {
+            NodePool pool;
+            Octree::node* tree = createTree(&pool, &threadPool);
+            queueRegions(tree, scene.regions);
+            parallelMs += timeMs([tree]() { tree->processPending(); });
+
+            // compare the first build (later builds take the same path)
+            if (i == 0) {
+                unsigned int printed = 0;
+                differences = compareNodes(serial, tree, "", printed);
+            }
+            destroyTree(tree);
+        }
+        parallelMs /= NO_REPEATS;
+        printf("    %2u worker%s %8.3f ms (x%.2f)%s\n", noWorkers, noWorkers == 1 ? ": " : "s:",
+            parallelMs, serialMs / parallelMs, differences ? ", DIFFERS from serial" : "");
+
+        if (differences) {
+            ret++;
+        }
+    }
+
+    destroyTree(serial);
+    return ret;
+}
+
+int main() {
+    unsigned int maxWorkers = std::max(4u, std::thread::hardware_concurrency());
+
+    SceneSettings uniform;
+    uniform.noObjects = NO_OBJECTS;
+
+    SceneSettings clustered = uniform;
+    clustered.clustered = 0.5f;
+    clustered.seed = 2;
+
+    // objects outside of the initial root, the root grows before the build
+    SceneSettings spread = uniform;
+    spread.spread = 1000.0f;
+    spread.seed = 3;
+
+    unsigned int differing = runScene("uniform", uniform, maxWorkers)
+        + runScene("half clustered", clustered, maxWorkers)
+        + runScene("spread", spread, maxWorkers);
+
+    check(differing == 0, "every parallel build matches the serial build");
+    return noFailed ? 1 : 0;
+}
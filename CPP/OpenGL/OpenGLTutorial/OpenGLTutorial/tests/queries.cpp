@@ -0,0 +1,216 @@
+/*
+    benchmark of the octree queries against brute force (not part of the project build, see harness.h to build it)
+    - 20000 objects (30% in a cluster), tight and loose octree with the settings of the scene
+    - pair collection, sphere and box queries and k nearest, each compared with testing every object
+    - range queries must not allocate (the results of the batched tests are kept on the stack),
+        counted by replacing the global operator new
+    - queries right after processPending (bounds copies out of date) still match
+    - prints the time of each query in the tree and by brute force
+    - returns 1 if any result differs
+*/
+
+#include "harness.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#define NO_OBJECTS 20000
+#define NO_QUERIES 1000
+#define MAX_RESULTS 4096
+#define K 8
+
+// heap allocations since the start
+static std::atomic<unsigned long> noAllocations(0);
+
+void* operator new(size_t size) {
+    noAllocations++;
+    if (void* ret = malloc(size ? size : 1)) {
+        return ret;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+// get set of instances in results
+static std::set<RigidBody*> instanceSet(BoundingRegion** results, unsigned int noResults) {
+    std::set<RigidBody*> ret;
+    for (unsigned int i = 0; i < noResults; i++) {
+        ret.insert(results[i]->instance);
+    }
+    return ret;
+}
+
+// run benchmark with a tree of the given looseness
+static void runTree(HarnessScene& scene, float looseness) {
+    printf("%s octree, %u objects\n", looseness == 1.0f ? "tight" : "loose", (unsigned int)scene.regions.size());
+
+    NodePool pool;
+    Octree::node* root = new Octree::node(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    root->pool = &pool;
+    root->worldLimit = 8192.0f;
+    root->looseness = looseness;
+    queueRegions(root, scene.regions);
+
+    // every body moved in the first frame
+    std::mt19937 rng(7);
+    moveBodies(scene, rng, 0.0f);
+    double buildMs = timeMs([root]() { root->processPending(); });
+    Box box;
+    double updateMs = timeMs([root, &box]() { root->update(box); });
+    printf("    build %.2f ms, first update %.2f ms\n", buildMs, updateMs);
+
+    /*
+        pairs
+    */
+
+    std::vector<BroadphasePair> pairs;
+    pairs.reserve(1 << 20);
+    double treeMs = timeMs([root, &pairs]() { pairs.clear(); root->collectPairs(pairs); });
+
+    transformRegions(scene.regions);
+    std::set<InstancePair> reference;
+    double bruteMs = timeMs([&scene, &reference]() { reference = bruteForcePairs(scene.regions); });
+
+    unsigned int duplicates = 0;
+    bool same = pairSet(pairs, &duplicates) == reference && !duplicates;
+    printf("    pairs: %u in %.2f ms, brute force %.2f ms\n", (unsigned int)pairs.size(), treeMs, bruteMs);
+    check(same, "pairs match brute force");
+
+    /*
+        range queries
+    */
+
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<glm::vec3> centers;
+    std::vector<float> radii;
+    for (int i = 0; i < NO_QUERIES; i++) {
+        centers.push_back(glm::vec3(unit(rng), unit(rng), unit(rng)) * 100.0f);
+        radii.push_back(2.0f + 8.0f * (unit(rng) + 1.0f));
+    }
+
+    std::vector<BoundingRegion*> results(MAX_RESULTS);
+    unsigned int mismatches = 0, overflows = 0;
+    unsigned long allocationsBefore = noAllocations;
+    double sphereMs = 0.0, boxMs = 0.0, bruteSphereMs = 0.0, bruteBoxMs = 0.0;
+    for (int i = 0; i < NO_QUERIES; i++) {
+        for (int type = 0; type < 2; type++) {
+            unsigned int found = 0;
+            double ms = timeMs([&]() {
+                found = type == 0
+                    ? root->querySphere(centers[i], radii[i], results.data(), MAX_RESULTS)
+                    : root->queryBox(centers[i] - radii[i], centers[i] + radii[i], results.data(), MAX_RESULTS);
+            });
+            (type == 0 ? sphereMs : boxMs) += ms;
+            if (found > MAX_RESULTS) {
+                overflows++;
+                continue;
+            }
+
+            // reference after the timing (the sets allocate)
+            unsigned long allocations = noAllocations;
+            BoundingRegion range = type == 0
+                ? BoundingRegion(centers[i], radii[i])
+                : BoundingRegion(centers[i] - radii[i], centers[i] + radii[i]);
+            std::set<RigidBody*> expected;
+            (type == 0 ? bruteSphereMs : bruteBoxMs) += timeMs([&]() {
+                for (BoundingRegion& br : scene.regions) {
+                    if (range.intersectsWith(br)) {
+                        expected.insert(br.instance);
+                    }
+                }
+            });
+            if (instanceSet(results.data(), found) != expected) {
+                mismatches++;
+            }
+            allocationsBefore += noAllocations - allocations;
+        }
+    }
+    unsigned long queryAllocations = noAllocations - allocationsBefore;
+    printf("    %d sphere queries %.3f ms each (brute force %.3f ms), %d box queries %.3f ms each (brute force %.3f ms), %u over %d results\n",
+        NO_QUERIES, sphereMs / NO_QUERIES, bruteSphereMs / NO_QUERIES, NO_QUERIES, boxMs / NO_QUERIES, bruteBoxMs / NO_QUERIES,
+        overflows, MAX_RESULTS);
+    check(mismatches == 0, "sphere and box queries match brute force");
+    printf("    %lu allocations in the range queries\n", queryAllocations);
+    check(queryAllocations == 0, "range queries do not allocate");
+
+    /*
+        k nearest
+    */
+
+    BoundingRegion* nearest[K];
+    float distances[K];
+    std::vector<float> all(scene.regions.size());
+    mismatches = 0;
+    double nearestMs = 0.0, bruteNearestMs = 0.0;
+    for (int i = 0; i < NO_QUERIES; i++) {
+        unsigned int found = 0;
+        nearestMs += timeMs([&]() { found = root->queryNearest(centers[i], K, nearest, distances); });
+        bruteNearestMs += timeMs([&]() {
+            for (unsigned int j = 0, len = scene.regions.size(); j < len; j++) {
+                all[j] = scene.regions[j].distanceToPoint(centers[i]);
+            }
+            std::partial_sort(all.begin(), all.begin() + K, all.end());
+        });
+        if (found != K || !std::equal(distances, distances + K, all.begin())) {
+            mismatches++;
+        }
+    }
+    printf("    %d nearest %d queries %.3f ms each (brute force %.3f ms)\n", NO_QUERIES, K, nearestMs / NO_QUERIES, bruteNearestMs / NO_QUERIES);
+    check(mismatches == 0, "k nearest distances match brute force");
+
+    /*
+        queries right after processPending, new objects are in nodes whose bounds copies are out of date
+    */
+
+    HarnessScene extra;
+    SceneSettings settings;
+    settings.noObjects = 2000;
+    settings.seed = 11;
+    makeScene(extra, settings);
+    queueRegions(root, extra.regions);
+    root->processPending();
+
+    std::vector<BoundingRegion> combined = scene.regions;
+    combined.insert(combined.end(), extra.regions.begin(), extra.regions.end());
+    mismatches = 0;
+    for (int i = 0; i < NO_QUERIES / 10; i++) {
+        BoundingRegion range(centers[i], radii[i]);
+        unsigned int found = root->queryRange(range, results.data(), MAX_RESULTS);
+        std::set<RigidBody*> expected;
+        for (BoundingRegion& br : combined) {
+            if (range.intersectsWith(br)) {
+                expected.insert(br.instance);
+            }
+        }
+        if (found > MAX_RESULTS || instanceSet(results.data(), found) != expected) {
+            mismatches++;
+        }
+    }
+    check(mismatches == 0, "queries after processPending match brute force");
+
+    root->destroy();
+    delete root;
+}
+
+int main() {
+    HarnessScene scene;
+    SceneSettings settings;
+    settings.noObjects = NO_OBJECTS;
+    settings.spread = 100.0f;
+    settings.clustered = 0.3f;
+    makeScene(scene, settings);
+
+    runTree(scene, 1.0f);
+    runTree(scene, 1.5f);
+
+    return noFailed ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+/*
+    check and benchmark of the ray packets (not part of the project build, see harness.h to build it)
+    - packets of 4 against Ray::intersectsBox and Ray::intersectsBoundingRegion for each ray:
+        random rays toward and away from the region, rays parallel to an axis, and parallel rays with the origin exactly on a slab plane
+        (0 * inf = NaN in the slab test), hit masks and entry distances must be identical
+    - 20000 objects in an octree, a linear octree and a bvh: checkCollisionsRays (packets) against
+        checkCollisionsRay for each ray, same nearest hits, and the time of each
+    - returns 1 if any result differs
+*/
+
+#include "harness.h"
+
+#include "algorithms/raypacket.h"
+#include "algorithms/bvh.h"
+
+#include <cstring>
+
+#define NO_BOXES 2000
+#define NO_RAYS 8192
+#define NO_OBJECTS 20000
+
+// compare packet with each ray on its own against a region, returns number of differing lanes
+static unsigned int comparePacket(Ray* rays, BoundingRegion& br) {
+    RayPacket packet(rays, RAYPACKET_SIZE);
+    float tmin[RAYPACKET_SIZE];
+    unsigned int mask = packet.intersectsBoundingRegion(br, tmin);
+
+    unsigned int ret = 0;
+    for (int i = 0; i < RAYPACKET_SIZE; i++) {
+        float tnear, tfar;
+        bool hit = br.type == BoundTypes::AABB
+            ? rays[i].intersectsBox(br.min, br.max, tnear, tfar)
+            : rays[i].intersectsBoundingRegion(br, tnear, tfar);
+        bool packetHit = (mask >> i) & 1;
+
+        // entry distances bit for bit (NaN never reaches the result)
+        if (hit != packetHit || (hit && memcmp(&tnear, &tmin[i], sizeof(float)))) {
+            ret++;
+        }
+    }
+    return ret;
+}
+
+// compare nearest hits of a structure with packets and with single rays, prints timings
+template <typename T>
+bool compareTree(const char* name, T& tree, std::vector<Ray>& rays) {
+    std::vector<BoundingRegion*> hits;
+    std::vector<float> tmin;
+    double packetMs = timeMs([&]() { tree.checkCollisionsRays(rays, hits, tmin); });
+
+    std::vector<BoundingRegion*> singleHits(rays.size());
+    std::vector<float> singleTmin(rays.size());
+    double singleMs = timeMs([&]() {
+        for (unsigned int i = 0, len = rays.size(); i < len; i++) {
+            singleTmin[i] = std::numeric_limits<float>::max();
+            singleHits[i] = tree.checkCollisionsRay(rays[i], singleTmin[i]);
+        }
+    });
+
+    unsigned int mismatches = 0, noHits = 0;
+    for (unsigned int i = 0, len = rays.size(); i < len; i++) {
+        // same distance, the region may differ between regions entered at the same distance
+        if ((hits[i] == nullptr) != (singleHits[i] == nullptr) || (hits[i] && tmin[i] != singleTmin[i])) {
+            mismatches++;
+        }
+        noHits += singleHits[i] != nullptr;
+    }
+    printf("%-14s %u rays (%u hit): packets %7.3f ms, single rays %7.3f ms (x%.2f)\n",
+        name, (unsigned int)rays.size(), noHits, packetMs, singleMs, singleMs / packetMs);
+
+    char checkName[128];
+    snprintf(checkName, 128, "%s: packets and single rays find the same nearest hits", name);
+    return check(mismatches == 0, checkName);
+}
+
+int main() {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    /*
+        packets against single rays for single regions
+    */
+
+    unsigned int random = 0, behind = 0, parallel = 0, onPlane = 0;
+    for (int b = 0; b < NO_BOXES; b++) {
+        glm::vec3 center(unit(rng) * 10.0f, unit(rng) * 10.0f, unit(rng) * 10.0f);
+        glm::vec3 half(1.0f + unit(rng) * 0.5f, 1.0f + unit(rng) * 0.5f, 1.0f + unit(rng) * 0.5f);
+        BoundingRegion box(center - half, center + half);
+        BoundingRegion sphere(center, half.x);
+
+        for (int k = 0; k < 16; k++) {
+            Ray rays[RAYPACKET_SIZE] = {
+                Ray(glm::vec3(0.0f), glm::vec3(1.0f)), Ray(glm::vec3(0.0f), glm::vec3(1.0f)),
+                Ray(glm::vec3(0.0f), glm::vec3(1.0f)), Ray(glm::vec3(0.0f), glm::vec3(1.0f))
+            };
+
+            // random rays toward the region
+            for (int i = 0; i < RAYPACKET_SIZE; i++) {
+                glm::vec3 origin(unit(rng) * 30.0f, unit(rng) * 30.0f, unit(rng) * 30.0f);
+                rays[i] = Ray(origin, glm::normalize(center + glm::vec3(unit(rng), unit(rng), unit(rng)) * 2.0f - origin));
+            }
+            random += comparePacket(rays, box) + comparePacket(rays, sphere);
+
+            // the same rays pointing away (regions behind the origin are missed)
+            for (int i = 0; i < RAYPACKET_SIZE; i++) {
+                rays[i] = Ray(rays[i].origin, -rays[i].dir);
+            }
+            behind += comparePacket(rays, box) + comparePacket(rays, sphere);
+
+            // parallel to an axis, origins inside or outside of the slabs of the other axes
+            for (int i = 0; i < RAYPACKET_SIZE; i++) {
+                int axis = (k + i) % 3;
+                glm::vec3 origin = center + glm::vec3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+                origin[axis] = center[axis] - 20.0f;
+                glm::vec3 dir(0.0f);
+                dir[axis] = 1.0f;
+                rays[i] = Ray(origin, dir);
+            }
+            parallel += comparePacket(rays, box) + comparePacket(rays, sphere);
+
+            // parallel with the origin on a slab plane of another axis (NaN in the slab test)
+            for (int i = 0; i < RAYPACKET_SIZE; i++) {
+                int axis = (k + i) % 3;
+                int other = (axis + 1 + i % 2) % 3;
+                glm::vec3 origin = center + glm::vec3(unit(rng), unit(rng), unit(rng)) * 0.5f;
+                origin[axis] = center[axis] - 20.0f;
+                origin[other] = (k % 2) ? box.min[other] : box.max[other];
+                glm::vec3 dir(0.0f);
+                dir[axis] = (i % 2) ? 1.0f : -1.0f;
+                if (i == 3) {
+                    // on two slab planes at once
+                    int third = 3 - axis - other;
+                    origin[third] = box.min[third];
+                }
+                rays[i] = Ray(origin, dir);
+            }
+            onPlane += comparePacket(rays, box);
+        }
+    }
+    printf("differing lanes: %u random, %u pointing away, %u parallel to an axis, %u on a slab plane\n", random, behind, parallel, onPlane);
+    check(random == 0 && behind == 0 && parallel == 0 && onPlane == 0, "packets match single rays for every region");
+
+    /*
+        structures
+    */
+
+    HarnessScene scene;
+    SceneSettings settings;
+    settings.noObjects = NO_OBJECTS;
+    settings.clustered = 0.3f;
+    makeScene(scene, settings);
+    std::vector<Ray> rays = randomRays(NO_RAYS, settings.spread, 3);
+
+    // axis aligned rays through the scene as well
+    for (int i = 0; i < NO_RAYS / 8; i++) {
+        glm::vec3 origin(unit(rng) * 100.0f, unit(rng) * 100.0f, -400.0f);
+        rays.push_back(Ray(origin, glm::vec3(0.0f, 0.0f, 1.0f)));
+    }
+
+    NodePool pool;
+    Octree::node* octree = new Octree::node(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    octree->pool = &pool;
+    octree->worldLimit = 8192.0f;
+    queueRegions(octree, scene.regions);
+    octree->processPending();
+    compareTree("octree", *octree, rays);
+    octree->destroy();
+    delete octree;
+
+    Octree::LinearTree linear(BoundingRegion(glm::vec3(-128.0f), glm::vec3(128.0f)));
+    queueRegions(linear, scene.regions);
+    linear.processPending();
+    compareTree("linear octree", linear, rays);
+    linear.destroy();
+
+    BVH bvh(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    queueRegions(bvh, scene.regions);
+    bvh.processPending();
+    compareTree("bvh", bvh, rays);
+    bvh.destroy();
+
+    return noFailed ? 1 : 0;
+}
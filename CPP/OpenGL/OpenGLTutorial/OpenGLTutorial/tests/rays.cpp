@@ -0,0 +1,163 @@
+/*
+    benchmark of single ray queries (not part of the project build, see harness.h to build it)
+    - 20000 objects (30% in a cluster) in a tight and a loose octree, a linear octree and a bvh
+    - rays from outside of the scene, and rays starting between the objects of the cluster (hits are near the origin)
+    - nearest hit distances compared with testing every region
+    - prints nodes visited per ray (rayNodesVisited / raysCast), the nodes of the tree and the time per ray
+    - octrees: nodes are visited front to back and children entered behind the nearest hit are skipped,
+        so no ray may visit more nodes than its line passes through, and fewer overall
+    - returns 1 if any check fails
+*/
+
+#include "harness.h"
+
+#include "algorithms/bvh.h"
+
+#define NO_OBJECTS 20000
+#define NO_RAYS 4000
+
+// count nodes of octree subtree the ray passes through (same test as the traversal)
+static unsigned int countEntered(Octree::node* node, Ray& r) {
+    float tmin, tmax;
+    if (!r.intersectsBoundingRegion(node->looseRegion(), tmin, tmax)) {
+        return 0;
+    }
+
+    unsigned int ret = 1;
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (node->activeOctants & (1 << i)) {
+            ret += countEntered(node->children[i], r);
+        }
+    }
+    return ret;
+}
+
+// cast rays one by one and compare with brute force, prints nodes visited per ray
+template <typename T>
+bool castRays(const char* name, T& tree, std::vector<Ray>& rays, std::vector<BoundingRegion>& regions, std::vector<unsigned int>* visited = nullptr) {
+    tree.stats->reset();
+    tree.collectStats();
+    unsigned int noNodes = tree.stats->noNodes;
+
+    tree.stats->reset();
+    std::vector<float> tmin(rays.size());
+    std::vector<BoundingRegion*> hits(rays.size());
+    double treeMs = 0.0;
+    for (unsigned int i = 0, len = rays.size(); i < len; i++) {
+        unsigned int before = tree.stats->rayNodesVisited;
+        treeMs += timeMs([&]() {
+            tmin[i] = std::numeric_limits<float>::max();
+            hits[i] = tree.checkCollisionsRay(rays[i], tmin[i]);
+        });
+        if (visited) {
+            visited->push_back(tree.stats->rayNodesVisited - before);
+        }
+    }
+    double nodesPerRay = (double)tree.stats->rayNodesVisited / tree.stats->raysCast;
+
+    unsigned int mismatches = 0, noHits = 0;
+    double bruteMs = 0.0;
+    for (unsigned int i = 0, len = rays.size(); i < len; i++) {
+        float bruteTmin;
+        BoundingRegion* bruteHit = nullptr;
+        bruteMs += timeMs([&]() { bruteHit = bruteForceRay(regions, rays[i], bruteTmin); });
+        // same distance, the region may differ between regions entered at the same distance
+        if ((hits[i] == nullptr) != (bruteHit == nullptr) || (bruteHit && tmin[i] != bruteTmin)) {
+            mismatches++;
+        }
+        noHits += bruteHit != nullptr;
+    }
+
+    printf("    %-14s %5u nodes, %7.2f nodes visited per ray, %6.4f ms per ray (brute force %6.4f ms), %u of %u rays hit\n",
+        name, noNodes, nodesPerRay, treeMs / rays.size(), bruteMs / rays.size(), noHits, (unsigned int)rays.size());
+
+    char checkName[128];
+    snprintf(checkName, 128, "%s: nearest hits match brute force", name);
+    return check(mismatches == 0, checkName);
+}
+
+// cast rays into an octree, compare the nodes visited with the nodes each ray passes through
+static void castOctree(const char* name, Octree::node* root, std::vector<Ray>& rays, std::vector<BoundingRegion>& regions) {
+    std::vector<unsigned int> visited;
+    castRays(name, *root, rays, regions, &visited);
+
+    unsigned long noVisited = 0, noEntered = 0;
+    unsigned int overVisited = 0;
+    for (unsigned int i = 0, len = rays.size(); i < len; i++) {
+        unsigned int entered = countEntered(root, rays[i]);
+        noVisited += visited[i];
+        noEntered += entered;
+        if (visited[i] > entered) {
+            overVisited++;
+        }
+    }
+    printf("    %-14s %7.2f nodes passed through per ray\n", "", (double)noEntered / rays.size());
+
+    char checkName[128];
+    snprintf(checkName, 128, "%s: no ray visits a node it does not pass through", name);
+    check(overVisited == 0, checkName);
+    snprintf(checkName, 128, "%s: nodes behind the nearest hit are skipped", name);
+    check(noVisited < noEntered, checkName);
+}
+
+// cast rays into each structure
+static void runRays(const char* name, std::vector<Ray>& rays, HarnessScene& scene) {
+    printf("%s\n", name);
+
+    for (int loose = 0; loose < 2; loose++) {
+        NodePool pool;
+        Octree::node* root = new Octree::node(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+        root->pool = &pool;
+        root->worldLimit = 8192.0f;
+        root->looseness = loose ? 1.5f : 1.0f;
+        queueRegions(root, scene.regions);
+        root->processPending();
+        castOctree(loose ? "loose octree" : "octree", root, rays, scene.regions);
+        root->destroy();
+        delete root;
+    }
+
+    Octree::LinearTree linear(BoundingRegion(glm::vec3(-128.0f), glm::vec3(128.0f)));
+    queueRegions(linear, scene.regions);
+    linear.processPending();
+    castRays("linear octree", linear, rays, scene.regions);
+    linear.destroy();
+
+    BVH bvh(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    queueRegions(bvh, scene.regions);
+    bvh.processPending();
+    castRays("bvh", bvh, rays, scene.regions);
+    bvh.destroy();
+}
+
+int main() {
+    HarnessScene scene;
+    SceneSettings settings;
+    settings.noObjects = NO_OBJECTS;
+    settings.clustered = 0.3f;
+    makeScene(scene, settings);
+
+    std::vector<Ray> outside = randomRays(NO_RAYS, settings.spread, 2);
+    runRays("rays from outside of the scene", outside, scene);
+
+    // from inside the cluster in any direction (origins in a region are drawn again, the nearest hit would be behind them)
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> inside;
+    while (inside.size() < NO_RAYS) {
+        glm::vec3 origin = glm::vec3(unit(rng), unit(rng), unit(rng)) * settings.spread * 0.1f;
+        bool inRegion = false;
+        for (BoundingRegion& br : scene.regions) {
+            if (br.distanceToPoint(origin) <= 0.0f) {
+                inRegion = true;
+                break;
+            }
+        }
+        if (!inRegion) {
+            inside.push_back(Ray(origin, glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)))));
+        }
+    }
+    runRays("rays from inside of the cluster", inside, scene);
+
+    return noFailed ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+/*
+    benchmark of sweep and prune against the octree for low and high motion (not part of the project build, see harness.h to build it)
+    - 4000 and 16000 objects of the default sizes in [-100, 100]
+    - low motion: a tenth of the objects move up to 0.05 per axis each frame (coherent, few endpoint swaps)
+    - medium motion: every object moves up to 0.5 per axis each frame
+    - high motion: every object moves up to 20 per axis each frame (most endpoints swap far)
+    - time per frame of the update and the pair collection of each structure, endpoint swaps per frame
+        and cached pairs of sweep and prune
+    - pairs compared with brute force on the last frame
+    - returns 1 if any pair list differs
+*/
+
+#include "harness.h"
+
+#include "algorithms/sweepandprune.h"
+
+#define NO_FRAMES 10
+
+// movement of the objects in one frame
+struct Motion {
+    const char* name;
+    float distance;
+    // every step-th object moves
+    unsigned int step;
+};
+
+#define NO_MOTIONS 3
+static const Motion MOTIONS[NO_MOTIONS] = {
+    { "low", 0.05f, 10 },
+    { "medium", 0.5f, 1 },
+    { "high", 20.0f, 1 }
+};
+
+// results of one structure
+struct FrameCost {
+    double ms = 0.0;
+    double endpointSwaps = 0.0;
+    unsigned int cachedPairs = 0;
+};
+
+// run frames (update and pairs), compare pairs of the last frame with brute force
+template <typename T>
+FrameCost runFrames(const char* name, T& tree, HarnessScene& scene, Motion motion) {
+    FrameCost ret;
+    tree.processPending();
+
+    // same motion for each structure
+    std::mt19937 rng(6);
+    std::vector<BroadphasePair> pairs;
+    Box box;
+    for (int frame = 0; frame < NO_FRAMES; frame++) {
+        moveBodies(scene, rng, motion.distance, motion.step, frame);
+        tree.stats->reset();
+        ret.ms += timeMs([&]() {
+            box.positions.clear();
+            box.sizes.clear();
+            tree.update(box);
+            pairs.clear();
+            tree.collectPairs(pairs);
+        });
+        ret.endpointSwaps += tree.stats->endpointSwaps;
+    }
+    ret.ms /= NO_FRAMES;
+    ret.endpointSwaps /= NO_FRAMES;
+    tree.stats->reset();
+    tree.collectStats();
+    ret.cachedPairs = tree.stats->cachedPairs;
+
+    transformRegions(scene.regions);
+    unsigned int duplicates = 0;
+    char checkName[128];
+    snprintf(checkName, 128, "%s, %u objects, %s motion: pairs match brute force", name, (unsigned int)scene.regions.size(), motion.name);
+    check(pairSet(pairs, &duplicates) == bruteForcePairs(scene.regions) && !duplicates, checkName);
+
+    return ret;
+}
+
+int main() {
+    for (unsigned int noObjects = 4000; noObjects <= 16000; noObjects *= 4) {
+        SceneSettings settings;
+        settings.noObjects = noObjects;
+        printf("%u objects\n", noObjects);
+
+        FrameCost octree[NO_MOTIONS], sap[NO_MOTIONS];
+        for (int i = 0; i < NO_MOTIONS; i++) {
+            // each structure starts from the same positions
+            HarnessScene scene;
+            makeScene(scene, settings);
+            NodePool pool;
+            Octree::node* root = new Octree::node(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+            root->pool = &pool;
+            root->worldLimit = 8192.0f;
+            queueRegions(root, scene.regions);
+            octree[i] = runFrames("octree", *root, scene, MOTIONS[i]);
+            root->destroy();
+            delete root;
+
+            HarnessScene again;
+            makeScene(again, settings);
+            SweepAndPrune sweep(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+            queueRegions(sweep, again.regions);
+            sap[i] = runFrames("sweep and prune", sweep, again, MOTIONS[i]);
+            sweep.destroy();
+        }
+
+        printf("    %-7s %10s %10s %8s %16s %13s\n", "motion", "moved", "octree ms", "sap ms", "swaps per frame", "cached pairs");
+        for (int i = 0; i < NO_MOTIONS; i++) {
+            printf("    %-7s %10u %10.3f %8.3f %16.0f %13u\n", MOTIONS[i].name, noObjects / MOTIONS[i].step,
+                octree[i].ms, sap[i].ms, sap[i].endpointSwaps, sap[i].cachedPairs);
+        }
+    }
+
+    return noFailed ? 1 : 0;
+}
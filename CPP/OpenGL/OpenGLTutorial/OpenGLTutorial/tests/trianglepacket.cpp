@@ -0,0 +1,240 @@
+/*
+    standalone check of the triangle packet test (not part of the project build)
+    - random triangle pairs (general, small, coplanar, sharing a vertex) are tested with the packet
+        and compared with the previous face test (row reduction) as the reference
+    - the previous test only looked for edges of the other face crossing this face, so it misses
+        faces piercing through each other from the other side; those and pairs within 1e-4 of touching
+        are counted separately, any other difference fails
+    - every packet of 4 must give the same mask as the 4 triangles tested one lane at a time
+    - small triangles parallel to and just off a large one must be separated, not coplanar
+    - prints a checksum of all results, build with and without TRIANGLEPACKET_NO_SIMD and compare it
+    - returns 1 if any check fails
+
+    from the project directory (OpenGLTutorial/OpenGLTutorial):
+    g++ -std=c++17 -O2 -Isrc -I../Linking/include tests/trianglepacket.cpp \
+        src/algorithms/trianglepacket.cpp src/algorithms/math/linalg.cpp -o trianglepacket
+    g++ -std=c++17 -O2 -DTRIANGLEPACKET_NO_SIMD -Isrc -I../Linking/include tests/trianglepacket.cpp \
+        src/algorithms/trianglepacket.cpp src/algorithms/math/linalg.cpp -o trianglepacket_scalar
+*/
+
+#include "algorithms/trianglepacket.h"
+#include "algorithms/math/linalg.h"
+
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define NO_PAIRS 400000
+#define TOUCH_TOLERANCE 1e-4
+
+// previous Face::collidesWithFace with the world space vertices passed in (edges of B against face A)
+static bool oldFaceTest(glm::vec3 A[3], glm::vec3 B[3]) {
+    glm::vec3 P1 = A[0];
+    glm::vec3 P2 = A[1] - P1;
+    glm::vec3 P3 = A[2] - P1;
+    glm::vec3 lines[3] = { P2, P3, P3 - P2 };
+    glm::vec3 thisNorm = glm::cross(A[1] - A[0], A[2] - A[0]);
+
+    glm::vec3 U1 = B[0] - P1, U2 = B[1] - P1, U3 = B[2] - P1;
+    P1 = glm::vec3(0.0f);
+
+    glm::vec3 sideOrigins[3] = { U1, U1, U2 };
+    glm::vec3 sides[3] = { U2 - U1, U3 - U1, U3 - U2 };
+
+    for (unsigned int i = 0; i < 3; i++) {
+        float t = 0.0f;
+        switch (linePlaneIntersection(P1, thisNorm, sideOrigins[i], sides[i], t)) {
+        case LinePlaneIntCase::CASE0:
+            // side in the plane, intersect with each line of the face
+            for (int j = 0; j < 3; j++) {
+                glm::mat3 m(lines[j], -1.0f * sides[i], sideOrigins[i]);
+                rref(m);
+                if (m[2][2] != 0.0f) {
+                    continue;
+                }
+                float c1 = m[2][0], c2 = m[2][1];
+                if (0.0f <= c1 && c1 <= 1.0f && 0.0f <= c2 && c2 <= 1.0f) {
+                    return true;
+                }
+            }
+            return false;
+        case LinePlaneIntCase::CASE2:
+            if (faceContainsPoint(P2, P3, thisNorm, sideOrigins[i] + t * sides[i])) {
+                return true;
+            }
+            continue;
+        default:
+            continue;
+        };
+    }
+
+    return false;
+}
+
+// determine if segment ab crosses triangle T in double precision (eps widens or narrows the triangle)
+static bool segmentCrossesTriangle(glm::dvec3 a, glm::dvec3 b, glm::dvec3 T[3], double eps) {
+    glm::dvec3 d = b - a, e1 = T[1] - T[0], e2 = T[2] - T[0];
+    glm::dvec3 p = glm::cross(d, e2);
+    double det = glm::dot(e1, p);
+    if (std::fabs(det) < 1e-18) {
+        return false;
+    }
+
+    glm::dvec3 tv = a - T[0];
+    double u = glm::dot(tv, p) / det;
+    if (u < -eps || u > 1.0 + eps) {
+        return false;
+    }
+    glm::dvec3 q = glm::cross(tv, e1);
+    double v = glm::dot(d, q) / det;
+    if (v < -eps || u + v > 1.0 + eps) {
+        return false;
+    }
+    double t = glm::dot(e2, q) / det;
+    return t >= -eps && t <= 1.0 + eps;
+}
+
+// determine if an edge of B crosses A
+static bool edgeOfBCrossesA(glm::vec3 A[3], glm::vec3 B[3], double eps) {
+    glm::dvec3 T[3] = { A[0], A[1], A[2] };
+    for (int i = 0; i < 3; i++) {
+        if (segmentCrossesTriangle(B[i], B[(i + 1) % 3], T, eps)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main() {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    auto randomVec = [&]() { return glm::vec3(dist(rng), dist(rng), dist(rng)); };
+
+    // pairs: A at 6k, B at 6k + 3
+    std::vector<glm::vec3> tris(6 * NO_PAIRS);
+    for (int k = 0; k < NO_PAIRS; k++) {
+        int kind = k % 4;
+        glm::vec3* A = &tris[6 * k];
+        glm::vec3* B = A + 3;
+        for (int i = 0; i < 3; i++) {
+            A[i] = randomVec();
+            B[i] = kind == 1 ? randomVec() * 0.3f + randomVec() * 0.5f : randomVec();
+        }
+        if (kind == 2) {
+            // coplanar in z = 0.25
+            for (int i = 0; i < 3; i++) {
+                A[i].z = B[i].z = 0.25f;
+            }
+        }
+        else if (kind == 3) {
+            // touching at a vertex
+            B[0] = A[k % 3];
+        }
+    }
+
+    /*
+        single lanes against the previous test
+    */
+
+    int agree = 0, newOnlyPierce = 0, oldOnlyTouch = 0, newOnlyTouch = 0, unexplained = 0;
+    unsigned long long checksum = 0;
+    for (int k = 0; k < NO_PAIRS; k++) {
+        glm::vec3* A = &tris[6 * k];
+        glm::vec3* B = A + 3;
+
+        TrianglePacket packet(B, 1);
+        bool hit = packet.intersectsTriangle(A[0], A[1], A[2]) != 0;
+        bool oldHit = oldFaceTest(A, B);
+        checksum = checksum * 1099511628211ull + (hit ? 1 : 2);
+
+        if (hit == oldHit) {
+            agree++;
+        }
+        else if (hit && (k % 4 == 2 || edgeOfBCrossesA(B, A, 0.0))) {
+            // coplanar overlap or A piercing B, the previous test did not look for either
+            newOnlyPierce++;
+        }
+        else if (oldHit && !edgeOfBCrossesA(A, B, -TOUCH_TOLERANCE)) {
+            oldOnlyTouch++;
+        }
+        else if (hit && (edgeOfBCrossesA(A, B, TOUCH_TOLERANCE) || edgeOfBCrossesA(B, A, TOUCH_TOLERANCE))) {
+            newOnlyTouch++;
+        }
+        else {
+            unexplained++;
+            if (unexplained <= 5) {
+                printf("mismatch (kind %d): packet %d, previous %d\n", k % 4, hit, oldHit);
+                for (int i = 0; i < 3; i++) {
+                    printf("    A %.9g %.9g %.9g    B %.9g %.9g %.9g\n",
+                        A[i].x, A[i].y, A[i].z, B[i].x, B[i].y, B[i].z);
+                }
+            }
+        }
+    }
+    printf("%d pairs: %d agree, %d only hit by the packet (piercing or coplanar), %d/%d differ within %g of touching, %d unexplained\n",
+        NO_PAIRS, agree, newOnlyPierce, oldOnlyTouch, newOnlyTouch, TOUCH_TOLERANCE, unexplained);
+
+    /*
+        packets of 4 against single lanes
+    */
+
+    int laneMismatches = 0;
+    for (int k = 0; k + 4 <= NO_PAIRS; k += 4) {
+        glm::vec3 U[3 * TRIANGLEPACKET_SIZE];
+        for (int j = 0; j < 4; j++) {
+            for (int i = 0; i < 3; i++) {
+                U[3 * j + i] = tris[6 * (k + j) + 3 + i];
+            }
+        }
+        glm::vec3* A = &tris[6 * k];
+
+        TrianglePacket packet(U, 4);
+        unsigned int mask = packet.intersectsTriangle(A[0], A[1], A[2]);
+        checksum = checksum * 1099511628211ull + mask;
+        for (int j = 0; j < 4; j++) {
+            TrianglePacket single(&U[3 * j], 1);
+            bool hit = single.intersectsTriangle(A[0], A[1], A[2]) != 0;
+            if (hit != (bool)(mask & (1 << j))) {
+                laneMismatches++;
+            }
+        }
+    }
+    printf("packets of 4 against single lanes: %d mismatches\n", laneMismatches);
+
+    /*
+        small triangles just off the plane of a large one
+        - within the tolerance of the large plane (so in it), but the large triangle is beyond
+            the tolerance of the small planes, so they are separated and must not be tested as coplanar
+    */
+
+    int offPlaneHits = 0;
+    glm::vec3 large[3] = { glm::vec3(-100.0f, -100.0f, 0.0f), glm::vec3(100.0f, -100.0f, 0.0f), glm::vec3(0.0f, 100.0f, 0.0f) };
+    for (int k = 0; k < NO_PAIRS / 100; k++) {
+        glm::vec3 U[3 * TRIANGLEPACKET_SIZE];
+        for (int j = 0; j < 4; j++) {
+            glm::vec3 center(dist(rng) * 20.0f, dist(rng) * 20.0f, dist(rng) < 0.0f ? -1e-5f : 1e-5f);
+            for (int i = 0; i < 3; i++) {
+                U[3 * j + i] = center + glm::vec3(dist(rng), dist(rng), 0.0f);
+            }
+        }
+
+        TrianglePacket packet(U, 4);
+        unsigned int mask = packet.intersectsTriangle(large[0], large[1], large[2]);
+        checksum = checksum * 1099511628211ull + mask;
+        for (int j = 0; j < 4; j++) {
+            if (mask & (1 << j)) {
+                offPlaneHits++;
+            }
+        }
+    }
+    printf("small triangles off the plane of a large one: %d hits (expected 0)\n", offPlaneHits);
+
+#ifdef TRIANGLEPACKET_SIMD
+    printf("checksum (SSE): %016llx\n", checksum);
+#else
+    printf("checksum (scalar): %016llx\n", checksum);
+#endif
+
+    return unexplained || laneMismatches || offPlaneHits ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+/*
+    benchmark of the growing octree root with objects spread over kilometres (not part of the project build, see harness.h to build it)
+    - 20000 objects in [-2000, 2000] m on each axis, a root fixed to [-16, 16] (objects outside stay queued)
+        against a root that grows toward them, build and update time and queue work per frame
+    - bodies launched kilometres away from a built tree, so the root grows during the update:
+        no subtree may count fewer objects than its children right after the update (the parent merges
+        subtrees that look empty), pairs must match brute force
+    - objects beyond the world limit stay queued without growing the root
+    - returns 1 if any check fails
+*/
+
+#include "harness.h"
+
+#define NO_OBJECTS 20000
+#define NO_FRAMES 10
+#define WORLD_LIMIT 8192.0f
+
+// count nodes of subtree whose object count is below the counts of their children together
+// (objects inserted after a node was updated are only counted in the next update, so counts can only lag behind)
+static unsigned int countWrong(Octree::node* node) {
+    unsigned int ret = 0, childObjects = 0;
+    for (int i = 0; i < NO_CHILDREN; i++) {
+        if (node->activeOctants & (1 << i)) {
+            childObjects += node->children[i]->subtreeObjects;
+            ret += countWrong(node->children[i]);
+        }
+    }
+    return ret + (node->subtreeObjects < childObjects ? 1 : 0);
+}
+
+// create root at [-16, 16] that grows up to worldLimit (fixed if 0)
+static Octree::node* createTree(NodePool* pool, float worldLimit) {
+    Octree::node* root = new Octree::node(BoundingRegion(glm::vec3(-16.0f), glm::vec3(16.0f)));
+    root->pool = pool;
+    root->worldLimit = worldLimit;
+    return root;
+}
+
+// free tree
+static void destroyTree(Octree::node* root) {
+    root->destroy();
+    delete root;
+}
+
+// run frames with a fixed or growing root, prints the time and queue work
+static void runSpread(HarnessScene& scene, const char* name, float worldLimit) {
+    NodePool pool;
+    Octree::node* root = createTree(&pool, worldLimit);
+    queueRegions(root, scene.regions);
+    double buildMs = timeMs([root]() { root->processPending(); });
+
+    std::mt19937 rng(2);
+    double updateMs = 0.0;
+    unsigned long pending = 0;
+    Box box;
+    for (int frame = 0; frame < NO_FRAMES; frame++) {
+        // a tenth of the bodies move each frame
+        moveBodies(scene, rng, 1.0f, 10, frame);
+        root->stats->reset();
+        updateMs += timeMs([root, &box]() { root->update(box); });
+        pending += root->stats->pendingProcessed;
+    }
+
+    root->stats->reset();
+    root->collectStats();
+    glm::vec3 dimensions = root->region.calculateDimensions();
+    printf("    %-12s root %6.0f m, %5u nodes, %5u queued, build %7.2f ms, update %6.2f ms, %7.0f taken from queues per frame\n",
+        name, dimensions.x, root->stats->noNodes, root->stats->noQueued, buildMs, updateMs / NO_FRAMES, (double)pending / NO_FRAMES);
+
+    if (worldLimit > 0.0f) {
+        check(root->stats->noQueued == 0, "growing root: no object left in a queue");
+        check(pending <= NO_FRAMES * scene.regions.size() / 10, "growing root: only moved objects are taken from queues");
+
+        transformRegions(scene.regions);
+        std::vector<BroadphasePair> pairs;
+        root->collectPairs(pairs);
+        unsigned int duplicates = 0;
+        check(pairSet(pairs, &duplicates) == bruteForcePairs(scene.regions) && !duplicates, "growing root: pairs match brute force");
+    }
+    else {
+        check(pending >= NO_FRAMES * root->stats->noQueued, "fixed root: objects outside are taken from the queue every frame");
+    }
+
+    destroyTree(root);
+}
+
+int main() {
+    /*
+        objects spread over kilometres
+    */
+
+    HarnessScene spread;
+    SceneSettings settings;
+    settings.noObjects = NO_OBJECTS;
+    settings.spread = 2000.0f;
+    settings.clustered = 0.2f;
+    makeScene(spread, settings);
+
+    printf("%u objects in [-%.0f, %.0f] m (%.0f%% within %.0f m of the origin)\n",
+        settings.noObjects, settings.spread, settings.spread, settings.clustered * 100.0f, settings.spread * 0.1f);
+    runSpread(spread, "fixed root", 0.0f);
+    runSpread(spread, "growing root", WORLD_LIMIT);
+
+    /*
+        bodies launched out of a built tree
+    */
+
+    HarnessScene launched;
+    settings.noObjects = 4000;
+    settings.spread = 12.0f;
+    settings.clustered = 0.0f;
+    settings.seed = 3;
+    makeScene(launched, settings);
+
+    NodePool pool;
+    Octree::node* root = createTree(&pool, WORLD_LIMIT);
+    queueRegions(root, launched.regions);
+    root->processPending();
+
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    unsigned int noWrong = 0, growths = 0;
+    Box box;
+    for (int frame = 0; frame < NO_FRAMES; frame++) {
+        // one body in a hundred jumps up to 2 km away, the rest drift
+        moveBodies(launched, rng, 0.1f);
+        for (unsigned int i = frame, len = launched.bodies.size(); i < len; i += 100) {
+            launched.bodies[i]->pos = glm::vec3(unit(rng), unit(rng), unit(rng)) * 2000.0f;
+        }
+
+        root->stats->reset();
+        root->update(box);
+        growths += root->stats->rootGrowths;
+        noWrong += countWrong(root);
+    }
+
+    glm::vec3 dimensions = root->region.calculateDimensions();
+    printf("launched bodies: root grew %u times to %.0f m in %d frames\n", growths, dimensions.x, NO_FRAMES);
+    check(growths > 0, "launched bodies: root grows during the update");
+    check(noWrong == 0, "launched bodies: no subtree counts fewer objects than its children after growing");
+
+    transformRegions(launched.regions);
+    std::vector<BroadphasePair> pairs;
+    root->collectPairs(pairs);
+    unsigned int duplicates = 0;
+    check(pairSet(pairs, &duplicates) == bruteForcePairs(launched.regions) && !duplicates, "launched bodies: pairs match brute force");
+
+    /*
+        beyond the world limit
+    */
+
+    for (unsigned int i = 0; i < 10; i++) {
+        launched.bodies[i]->pos = glm::vec3(20000.0f + i, 0.0f, 0.0f);
+        States::activate(&launched.bodies[i]->state, INSTANCE_MOVED);
+    }
+    for (unsigned int i = 10, len = launched.bodies.size(); i < len; i++) {
+        States::deactivate(&launched.bodies[i]->state, INSTANCE_MOVED);
+    }
+    root->update(box);
+    root->update(box);
+
+    root->stats->reset();
+    root->collectStats();
+    glm::vec3 limited = root->region.calculateDimensions();
+    check(root->stats->noQueued == 10 && limited.x <= WORLD_LIMIT, "beyond the world limit: objects stay queued, root stays within the limit");
+
+    destroyTree(root);
+    return noFailed ? 1 : 0;
+}
@@ -0,0 +1,202 @@
+/*
+    benchmark of the world space mesh cache (not part of the project build, see harness.h to build it)
+    - brick walls (boxes with gaps, so the wall is concave and goes through the face hierarchy) of 4x4 to 32x16 bricks
+        against a sphere mesh and against a sphere region, with the sphere placed at the wall or just in front of it
+    - each test with the wall cached (only the moving sphere is transformed) and with the wall transformed again
+        for every test (the cost without a cache, every point instead of only the faces that are reached)
+    - results must be the same either way
+    - a reference to a world mesh must stay valid after more meshes are added to the instance
+    - returns 1 if any check fails
+*/
+
+#include "harness.h"
+
+#include "physics/collisionmesh.h"
+
+#include <cstring>
+
+#define NO_TESTS 2000
+#define NO_MESHES 8
+
+// size of a brick and gap between bricks
+#define BRICK_SIZE glm::vec3(0.2f, 0.1f, 0.1f)
+#define BRICK_GAP 0.01f
+
+// result of one test
+struct TestResult {
+    bool hit;
+    glm::vec3 norm;
+    float depth;
+    glm::vec3 point;
+
+    bool operator==(const TestResult& r) const {
+        return hit == r.hit && (!hit || (!memcmp(&norm, &r.norm, sizeof(glm::vec3))
+            && depth == r.depth && !memcmp(&point, &r.point, sizeof(glm::vec3))));
+    }
+};
+
+// wall of boxes in the xy plane from the origin, front face at z = 0
+static CollisionMesh* makeWall(unsigned int bricksX, unsigned int bricksY) {
+    std::vector<float> coordinates;
+    std::vector<unsigned int> indices;
+    // faces of a box with corners numbered by bits (x, y, z), wound outward
+    static const unsigned int boxFaces[36] = {
+        0, 2, 1, 1, 2, 3, // -z
+        4, 5, 6, 5, 7, 6, // +z
+        0, 1, 4, 1, 5, 4, // -y
+        2, 6, 3, 3, 6, 7, // +y
+        0, 4, 2, 2, 4, 6, // -x
+        1, 3, 5, 3, 7, 5  // +x
+    };
+
+    glm::vec3 step = BRICK_SIZE + glm::vec3(BRICK_GAP);
+    for (unsigned int y = 0; y < bricksY; y++) {
+        for (unsigned int x = 0; x < bricksX; x++) {
+            // every other row shifted by half a brick
+            glm::vec3 min(x * step.x + (y % 2) * 0.5f * step.x, y * step.y, -BRICK_SIZE.z);
+            unsigned int first = coordinates.size() / 3;
+            for (unsigned int corner = 0; corner < 8; corner++) {
+                coordinates.push_back(min.x + ((corner & 1) ? BRICK_SIZE.x : 0.0f));
+                coordinates.push_back(min.y + ((corner & 2) ? BRICK_SIZE.y : 0.0f));
+                coordinates.push_back(min.z + ((corner & 4) ? BRICK_SIZE.z : 0.0f));
+            }
+            for (unsigned int i = 0; i < 36; i++) {
+                indices.push_back(first + boxFaces[i]);
+            }
+        }
+    }
+
+    return new CollisionMesh(coordinates.size() / 3, coordinates.data(), indices.size() / 3, indices.data());
+}
+
+// uv sphere of radius 1 with noRings rings and 2 * noRings segments
+static CollisionMesh* makeSphere(unsigned int noRings) {
+    std::vector<float> coordinates;
+    std::vector<unsigned int> indices;
+    unsigned int noSegments = 2 * noRings;
+    for (unsigned int i = 0; i <= noRings; i++) {
+        float theta = glm::pi<float>() * i / noRings;
+        for (unsigned int j = 0; j <= noSegments; j++) {
+            float phi = 2.0f * glm::pi<float>() * j / noSegments;
+            coordinates.push_back(sinf(theta) * cosf(phi));
+            coordinates.push_back(cosf(theta));
+            coordinates.push_back(sinf(theta) * sinf(phi));
+        }
+    }
+    for (unsigned int i = 0; i < noRings; i++) {
+        for (unsigned int j = 0; j < noSegments; j++) {
+            unsigned int a = i * (noSegments + 1) + j, b = a + 1, c = a + noSegments + 1, d = c + 1;
+            indices.insert(indices.end(), { a, c, d, a, d, b });
+        }
+    }
+
+    return new CollisionMesh(coordinates.size() / 3, coordinates.data(), indices.size() / 3, indices.data());
+}
+
+// run the tests against a wall, cached or transforming the wall for every test (results added to results)
+static double runTests(CollisionMesh* wall, RigidBody& wallRB, CollisionMesh* sphere, RigidBody& sphereRB,
+    std::vector<glm::vec3>& positions, bool withMesh, bool cached, std::vector<TestResult>& results) {
+    double ret = 0.0;
+    for (glm::vec3& pos : positions) {
+        // the sphere moves for every test
+        sphereRB.pos = pos;
+        sphereRB.update(0.0f);
+        if (!cached) {
+            wallRB.update(0.0f);
+        }
+
+        BoundingRegion br(pos, sphereRB.size.x);
+        TestResult r;
+        ret += timeMs([&]() {
+            r.hit = withMesh
+                ? wall->collidesWithMesh(&wallRB, sphere, &sphereRB, r.norm, r.depth, r.point)
+                : wall->collidesWithSphere(&wallRB, br, r.norm, r.depth, r.point);
+        });
+        results.push_back(r);
+    }
+    return ret;
+}
+
+int main() {
+    CollisionMesh* sphere = makeSphere(12);
+    printf("sphere mesh: %u points, %u faces, %s\n", (unsigned int)sphere->points.size(), (unsigned int)sphere->faces.size(),
+        sphere->convex ? "convex" : "concave");
+
+    /*
+        walls of each size
+    */
+
+    unsigned int wallSizes[3][2] = { { 4, 4 }, { 16, 8 }, { 32, 16 } };
+    printf("    %-8s %7s %7s %-12s %10s %12s %9s %6s\n", "wall", "points", "faces", "against", "cached ms", "uncached ms", "speedup", "hits");
+    for (int w = 0; w < 3; w++) {
+        CollisionMesh* wall = makeWall(wallSizes[w][0], wallSizes[w][1]);
+        RigidBody wallRB("wall");
+        RigidBody sphereRB("sphere", glm::vec3(0.15f));
+
+        // positions at the front of the wall, some touching and some just in front of it
+        // (the region of a mesh is a sphere, so the extent comes from the points)
+        glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+        for (glm::vec3& p : wall->points) {
+            min = glm::min(min, p);
+            max = glm::max(max, p);
+        }
+        glm::vec3 extent = max - min;
+        std::mt19937 rng(w + 1);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<glm::vec3> positions;
+        for (int i = 0; i < NO_TESTS; i++) {
+            positions.push_back(glm::vec3(min.x + unit(rng) * extent.x, min.y + unit(rng) * extent.y,
+                sphereRB.size.x * (2.0f * unit(rng) - 0.5f)));
+        }
+
+        for (int withMesh = 1; withMesh >= 0; withMesh--) {
+            std::vector<TestResult> cachedResults, uncachedResults;
+            // warm up, then cached (the wall does not move) and transformed for each test
+            runTests(wall, wallRB, sphere, sphereRB, positions, withMesh, true, cachedResults);
+            cachedResults.clear();
+            double cachedMs = runTests(wall, wallRB, sphere, sphereRB, positions, withMesh, true, cachedResults);
+            double uncachedMs = runTests(wall, wallRB, sphere, sphereRB, positions, withMesh, false, uncachedResults);
+
+            unsigned int noHits = 0;
+            for (TestResult& r : cachedResults) {
+                noHits += r.hit;
+            }
+
+            char name[32];
+            snprintf(name, 32, "%ux%u", wallSizes[w][0], wallSizes[w][1]);
+            printf("    %-8s %7u %7u %-12s %10.4f %12.4f %8.2fx %6u\n", name, (unsigned int)wall->points.size(),
+                (unsigned int)wall->faces.size(), withMesh ? "sphere mesh" : "sphere", cachedMs / NO_TESTS, uncachedMs / NO_TESTS,
+                uncachedMs / cachedMs, noHits);
+
+            char checkName[128];
+            snprintf(checkName, 128, "%s wall against %s: same results with and without the cache", name, withMesh ? "sphere mesh" : "sphere");
+            check(cachedResults == uncachedResults && noHits > 0, checkName);
+        }
+
+        delete wall;
+    }
+
+    /*
+        references to world meshes while meshes are added
+    */
+
+    RigidBody rb("meshes");
+    std::vector<CollisionMesh*> meshes;
+    for (int i = 0; i < NO_MESHES; i++) {
+        meshes.push_back(makeSphere(4 + i));
+    }
+    WorldMesh& first = rb.getWorldMesh(meshes[0]);
+    glm::vec3 firstPoint = first.points[0];
+    for (int i = 1; i < NO_MESHES; i++) {
+        rb.getWorldMesh(meshes[i]);
+    }
+    check(&first == &rb.getWorldMesh(meshes[0]) && first.mesh == meshes[0] && first.points[0] == firstPoint,
+        "world mesh reference stays valid after adding meshes");
+
+    for (CollisionMesh* mesh : meshes) {
+        delete mesh;
+    }
+    delete sphere;
+
+    return noFailed ? 1 : 0;
+}